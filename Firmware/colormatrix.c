@@ -106,4 +106,5 @@ void update_colormatrix(void) {
   VIDEOIF->yb_yg_factor     = (matrix.yb_factor  << 16) | (uint16_t)matrix.yg_factor;
   VIDEOIF->cbb_cbg_factor   = (matrix.cbb_factor << 16) | (uint16_t)matrix.cbg_factor;
   VIDEOIF->crg_crr_factor   = (matrix.crg_factor << 16) | (uint16_t)matrix.crr_factor;
+  VIDEOIF->commit           = 1;
 }
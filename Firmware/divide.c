@@ -0,0 +1,89 @@
+/* GCVideo DVI Firmware
+
+   Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+   THE POSSIBILITY OF SUCH DAMAGE.
+
+
+   divide.c: Unsigned division helpers for the hardware divider
+
+*/
+
+/* The CPU implements signed div/mod in hardware, but gcc calls these */
+/* libgcc functions for unsigned division. Replacing them allows the  */
+/* common case of operands below 2^31 to use the hardware divider.    */
+/* The opcodes are issued by hw_div/hw_mod in crt0-bsd.S, a plain     */
+/* signed division here could be turned back into a libcall by gcc.   */
+
+unsigned int __udivsi3(unsigned int a, unsigned int b);
+unsigned int __umodsi3(unsigned int a, unsigned int b);
+int hw_div(int a, int b);
+int hw_mod(int a, int b);
+
+static unsigned int udivmod(unsigned int a, unsigned int b, unsigned int *rem) {
+  unsigned int quot = 0;
+  unsigned int bit  = 1;
+
+  /* same result as the hardware divider instead of an endless loop */
+  if (b == 0) {
+    *rem = a;
+    return 0xffffffffU;
+  }
+
+  /* plain shift-and-subtract for large values */
+  while (b < a && !(b & 0x80000000U)) {
+    b   <<= 1;
+    bit <<= 1;
+  }
+
+  while (bit) {
+    if (a >= b) {
+      a    -= b;
+      quot |= bit;
+    }
+    b   >>= 1;
+    bit >>= 1;
+  }
+
+  *rem = a;
+  return quot;
+}
+
+unsigned int __udivsi3(unsigned int a, unsigned int b) {
+  unsigned int rem;
+
+  if ((int)a >= 0 && (int)b > 0)
+    return hw_div(a, b);
+
+  return udivmod(a, b, &rem);
+}
+
+unsigned int __umodsi3(unsigned int a, unsigned int b) {
+  unsigned int rem;
+
+  if ((int)a >= 0 && (int)b > 0)
+    return hw_mod(a, b);
+
+  udivmod(a, b, &rem);
+  return rem;
+}
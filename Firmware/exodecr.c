@@ -26,6 +26,8 @@
  * Taken from exomizer-3.0.2, slightly modified by Ingo Korb:
  * 1) avoid "might be used uninitialized" warnings in gcc 3.4.2
  * 2) add an output buffer size to exo_decrunch and enforce it
+ * 3) add an input buffer size and reject out-of-range table indices
+ *    and back-references
  */
 
 #include <stdlib.h>  /* needed for NULL macro -ik */
@@ -34,6 +36,8 @@
 static unsigned short int base[52];
 static char bits[52];
 static unsigned char bit_buffer;
+static const char *in_limit;    /* check input size -ik */
+static char in_error;           /* check input size -ik */
 
 static int bitbuffer_rotate(int carry)
 {
@@ -50,7 +54,13 @@ static int bitbuffer_rotate(int carry)
 
 static unsigned char read_byte(const char **inp)
 {
-    unsigned char val = *--(*inp) & 0xff;
+    unsigned char val;
+    if (*inp == in_limit)       /* check input size -ik */
+    {                           /* check input size -ik */
+        in_error = 1;           /* check input size -ik */
+        return 0;               /* check input size -ik */
+    }                           /* check input size -ik */
+    val = *--(*inp) & 0xff;
     return val;
 }
 
@@ -104,13 +114,18 @@ init_table(const char **inp)
 }
 
 char *
-exo_decrunch(const char *in, char *out, unsigned int outsize)
+exo_decrunch(const char *in, unsigned int insize,
+             char *out, unsigned int outsize)
 {
     unsigned short int index;
     unsigned short int length;
     unsigned short int offset = 0; /* added init -ik */
     char c;
     char literal = 1; /* added init -ik */
+    const char *out_end = out; /* check offsets -ik */
+
+    in_limit = in - insize;    /* check input size -ik */
+    in_error = 0;              /* check input size -ik */
 
     bit_buffer = read_byte(&in);
 
@@ -131,6 +146,8 @@ exo_decrunch(const char *in, char *out, unsigned int outsize)
         while(read_bits(&in, 1) == 0)
         {
             ++index;
+            if (index > 17)     /* check table index -ik */
+                return NULL;    /* check table index -ik */
         }
         if(index == 16)
         {
@@ -172,13 +189,19 @@ exo_decrunch(const char *in, char *out, unsigned int outsize)
             }
             else
             {
+                if (offset >= out_end - out) /* check offsets -ik */
+                    return NULL;             /* check offsets -ik */
                 c = out[offset];
             }
             if (outsize-- == 0) /* check output size -ik */
                 return NULL;    /* check output size -ik */
+            if (in_error)       /* check input size -ik */
+                return NULL;    /* check input size -ik */
             *out = c;
         }
         while(--length > 0);
     }
+    if (in_error)               /* check input size -ik */
+        return NULL;            /* check input size -ik */
     return out;
 }
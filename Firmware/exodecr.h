@@ -29,8 +29,11 @@
  * Taken from exomizer-3.0.2, slightly modified by Ingo Korb:
  * 1) avoid "might be used uninitialized" warnings in gcc 3.4.2
  * 2) add an output buffer size to exo_decrunch and enforce it
+ * 3) add an input buffer size and reject out-of-range table indices
+ *    and back-references
 */
 
-char *exo_decrunch(const char *in, char *out, unsigned int outsize);
+char *exo_decrunch(const char *in, unsigned int insize,
+                   char *out, unsigned int outsize);
 
 #endif /* EXO_DECRUNCH_ALREADY_INCLUDED */
@@ -164,6 +164,11 @@ static void check_test_line(void) {
   osd_clearline(9, ATTRIB_DIM_BG);
   osd_putsat(2, 9, "Unexpected bits: ");
   print_bitmask(mismatches);
+
+  /* this screen runs from flash, show what it costs */
+  osd_clearline(14, ATTRIB_DIM_BG);
+  osd_gotoxy(2, 14);
+  printf("Flash cache: %u hits, %u misses", FLASHCACHE->hits, FLASHCACHE->misses);
 }
 
 void flasher_diag(void) {
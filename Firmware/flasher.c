@@ -31,32 +31,38 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
-#include "crc32mpeg.h"
-#include "exodecr.h"
 #include "flasher-diag.h"
 #include "flashviewer.h"
 #include "icap.h"
+#include "irq.h"
 #include "menu-lite.h"
 #include "osd.h"
 #include "pad.h"
 #include "portdefs.h"
 #include "screens.h"
+#include "settings.h"
 #include "spiflash.h"
+#include "updateline.h"
 #include "vsync.h"
 #include "flasher.h"
 
 #define HARDWARE_ID_ADDRESS 0x2fff0
 #define HARDWARE_ID_LENGTH  16
-#define MAIN_APP_ADDRESS    0x30000
 #define FLASH_SIZE          0x80000
 #define ERASE_BLOCK_SIZE    0x10000
+#define ERASE_BLOCKS        ((FLASH_SIZE - MAIN_APP_ADDRESS) / ERASE_BLOCK_SIZE)
+#define IMAGE_BLOCKS        (MAIN_APP_SIZE / ERASE_BLOCK_SIZE)
 #define SPI_READ_CMD        0x03 // the only supported command by some early M25P40
-#define INFO_PAGE           0x10
-#define INFO_LINE           0
-#define RNG_MULT            1103515245
-#define RNG_ADD             12345
-#define RNG_MOD             (1 << 31)
-#define RNG_SHIFT           8
+
+#if MAIN_APP_ADDRESS + MAIN_APP_SIZE != SETTINGS_OFFSET
+#  error "MAIN_APP_SIZE in flasher.h does not match SETTINGS_OFFSET"
+#endif
+
+/* the last page of the main XIP area (see fwtagger-main.pl) is never part */
+/* of an image, so every update erases it together with the old image      */
+#define MARKER_ADDRESS      0x6ff00
+#define MARKER_MAGIC        0x47435649 // GCVI
+#define MARKER_SLOTS        (256 / sizeof(installmarker_t))
 
 static const char updater_signature[12] = "GCVUpdater10";
 
@@ -67,12 +73,33 @@ typedef struct {
   char     version[8];
 } imageheader_t;
 
+/* written after the CRC of an installed image has been checked, */
+/* revoked slots have their magic cleared to zero                  */
+typedef struct {
+  uint32_t magic;
+  uint32_t sequence;
+  uint32_t length;
+  uint32_t crc;
+} installmarker_t;
+
 static imageheader_t mainheader;
 
 static uint32_t target_hardware_id;
-static uint8_t *decodebuf_readptr;
+static const uint8_t *decodebuf_readptr;
+static const uint8_t *decodebuf_end;
 uint8_t __attribute__((aligned(4))) decodebuffer[DECODEBUFFER_SIZE];
-char    __attribute__((aligned(4))) decrunchbuffer[UNCOMPRESSED_CHUNK_SIZE];
+
+/* the dictionary is stored right-aligned in front of the decrunch buffer */
+static char __attribute__((aligned(4))) chunkbuffer[DICTIONARY_SIZE + LARGE_CHUNK_SIZE];
+static char *const decrunchbuffer = chunkbuffer + DICTIONARY_SIZE;
+static unsigned int dictionary_size;
+static bool have_dictionary;
+
+/* images from fwtagger-main.pl always reach the overlay area, so all  */
+/* sectors up to the settings are erased while waiting for lines        */
+static bool erased_blocks[ERASE_BLOCKS];
+static unsigned int next_erase_block = IMAGE_BLOCKS;
+static bool capture_armed;
 
 typedef enum {
   STATE_OK,
@@ -146,10 +173,48 @@ static void boot_main(void) {
   }
 }
 
-static flashstate_t validate_main_image(void) {
+/* returns the index of the last used marker slot or -1 if there is none */
+static int read_marker(installmarker_t *marker) {
+  installmarker_t slots[MARKER_SLOTS];
+  int last = -1;
+
+  spiflash_read_block(slots, MARKER_ADDRESS, sizeof(slots));
+
+  for (unsigned int i = 0; i < MARKER_SLOTS; i++) {
+    if (slots[i].magic != 0xffffffff)
+      last = i;
+  }
+
+  if (last >= 0)
+    *marker = slots[last];
+
+  return last;
+}
+
+static void write_marker(int slot, const installmarker_t *marker) {
+  spiflash_program_start(MARKER_ADDRESS + slot * sizeof(installmarker_t),
+                         marker, sizeof(installmarker_t));
+  spiflash_complete();
+}
+
+/* clear the magic of the current marker so the next boot checks the CRC again */
+static void revoke_marker(void) {
+  installmarker_t marker;
+  int slot = read_marker(&marker);
+
+  if (slot >= 0 && marker.magic != 0) {
+    marker.magic = 0;
+    write_marker(slot, &marker);
+  }
+}
+
+/* full_check forces a CRC check even if the image has a valid marker */
+static flashstate_t validate_main_image(bool full_check) {
+  installmarker_t marker;
+
   spiflash_read_block(&mainheader, MAIN_APP_ADDRESS, sizeof(mainheader));
 
-  if (mainheader.length >= FLASH_SIZE - MAIN_APP_ADDRESS - sizeof(mainheader)) {
+  if (mainheader.length >= MARKER_ADDRESS - MAIN_APP_ADDRESS - sizeof(mainheader)) {
     return STATE_INVALID;
   }
 
@@ -158,11 +223,33 @@ static flashstate_t validate_main_image(void) {
     return STATE_INVALID;
   }
 
+  int slot = read_marker(&marker);
+  bool marker_ok = slot >= 0 &&
+                   marker.magic  == MARKER_MAGIC &&
+                   marker.length == mainheader.length &&
+                   marker.crc    == mainheader.crc;
+
+  if (marker_ok && !full_check) {
+    return STATE_OK;
+  }
+
   uint32_t flashcrc = spiflash_crc32(MAIN_APP_ADDRESS + sizeof(mainheader), mainheader.length);
   if (flashcrc != mainheader.crc) {
+    if (marker_ok) {
+      revoke_marker();
+    }
+
     return STATE_BADCRC;
   }
 
+  if (!marker_ok && slot < (int)MARKER_SLOTS - 1) {
+    marker.sequence = (slot >= 0 ? marker.sequence + 1 : 0);
+    marker.magic    = MARKER_MAGIC;
+    marker.length   = mainheader.length;
+    marker.crc      = mainheader.crc;
+    write_marker(slot + 1, &marker);
+  }
+
   return STATE_OK;
 }
 
@@ -210,65 +297,33 @@ void set_capture_range(unsigned int start, unsigned int end) {
   }
 }
 
-/* decode current captured line to a buffer */
-static size_t decode_7bit(void* destination, size_t buffersize) {
-  size_t length = LINECAPTURE->linedata[1] - 0x4040;
-  length = (length & 0x7f) | ((length & 0x7f00) >> 1);
+/* keeps the flash busy while waiting for lines */
+static void erase_ahead(void) {
+  if (spiflash_poll())
+    return;
 
-  if (length > (buffersize / 2)) {
-    return 0;
+  while (next_erase_block < IMAGE_BLOCKS && erased_blocks[next_erase_block]) {
+    next_erase_block++;
   }
 
-  unsigned int bitbuffer = 0;
-  unsigned int bits_remain = 0;
-  uint16_t *writeptr = (uint16_t*)destination;
-  const volatile uint32_t *readptr = LINECAPTURE->linedata + 2;
-
-  while (length > 0) {
-    unsigned int curword = *readptr++ - 0x4040;
-
-    if (bits_remain == 0) {
-      bitbuffer = curword;
-      bits_remain = 7;
-      continue;
-    }
-
-    *writeptr++ = (curword << 1) | (bitbuffer & 0x0101);
-    bitbuffer = (bitbuffer & 0xfefe) >> 1;
-    bits_remain--;
-    length--;
+  if (next_erase_block < IMAGE_BLOCKS) {
+    erased_blocks[next_erase_block] = true;
+    spiflash_erase_start(MAIN_APP_ADDRESS + next_erase_block * ERASE_BLOCK_SIZE);
   }
-
-  return 2 * (writeptr - (uint16_t*)destination);
 }
 
-static bool validate_line(unsigned int linelength) {
-  uint8_t prefix[2] = {
-    (LINECAPTURE->linedata[0] >> 8) & 0xff,
-     LINECAPTURE->linedata[0] & 0xff
-  };
-
-  /* unscramble */
-  uint32_t rngstate = (prefix[0] << 8) | prefix[1];
-  for (unsigned int i = 0; i < linelength; i++) {
-    rngstate = (RNG_MULT * rngstate + RNG_ADD) % RNG_MOD;
-    uint8_t randval = (rngstate >> RNG_SHIFT) & 0xff;
-    decodebuffer[i] ^= randval;
-  }
-
-  unsigned int buffercrc = getu32();
-
-  crc_t crc = crc_init();
-  crc = crc_update(crc, prefix, 2);
-  crc = crc_update(crc, decodebuffer + 4, linelength - 4);
-  crc = crc_finalize(crc);
-
-  return buffercrc == crc;
+/* capture the next line while the current one is written */
+static void arm_capture(void) {
+  LINECAPTURE->arm = 0; // value does not matter
+  capture_armed = true;
 }
 
 static bool capture_line(void) {
   while (1) {
-    LINECAPTURE->arm = 0; // value does not matter
+    if (!capture_armed) {
+      LINECAPTURE->arm = 0; // value does not matter
+    }
+    capture_armed = false;
 
     while (LINECAPTURE->linedata[0] & LINECAPTURE_FLAG_BUSY) {
       if (pad_buttons & (IRBUTTON_LONG | IR_BACK | IR_LEFT | IR_RIGHT |
@@ -277,11 +332,14 @@ static bool capture_line(void) {
       }
 
       spin();
+      erase_ahead();
     }
 
-    size_t len = decode_7bit(decodebuffer, sizeof(decodebuffer));
-    decodebuf_readptr = decodebuffer;
-    if (len >= 4 && validate_line(len)) {
+    size_t len = updateline_decode(LINECAPTURE->linedata, decodebuffer, sizeof(decodebuffer));
+    if (updateline_validate(decodebuffer, len, LINECAPTURE->linedata[0])) {
+      /* skip the CRC */
+      decodebuf_readptr = decodebuffer + 4;
+      decodebuf_end     = decodebuffer + len;
       return true;
     }
 
@@ -291,7 +349,7 @@ static bool capture_line(void) {
 }
 
 static bool choose_update(unsigned int fwcount) {
-  uint8_t *orig_readptr = decodebuf_readptr;
+  const uint8_t *orig_readptr = decodebuf_readptr;
 
   if (fwcount >= sizeof(menu_items) / sizeof(menu_items[0])) {
     fwcount = sizeof(menu_items) / sizeof(menu_items[0]) - 1;
@@ -308,7 +366,7 @@ static bool choose_update(unsigned int fwcount) {
     char signature_chars[5];
     convert_signature(signature_chars, target_hardware_id);
 
-    int len = snprintf(stringptr, sizeof(decrunchbuffer) - (stringptr - decrunchbuffer),
+    int len = snprintf(stringptr, LARGE_CHUNK_SIZE - (stringptr - decrunchbuffer),
                        "%08x (%s)", signature_word, signature_chars);
 
     if (mainheader.hardware_id == signature_word) {
@@ -317,7 +375,7 @@ static bool choose_update(unsigned int fwcount) {
 
     menu_items[i].text = stringptr;
     stringptr += len + 1;
-    if (stringptr >= decrunchbuffer + sizeof(decrunchbuffer)) {
+    if (stringptr >= decrunchbuffer + LARGE_CHUNK_SIZE) {
       break;
     }
 
@@ -356,6 +414,15 @@ static bool look_for_update(void) {
     /* check if a matching firmware is available */
     unsigned int fwcount = getu16();
 
+    if (fwcount == 0) {
+      unsigned int format = getu16();
+
+      if (format == INFO_FORMAT_LZ || format == INFO_FORMAT_LZDICT) {
+        have_dictionary = (format == INFO_FORMAT_LZDICT);
+        fwcount = getu16();
+      }
+    }
+
     if (fwcount == 0) {
       osd_gotoxy(3, 7);
       osd_clearline(7, 0);
@@ -396,6 +463,29 @@ static bool look_for_update(void) {
   }
 }
 
+static void __attribute__((noreturn)) data_corrupted(void) {
+  /* in theory we could try again, but the line CRC was ok so let the user decide */
+  osd_gotoxy(3, 3);
+  osd_puts("Compressed data is corrupted.\n   Please power-cycle and try again.");
+  while (1) ;
+}
+
+static bool load_dictionary(void) {
+  set_capture_range(DICTIONARY_LINE, DICTIONARY_LINE);
+  LINECAPTURE->selected_page = INFO_PAGE;
+
+  if (!capture_line())
+    return false;
+
+  dictionary_size = decodebuf_end - decodebuf_readptr;
+  if (dictionary_size > DICTIONARY_SIZE) {
+    data_corrupted();
+  }
+
+  memcpy(decrunchbuffer - dictionary_size, decodebuf_readptr, dictionary_size);
+  return true;
+}
+
 static bool try_update(void) {
   if (!look_for_update()) {
     /* user requested exit */
@@ -411,15 +501,9 @@ static bool try_update(void) {
   }
   version[8] = 0;
 
-  /* hide the update data */
-  for (unsigned int i = 5 * OSD_CHARS_PER_LINE; i < 7 * OSD_CHARS_PER_LINE; i++) {
-    /* keep existing text in the first two lines */
-    OSDRAM->data[i] |= ATTRIB_DIM_BG;
-  }
-
-  for (unsigned int i = 7; i < OSD_LINES_ON_SCREEN; i++) {
-    osd_clearline(i, ATTRIB_DIM_BG);
-  }
+  /* hide the update data, keeping existing text in the first two lines */
+  osd_dimbox(0, 5, OSD_CHARS_PER_LINE, 2, ATTRIB_DIM_BG);
+  osd_fillbox(0, 7, OSD_CHARS_PER_LINE, OSD_LINES_ON_SCREEN - 7, ' ' | ATTRIB_DIM_BG);
 
   osd_gotoxy(3, 7);
   printf("Available version: %s", version);
@@ -438,6 +522,8 @@ static bool try_update(void) {
       /* user requested exit */
       return false;
     }
+
+    irq_wait();
   }
 
   osd_clearline(7, ATTRIB_DIM_BG);
@@ -446,12 +532,27 @@ static bool try_update(void) {
   osd_gotoxy(3, 7);
   printf("Installing version %s", version);
 
+  /* an interrupted update must not be accepted by a marker of the */
+  /* old image, so revoke it before anything is erased or written  */
+  revoke_marker();
+
   /* start flashing */
-  bool erased_blocks[(FLASH_SIZE - MAIN_APP_ADDRESS) / ERASE_BLOCK_SIZE];
-  for (unsigned int i = 0; i < sizeof(erased_blocks); i++) {
+  for (unsigned int i = 0; i < ERASE_BLOCKS; i++) {
     erased_blocks[i] = false;
   }
 
+  /* nothing is erased until the first chunk has been decoded, */
+  /* aborting before that leaves the installed image intact     */
+  next_erase_block = IMAGE_BLOCKS;
+  bool erasing = false;
+
+  /* all chunks may reference the dictionary, so it is needed first */
+  dictionary_size = 0;
+  if (have_dictionary && !load_dictionary()) {
+    spiflash_complete();
+    return false;
+  }
+
   /* grab pieces of the update and apply it */
   set_capture_range(0, lines - 1);
   LINECAPTURE->selected_page = page;
@@ -464,51 +565,48 @@ static bool try_update(void) {
     if (!capture_line())
       break;
 
+    if (lines_remain > 1) {
+      arm_capture();
+    }
+
     unsigned int chunks = getu8();
     for (unsigned int i = 0; i < chunks; i++) {
-      unsigned int chunknum = getu8();
-      unsigned int chunklen = getu16();
-
-      if (chunklen != UNCOMPRESSED_CHUNK_SIZE) {
-        char *startptr =
-          exo_decrunch((char *)decodebuf_readptr + chunklen,
-                      decrunchbuffer + sizeof(decrunchbuffer), sizeof(decrunchbuffer));
+      /* the previous chunk may still be sent from the buffer */
+      spiflash_wait_buffer();
 
-        if (startptr != NULL) {
-          unsigned int decrunch_size = (char*)decrunchbuffer + sizeof(decrunchbuffer) - startptr;
+      uint32_t offset;
+      unsigned int chunksize =
+        updateline_unpack_chunk(&decodebuf_readptr, decodebuf_end,
+                                decrunchbuffer, dictionary_size, &offset);
 
-          if (decrunch_size != UNCOMPRESSED_CHUNK_SIZE) {
-            startptr = NULL;
-          }
-        }
-
-        if (startptr == NULL) {
-          /* in theory we could try again, but the line CRC was ok so let the user decide */
-          osd_gotoxy(3, 3);
-          osd_puts("Compressed data is corrupted.\n   Please power-cycle and try again.");
-          while (1) ;
-        }
-      } else {
-        memcpy(decrunchbuffer, decodebuf_readptr, UNCOMPRESSED_CHUNK_SIZE);
+      if (chunksize == 0) {
+        data_corrupted();
       }
 
-      decodebuf_readptr += chunklen;
+      if (!erasing) {
+        /* valid data has arrived, erase the other blocks while waiting */
+        next_erase_block = 0;
+        erasing = true;
+      }
 
-      if (!erased_blocks[chunknum * UNCOMPRESSED_CHUNK_SIZE / ERASE_BLOCK_SIZE]) {
-        erased_blocks[chunknum * UNCOMPRESSED_CHUNK_SIZE / ERASE_BLOCK_SIZE] = true;
-        spiflash_erase_sector(MAIN_APP_ADDRESS + chunknum * UNCOMPRESSED_CHUNK_SIZE);
+      if (!erased_blocks[offset / ERASE_BLOCK_SIZE]) {
+        erased_blocks[offset / ERASE_BLOCK_SIZE] = true;
+        spiflash_erase_start(MAIN_APP_ADDRESS + offset);
       }
 
-      spiflash_write_page(MAIN_APP_ADDRESS + chunknum * UNCOMPRESSED_CHUNK_SIZE,
-                          decrunchbuffer, UNCOMPRESSED_CHUNK_SIZE);
+      /* programming continues while the next chunk is unpacked */
+      spiflash_program_start(MAIN_APP_ADDRESS + offset, decrunchbuffer, chunksize);
     }
 
     lines_remain--;
   }
 
+  next_erase_block = IMAGE_BLOCKS;
+  spiflash_complete();
+
   osd_clearline(9, ATTRIB_DIM_BG);
   osd_gotoxy(3, 9);
-  flashstate_t flashstate = validate_main_image();
+  flashstate_t flashstate = validate_main_image(true);
   if (flashstate != STATE_OK) {
     osd_puts("Installation failed.\n   Please power-cycle and try again.");
     while (1) ;
@@ -525,7 +623,7 @@ static bool try_update(void) {
            seconds_to_reboot == 1 ? ' ' : 's');
     seconds_to_reboot--;
 
-    time_t nexttick = getticks() + HZ;
+    tick_t nexttick = getticks() + HZ;
 
     while (time_after(nexttick, getticks())) {
       if (pad_buttons & (PAD_START | IR_OK)) {
@@ -533,6 +631,8 @@ static bool try_update(void) {
         pad_clear(PAD_START | IR_OK);
         return true;
       }
+
+      irq_wait();
     }
   }
 
@@ -556,13 +656,17 @@ void run_mainloop(void) {
   }
 
   while (1) {
-    flashstate = validate_main_image();
+    /* the CRC is only checked if there is no install marker for the image */
+    flashstate = validate_main_image(false);
 
     /* check if flasher entry was requested from main image */
     if (first_time && icap_read_register(ICAP_REG_GENERAL1) != 0) {
       first_time = false;
       flashstate = STATE_FORCEFLASHER;
 
+      /* full check to revoke the marker of a corrupted image */
+      validate_main_image(true);
+
       /* main hardware ID should be ok because it requested entry to here */
       if (target_hardware_id == 0)
         target_hardware_id = mainheader.hardware_id;
@@ -575,9 +679,12 @@ void run_mainloop(void) {
         VIDEOIF->osd_bg = 0;
         osd_gotoxy(3, 5);
         osd_puts("Please release the IR config button.");
-        while (!(IRRX->pulsedata & IRRX_BUTTON)) ;
+        while (!(IRRX->pulsedata & IRRX_BUTTON))
+          irq_wait();
         pad_clear(PAD_ALL);
 
+        validate_main_image(true);
+
       } else {
         /* boot main image */
         boot_main();
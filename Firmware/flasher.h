@@ -33,11 +33,14 @@
 
 #include <stdint.h>
 
+#define MAIN_APP_ADDRESS        0x30000
+#define MAIN_APP_SIZE           0x40000 // up to SETTINGS_OFFSET
 #define DECODEBUFFER_SIZE       1320 // 1254 is enough for flashing, diag needs 1320
 #define UNCOMPRESSED_CHUNK_SIZE 1024
+#define LARGE_CHUNK_SIZE        4096 // compressed size must still fit into one line
+#define DICTIONARY_SIZE         1024
 
 extern uint8_t __attribute__((aligned(4))) decodebuffer[DECODEBUFFER_SIZE];
-extern char    __attribute__((aligned(4))) decrunchbuffer[UNCOMPRESSED_CHUNK_SIZE];
 
 void set_capture_range(unsigned int start, unsigned int end);
 
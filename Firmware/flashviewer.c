@@ -31,6 +31,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include "flasher.h"
+#include "irq.h"
 #include "osd.h"
 #include "pad.h"
 #include "spiflash.h"
@@ -115,6 +116,8 @@ void flash_viewer(void) {
 
       pad_clear(PAD_ALL);
       dump_memory(address);
+    } else {
+      irq_wait();
     }
   }
 }
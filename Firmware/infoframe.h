@@ -25,7 +25,7 @@
    THE POSSIBILITY OF SUCH DAMAGE.
 
 
-   infoframe.h: Declarations for the infoframe generator
+   infoframe.h: Declarations for the infoframe set selection
 
 */
 
@@ -34,6 +34,6 @@
 
 #include "settings.h"
 
-void update_infoframe(video_mode_t outmode);
+void update_infoframe(video_mode_t outmode, unsigned int factor);
 
 #endif
@@ -0,0 +1,113 @@
+/* GCVideo DVI Firmware
+
+   Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+   THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+
+   lz4dec.c: Decoder for LZ4 blocks
+
+   Decodes the LZ4 block format (no frame header). Unlike exomizer all
+   fields are byte-aligned, so it is much faster on the ZPU. Returns the
+   number of bytes written to out or 0 if the input is malformed or
+   does not fit into the output buffer. The dictsize bytes in front of
+   out are a preset dictionary that matches may reference.
+
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "lz4dec.h"
+
+#define MIN_MATCH 4
+
+/* read an extended length, returns false if the input ends */
+static bool read_length(const uint8_t **in, const uint8_t *in_end, size_t *length) {
+  unsigned int byte;
+
+  do {
+    if (*in >= in_end)
+      return false;
+
+    byte = *(*in)++;
+    *length += byte;
+  } while (byte == 255);
+
+  return true;
+}
+
+size_t lz4_decode(const uint8_t *in, size_t insize, uint8_t *out, size_t outsize,
+                  size_t dictsize) {
+  const uint8_t *in_end  = in + insize;
+  uint8_t       *outptr  = out;
+  uint8_t       *out_end = out + outsize;
+
+  while (in < in_end) {
+    unsigned int token  = *in++;
+    size_t       length = token >> 4;
+
+    /* literals */
+    if (length == 15 && !read_length(&in, in_end, &length))
+      return 0;
+
+    if (length > (size_t)(in_end - in) || length > (size_t)(out_end - outptr))
+      return 0;
+
+    memcpy(outptr, in, length);
+    outptr += length;
+    in     += length;
+
+    /* the last sequence has no match */
+    if (in == in_end)
+      break;
+
+    /* match */
+    if (in_end - in < 2)
+      return 0;
+
+    size_t offset = in[0] | (in[1] << 8);
+    in += 2;
+
+    if (offset == 0 || offset > (size_t)(outptr - out) + dictsize)
+      return 0;
+
+    length = token & 0x0f;
+    if (length == 15 && !read_length(&in, in_end, &length))
+      return 0;
+
+    length += MIN_MATCH;
+    if (length > (size_t)(out_end - outptr))
+      return 0;
+
+    /* byte-wise copy, source and destination may overlap */
+    const uint8_t *matchptr = outptr - offset;
+    while (length--)
+      *outptr++ = *matchptr++;
+  }
+
+  return outptr - out;
+}
@@ -48,6 +48,10 @@
 
 void irq_handler(void) {
   while (IRQController->Flags & IRQ_FLAG_ANY) {
+    /* must be handled before vsync to provide current mode data */
+    if (IRQController->Flags & IRQ_FLAG_VIDEOMODE) {
+      videomode_handler();
+    }
     if (IRQController->Flags & IRQ_FLAG_VSYNC) {
       vsync_handler();
       VIDEOIF->clear_irq = 0;
@@ -60,6 +64,10 @@ void irq_handler(void) {
       irrx_handler();
       IRRX->pulsedata = 0;
     }
+    if (IRQController->Flags & IRQ_FLAG_SPIDMA) {
+      /* only wakes up spiflash_wait_buffer, reading clears the flag */
+      (void)SPICAP->dma_control;
+    }
   }
 }
 
@@ -68,7 +76,9 @@ void irq_handler(void) {
 int main(int argc, char **argv) {
   /* initialize interrupt handling */
   VIDEOIF->clear_irq = 0;
-  IRQController->Enable = IRQ_FLAG_VSYNC | IRQ_FLAG_PAD | IRQ_FLAG_IRRX | IRQ_FLAG_GLOBALEN;
+  videomode_handler();
+  IRQController->Enable = IRQ_FLAG_VSYNC | IRQ_FLAG_PAD | IRQ_FLAG_IRRX |
+                          IRQ_FLAG_VIDEOMODE | IRQ_FLAG_SPIDMA | IRQ_FLAG_GLOBALEN;
   VIDEOIF->settings = VIDEOIF_SET_CABLEDETECT; // temporary during init
 
   /* run initializations */
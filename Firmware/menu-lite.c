@@ -30,6 +30,7 @@
 */
 
 #include <stdio.h>
+#include "irq.h"
 #include "osd.h"
 #include "pad.h"
 #include "utils.h"
@@ -73,7 +74,8 @@ int menu_exec(menu_t *menu, unsigned int initial_item) {
   /* handle input */
   while (1) {
     /* wait for input */
-    while (!pad_buttons) ;
+    while (!pad_buttons)
+      irq_wait();
 
     unsigned int curbtns = pad_buttons;
 
@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include "colormatrix.h"
 #include "infoframe.h"
+#include "irq.h"
 #include "modeset_common.h"
 #include "osd.h"
 #include "pad.h"
@@ -65,6 +66,7 @@ static const cliprange_t clipranges[] = {
   [ VALTYPE_SLPROFILE ]    = {     1,    3 -1 },
   [ VALTYPE_SLINDEX ]      = {    16,  235 -1 },
   [ VALTYPE_COLORMODE ]    = {     0,    3 -1 },
+  [ VALTYPE_LINEMULT ]     = {     0,    3 -1 },
 };
 
 static const uint8_t value_widths[] = {
@@ -80,6 +82,7 @@ static const uint8_t value_widths[] = {
   [ VALTYPE_SLPROFILE ]    = 6,
   [ VALTYPE_SLINDEX ]      = 6,
   [ VALTYPE_COLORMODE ]    = 7,
+  [ VALTYPE_LINEMULT ]     = 6,
 };
 
 /* (un)draw marker on a menu item */
@@ -124,7 +127,8 @@ static bool set_value(const valueitem_t *value, int newval) {
     if (value->field.flags & VIFLAG_ALLMODES) {
       set_all_modes(mask, newval);
       if (value->field.width == VIDEOIF_BIT_SPOOFINTERLACE) {
-        update_infoframe(detect_output_videomode());
+        update_infoframe(detect_output_videomode(),
+                         line_multiplier(detect_input_videomode()));
       }
 
     } else if (value->field.flags & VIFLAG_MODESET) {
@@ -215,28 +219,32 @@ static void print_value(menu_t *menu, unsigned int itemnum) {
   case VALTYPE_BYTE:
   case VALTYPE_SBYTE_99:
   case VALTYPE_SLINDEX:
-    printf("%4d", value);
+    osd_putint(value, 4, 0);
     break;
 
   case VALTYPE_SBYTE_127:
     if (value == 0)
       osd_puts("   0");
     else
-      printf("%+4d", value);
+      osd_putint(value, 4, OSD_INT_FORCESIGN);
     break;
 
   case VALTYPE_FIXPOINT1:
-    printf("%2d.%03d", value / 256, (value % 256) * 1000 / 256);
+    osd_putint(value / 256, 2, 0);
+    osd_putchar('.');
+    osd_putint((value % 256) * 1000 / 256, 3, OSD_INT_ZEROPAD);
     break;
 
   case VALTYPE_FIXPOINT2:
-    printf("%2d.%03d", value / 128, (value % 128) * 1000 / 128);
+    osd_putint(value / 128, 2, 0);
+    osd_putchar('.');
+    osd_putint((value % 128) * 1000 / 128, 3, OSD_INT_ZEROPAD);
     break;
 
   case VALTYPE_SLPROFILEOFF:
   case VALTYPE_SLPROFILE:
     if (value) {
-      printf("%4d", value);
+      osd_putint(value, 4, 0);
     } else {
       osd_puts(" Off");
     }
@@ -250,6 +258,15 @@ static void print_value(menu_t *menu, unsigned int itemnum) {
       default: osd_puts("YC422"); break;
     }
     break;
+
+  case VALTYPE_LINEMULT:
+    if (value) {
+      osd_putint(value + 1, 3, 0);
+      osd_putchar('x');
+    } else {
+      osd_puts(" Off");
+    }
+    break;
   }
 }
 
@@ -274,8 +291,13 @@ static void update_value(menu_t *menu, unsigned int itemid, updatetype_t upd) {
   clip_value(&curval, clipranges[value->type].lower, clipranges[value->type].upper + 1);
 
   if (set_value(value, curval)) {
-    /* need a full redraw */
-    menu_draw(menu);
+    if (menu->items[itemid].redraw_mask) {
+      /* repaint only the items that depend on this one */
+      menu_redraw_items(menu, menu->items[itemid].redraw_mask | MENU_ITEM(itemid));
+    } else {
+      /* need a full redraw */
+      menu_draw(menu);
+    }
     mark_item(menu, itemid, MENUMARKER_LEFT);
   } else {
     /* just update the changed value */
@@ -283,8 +305,24 @@ static void update_value(menu_t *menu, unsigned int itemid, updatetype_t upd) {
   }
 }
 
+static void draw_item(menu_t *menu, unsigned int itemid) {
+  const menuitem_t *item = &menu->items[itemid];
+
+  if (item->flags & MENU_FLAG_DISABLED)
+    osd_setattr(true, true);
+  else
+    osd_setattr(true, false);
+
+  /* print item */
+  osd_gotoxy(menu->xpos + 2, menu->ypos + item->line);
+  osd_puts(item->text);
+
+  if (item->value) {
+    print_value(menu, itemid);
+  }
+}
+
 void menu_draw(menu_t *menu) {
-  const menuitem_t *items = menu->items;
   unsigned int i;
 
   /* draw the menu */
@@ -296,18 +334,27 @@ void menu_draw(menu_t *menu) {
     menu->drawcallback(menu);
 
   for (i = 0; i < menu->entries; i++) {
-    if (items[i].flags & MENU_FLAG_DISABLED)
-      osd_setattr(true, true);
-    else
-      osd_setattr(true, false);
+    draw_item(menu, i);
+  }
+}
 
-    /* print item */
-    osd_gotoxy(menu->xpos + 2, menu->ypos + items[i].line);
-    osd_puts(items[i].text);
+void menu_redraw_items(menu_t *menu, uint32_t mask) {
+  unsigned int i;
 
-    if (items[i].value) {
-      print_value(menu, i);
-    }
+  /* clear the interior of the selected lines */
+  for (i = 0; i < menu->entries; i++) {
+    if (mask & MENU_ITEM(i))
+      osd_fillbox(menu->xpos + 1, menu->ypos + menu->items[i].line,
+                  menu->xsize - 2, 1, ' ' | ATTRIB_DIM_BG);
+  }
+
+  /* same order as menu_draw, the callback may update item flags */
+  if (menu->drawcallback)
+    menu->drawcallback(menu);
+
+  for (i = 0; i < menu->entries; i++) {
+    if (mask & MENU_ITEM(i))
+      draw_item(menu, i);
   }
 }
 
@@ -333,7 +380,8 @@ int menu_exec(menu_t *menu, unsigned int initial_item) {
   /* handle input */
   while (1) {
     /* wait for input */
-    while (!pad_buttons) ;
+    while (!pad_buttons)
+      irq_wait();
 
     unsigned int curbtns = pad_buttons;
 
@@ -48,6 +48,7 @@ typedef enum {
   VALTYPE_SLPROFILE,    // 1 to 3
   VALTYPE_SLINDEX,      // 16 to 235
   VALTYPE_COLORMODE,    // 0 to 3 shown as RGBF, RGBL, Y444, Y422
+  VALTYPE_LINEMULT,     // 0 to 3 shown as Off, 2x to 4x
 } valuetype_t;
 
 #define VIFLAG_REDRAW         (1<<0)
@@ -81,6 +82,7 @@ typedef struct {
   valueitem_t  *value;
   unsigned char line;
   unsigned char flags;
+  uint32_t      redraw_mask; // items to repaint on value change, 0 = whole menu
 } menuitem_t;
 
 struct menu_s;
@@ -97,10 +99,13 @@ typedef struct menu_s {
 
 #define MENU_FLAG_DISABLED (1 << 0)
 
+#define MENU_ITEM(x) (1U << (x))
+
 #define MENU_ABORT       -1
 #define MENU_VIDEOCHANGE -2
 
 void menu_draw(menu_t *menu);
+void menu_redraw_items(menu_t *menu, uint32_t mask);
 int  menu_exec(menu_t *menu, unsigned int initial_item);
 
 #endif
@@ -0,0 +1,88 @@
+#!/usr/bin/env perl
+#
+# GCVideo DVI Firmware
+# Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# 1. Redistributions of source code must retain the above copyright notice,
+#    this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+#    this list of conditions and the following disclaimer in the documentation
+#    and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+# THE POSSIBILITY OF SUCH DAMAGE.
+#
+# mkoverlays.pl: Combine overlay binaries into a flash image with a directory
+#
+
+use warnings;
+use strict;
+use feature ':5.10';
+
+# bitwise CRC-32/MPEG-2, same as the hardware CRC in ZPU_SPICAP_CRC
+sub crc32_mpeg {
+    my $data = shift;
+    my $crc  = 0xffffffff;
+
+    foreach my $ch (unpack("C*", $data)) {
+        $crc ^= $ch << 24;
+        for (my $i = 0; $i < 8; $i++) {
+            if ($crc & 0x80000000) {
+                $crc = (($crc << 1) ^ 0x04c11db7) & 0xffffffff;
+            } else {
+                $crc = ($crc << 1) & 0xffffffff;
+            }
+        }
+    }
+
+    return $crc;
+}
+
+if (scalar(@ARGV) < 2) {
+    say "Usage: $0 output.bin overlay1.bin [overlay2.bin ...]";
+    exit 1;
+}
+
+my $outfile   = shift;
+my $directory = "";
+my $contents  = "";
+my $offset    = 12 * scalar(@ARGV);
+
+foreach my $file (@ARGV) {
+    open IN, "<", $file or die "Can't open $file: $!";
+    binmode IN;
+
+    my $data = "";
+    if (-s $file) {
+        read(IN, $data, -s $file) or die "Can't read from $file: $!";
+    }
+    close IN;
+
+    # the hardware CRC works on whole words
+    while (length($data) & 3) {
+        $data .= chr(0);
+    }
+
+    $directory .= pack("NNN", $offset, length($data), crc32_mpeg($data));
+    $contents  .= $data;
+    $offset    += length($data);
+}
+
+open OUT, ">", $outfile or die "Can't open $outfile: $!";
+binmode OUT;
+print OUT $directory;
+print OUT $contents;
+close OUT;
@@ -0,0 +1,106 @@
+/* GCVideo DVI Firmware
+
+   Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+   THE POSSIBILITY OF SUCH DAMAGE.
+
+
+   modelog.c: Ring buffer of video mode change events
+
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "portdefs.h"
+#include "settings.h"
+#include "spiflash.h"
+#include "vsync.h"
+#include "modelog.h"
+
+modelog_t modelog;
+
+void modelog_add(modelog_event_t event, video_mode_t inmode, video_mode_t outmode,
+                 unsigned int factor, uint32_t xres, uint32_t yres,
+                 unsigned int disable_frames) {
+  modelog_entry_t *entry = &modelog.entries[modelog.header.next];
+
+  entry->ticks          = getticks();
+  entry->vtotal         = VIDEOIF->vtotal;
+  entry->xres           = xres;
+  entry->yres           = yres;
+  entry->htotal         = VIDEOIF->htotal;
+  entry->event          = event;
+  entry->modes          = (inmode << 4) | outmode;
+  entry->factor         = factor;
+  entry->disable_frames = disable_frames;
+
+  if (++modelog.header.next == MODELOG_ENTRIES)
+    modelog.header.next = 0;
+
+  modelog.header.count++;
+}
+
+uint32_t modelog_saved_address(void) {
+  uint32_t address = settings_spare_page();
+  uint32_t magic;
+
+  if (address == 0)
+    return 0;
+
+  spiflash_read_block(&magic, address + offsetof(modelog_header_t, magic), sizeof(magic));
+  if (magic != MODELOG_MAGIC)
+    return 0;
+
+  return address;
+}
+
+/* must run from BRAM, the flash is busy while the page is programmed */
+bool modelog_save(void) {
+  uint32_t address = settings_spare_page();
+
+  if (address == 0 || !spiflash_is_blank(address, sizeof(modelog_t)))
+    return false;
+
+  /* copy again if an event was added by the vsync interrupt meanwhile */
+  const volatile uint32_t *src = (const volatile uint32_t *)&modelog;
+  uint32_t count;
+
+  spiflash_wait_buffer();
+
+  do {
+    count = modelog_count();
+
+    for (unsigned int i = 0; i < sizeof(modelog_t) / 4; i++) {
+      SPIBUF->data[i] = src[i];
+    }
+  } while (count != modelog_count());
+
+  SPIBUF->data[offsetof(modelog_header_t, magic) / 4]       = MODELOG_MAGIC;
+  SPIBUF->data[offsetof(modelog_header_t, saved_ticks) / 4] = getticks();
+
+  spiflash_program_spibuf(address, sizeof(modelog_t));
+  spiflash_complete();
+
+  return true;
+}
@@ -0,0 +1,97 @@
+/* GCVideo DVI Firmware
+
+   Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+   THE POSSIBILITY OF SUCH DAMAGE.
+
+
+   modelog.h: Ring buffer of video mode change events
+
+*/
+
+#ifndef MODELOG_H
+#define MODELOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "settings.h"
+#include "vsync.h"
+
+#define MODELOG_ENTRIES 12
+#define MODELOG_MAGIC   0x4d4c4f47 // "MLOG", only set in the flash copy
+
+typedef enum {
+  MODELOG_NONE,
+  MODELOG_CHANGE,     // mode change detected, output disabled
+  MODELOG_UNSTABLE,   // modes changed again while the output is disabled
+  MODELOG_ENABLE,     // output enabled again with new modes
+  MODELOG_RESOLUTION, // input resolution changed within the same mode
+  MODELOG_BLANK,      // console has disabled its video output
+} modelog_event_t;
+
+typedef struct {
+  tick_t   ticks;
+  uint32_t vtotal;     // pixels per field, as VIDEOIF->vtotal
+  uint16_t xres;
+  uint16_t yres;
+  uint16_t htotal;
+  uint8_t  event;
+  uint8_t  modes;      // input mode << 4 | output mode
+  uint8_t  factor;     // line multiplier
+  uint8_t  disable_frames;
+} modelog_entry_t;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t count;       // number of events added so far
+  tick_t   saved_ticks;
+  uint8_t  next;        // the newest entry is the one before this
+  uint8_t  padding[3];
+} modelog_header_t;
+
+/* layout of one flash page */
+typedef struct {
+  modelog_header_t header;
+  modelog_entry_t  entries[MODELOG_ENTRIES];
+} modelog_t;
+
+extern modelog_t modelog;
+
+/* changes whenever an event is added */
+static inline uint32_t modelog_count(void) {
+  return *(volatile uint32_t *)&modelog.header.count;
+}
+
+/* called from the vsync interrupt */
+void modelog_add(modelog_event_t event, video_mode_t inmode, video_mode_t outmode,
+                 unsigned int factor, uint32_t xres, uint32_t yres,
+                 unsigned int disable_frames);
+
+/* store the log in the spare page of the current settings record, */
+/* returns false if there is none or it was already used           */
+bool modelog_save(void);
+
+/* flash address of the saved log or 0 if there is none */
+uint32_t modelog_saved_address(void);
+
+#endif
@@ -54,12 +54,50 @@ valueitem_t modeset_value_slprofile = {
   VALTYPE_SLPROFILEOFF, false, {{ modeset_get_slprofile, modeset_set_slprofile }}
 };
 
+int modeset_get_linemult(void) {
+  unsigned int factor = line_multiplier(modeset_mode);
+
+  if (factor == 1)
+    return 0;
+  else
+    return factor - 1;
+}
+
+bool modeset_set_linemult(int value) {
+#if defined(OUTPUT_DUAL) || !defined(ENABLE_FULLRATE)
+  /* the DAC clock can only follow the 2x pixel rate and */
+  /* 3x/4x also need a build with the full rate output   */
+  if (value > 1)
+    value = 1;
+#endif
+
+  /* 3x alternates between two field lengths in interlaced modes, */
+  /* skip over it in the direction the value is changed           */
+  if ((modeset_mode == VIDMODE_480i || modeset_mode == VIDMODE_576i) &&
+      value == 2) {
+    if (modeset_get_linemult() < 2)
+      value = 3;
+    else
+      value = 1;
+  }
+
+  video_settings[modeset_mode] &= ~(VIDEOIF_SET_LD_ENABLE | VIDEOIF_SET_LD_FACTOR_MASK);
+  if (value)
+    video_settings[modeset_mode] |= VIDEOIF_SET_LD_ENABLE |
+      ((value - 1) << VIDEOIF_SET_LD_FACTOR_SHIFT);
+
+  if (current_videomode == modeset_mode)
+    VIDEOIF->settings = video_settings[modeset_mode] | video_settings_global;
+  return true;
+}
+
 valueitem_t modeset_value_sleven      = { VALTYPE_EVENODD, true,
                                           { .field = { NULL, VIDEOIF_BIT_SL_EVEN,      0, VIFLAG_MODESET }} };
 valueitem_t modeset_value_slalt       = { VALTYPE_BOOL, true,
                                           { .field = { NULL, VIDEOIF_BIT_SL_ALTERNATE, 0, VIFLAG_MODESET }} };
-valueitem_t modeset_value_linedoubler = { VALTYPE_BOOL, true,
-                                          { .field = { NULL, VIDEOIF_BIT_LD_ENABLE,    0, VIFLAG_MODESET | VIFLAG_REDRAW }} };
+valueitem_t modeset_value_linedoubler = {
+  VALTYPE_LINEMULT, false, {{ modeset_get_linemult, modeset_set_linemult }}
+};
 
 void modeset_draw(menu_t *menu) {
   /* header */
@@ -45,6 +45,10 @@ enum {
   MODESET_COMMON_MENUITEM_COUNT
 };
 
+/* items whose enable flags depend on the linedoubler/scanline profile values */
+#define MODESET_DEPENDS_SL (MENU_ITEM(MENUITEM_SLEVEN) | MENU_ITEM(MENUITEM_SLALT))
+#define MODESET_DEPENDS_LD (MENU_ITEM(MENUITEM_SLPROFILE) | MODESET_DEPENDS_SL)
+
 /* evil global variable */
 extern video_mode_t modeset_mode;
 
@@ -51,15 +51,21 @@ static void update_writeptr(void) {
   writeptr = OSDRAM->data + cursor_x + OSD_CHARS_PER_LINE * cursor_y;
 }
 
+static void blit(unsigned int op, unsigned int xpos, unsigned int ypos,
+                 unsigned int xsize, unsigned int ysize, uint32_t value) {
+  OSDBLITTER->dest    = xpos + OSD_CHARS_PER_LINE * ypos;
+  OSDBLITTER->size    = (ysize << 8) | xsize;
+  OSDBLITTER->value   = value;
+  OSDBLITTER->command = op;
+}
+
 void osd_init(void) {
   osd_clrscr();
   current_attr = ATTRIB_DIM_BG;
 }
 
 void osd_clrscr(void) {
-  for (unsigned int i = 0; i < sizeof(OSDRAM->data) / sizeof(OSDRAM->data[0]); i++) {
-    OSDRAM->data[i] = ' ';
-  }
+  blit(OSDBLIT_OP_FILL, 0, 0, OSD_CHARS_PER_LINE, OSD_LINES_ON_SCREEN, ' ');
 
   cursor_x = 0;
   cursor_y = 0;
@@ -67,9 +73,7 @@ void osd_clrscr(void) {
 }
 
 void osd_clearline(unsigned int y, unsigned int attr) {
-  for (unsigned int i = 0; i < OSD_CHARS_PER_LINE; i++) {
-    OSDRAM->data[i + y * OSD_CHARS_PER_LINE] = ' ' | attr;
-  }
+  blit(OSDBLIT_OP_FILL, 0, y, OSD_CHARS_PER_LINE, 1, ' ' | attr);
 }
 
 void osd_putchar(const char c) {
@@ -102,6 +106,47 @@ void osd_puts(const char *str) {
     osd_putchar(*str++);
 }
 
+/* print a decimal number right-aligned in a field of the given width */
+/* (the field must fit on the current line, there is no wraparound) */
+void osd_putint(int value, unsigned int width, unsigned int flags) {
+  char buffer[12];
+  char *end = buffer + sizeof(buffer);
+  char *ptr = end;
+  unsigned int num = value < 0 ? -value : value;
+  unsigned int signwidth = (value < 0 || (flags & OSD_INT_FORCESIGN)) ? 1 : 0;
+
+  if (width > sizeof(buffer))
+    width = sizeof(buffer);
+
+  do {
+    *--ptr = '0' + num % 10;
+    num /= 10;
+  } while (num != 0);
+
+  if (flags & OSD_INT_ZEROPAD) {
+    while (end - ptr + signwidth < width)
+      *--ptr = '0';
+  }
+
+  if (value < 0)
+    *--ptr = '-';
+  else if (flags & OSD_INT_FORCESIGN)
+    *--ptr = '+';
+
+  while (end - ptr < width)
+    *--ptr = ' ';
+
+  /* copy to OSD in one go */
+  volatile uint32_t *dest = writeptr;
+  unsigned int attr = current_attr;
+
+  cursor_x += end - ptr;
+  while (ptr < end)
+    *dest++ = *ptr++ | attr;
+
+  writeptr = dest;
+}
+
 void osd_putsat(unsigned int xpos, unsigned int ypos, const char *str) {
   osd_gotoxy(xpos, ypos);
   while (*str)
@@ -124,35 +169,28 @@ void osd_setattr(bool dim_background, bool dim_text) {
 
 void osd_fillbox(unsigned int xpos, unsigned int ypos,
                  unsigned int xsize, unsigned int ysize, uint32_t ch) {
-  for (unsigned int y = 0; y < ysize; y++) {
-    volatile uint32_t *ptr = OSDRAM->data + xpos + OSD_CHARS_PER_LINE * (ypos + y);
-    for (unsigned int x = 0; x < xsize; x++)
-      *ptr++ = ch;
-  }
+  blit(OSDBLIT_OP_FILL, xpos, ypos, xsize, ysize, ch);
+}
+
+void osd_dimbox(unsigned int xpos, unsigned int ypos,
+                unsigned int xsize, unsigned int ysize, unsigned int attr) {
+  blit(OSDBLIT_OP_OR, xpos, ypos, xsize, ysize, attr);
 }
 
 void osd_drawborder(unsigned int xpos, unsigned int ypos,
                     unsigned int xsize, unsigned int ysize) {
-  volatile uint32_t *ptr1 = OSDRAM->data + xpos + OSD_CHARS_PER_LINE * ypos;
-  volatile uint32_t *ptr2 = OSDRAM->data + xpos + OSD_CHARS_PER_LINE * (ypos + ysize - 1);
-
-  /* horizontal edges and corners */
-  *ptr1++ = BOXCHAR_TOPLEFT;
-  *ptr2++ = BOXCHAR_BOTLEFT;
-  for (unsigned int x = 1; x < xsize - 1; x++) {
-    *ptr1++ = BOXCHAR_TOP;
-    *ptr2++ = BOXCHAR_BOT;
-  }
-  *ptr1 = BOXCHAR_TOPRIGHT;
-  *ptr2 = BOXCHAR_BOTRIGHT;
-
-  /* vertical edges */
-  ptr1 = OSDRAM->data + OSD_CHARS_PER_LINE * (ypos + 1) + xpos;
-  ptr2 = OSDRAM->data + OSD_CHARS_PER_LINE * (ypos + 1) + xpos + xsize - 1;
-  for (unsigned int y = 1; y < ysize - 1; y++) {
-    *ptr1 = BOXCHAR_LEFT;
-    *ptr2 = BOXCHAR_RIGHT;
-    ptr1 += OSD_CHARS_PER_LINE;
-    ptr2 += OSD_CHARS_PER_LINE;
-  }
+  unsigned int xend = xpos + xsize - 1;
+  unsigned int yend = ypos + ysize - 1;
+
+  /* corners */
+  OSDRAM->data[xpos + OSD_CHARS_PER_LINE * ypos] = BOXCHAR_TOPLEFT;
+  OSDRAM->data[xend + OSD_CHARS_PER_LINE * ypos] = BOXCHAR_TOPRIGHT;
+  OSDRAM->data[xpos + OSD_CHARS_PER_LINE * yend] = BOXCHAR_BOTLEFT;
+  OSDRAM->data[xend + OSD_CHARS_PER_LINE * yend] = BOXCHAR_BOTRIGHT;
+
+  /* edges */
+  blit(OSDBLIT_OP_FILL, xpos + 1, ypos, xsize - 2, 1, BOXCHAR_TOP);
+  blit(OSDBLIT_OP_FILL, xpos + 1, yend, xsize - 2, 1, BOXCHAR_BOT);
+  blit(OSDBLIT_OP_FILL, xpos, ypos + 1, 1, ysize - 2, BOXCHAR_LEFT);
+  blit(OSDBLIT_OP_FILL, xend, ypos + 1, 1, ysize - 2, BOXCHAR_RIGHT);
 }
@@ -41,17 +41,24 @@
 #define OSD_CHARS_PER_LINE   45
 #define OSD_LINES_ON_SCREEN  35
 
+/* flags for osd_putint */
+#define OSD_INT_ZEROPAD   1
+#define OSD_INT_FORCESIGN 2
+
 void osd_init(void);
 void osd_clrscr(void);
 void osd_clearline(unsigned int y, unsigned int attr);
 void osd_putchar(const char c);
 void osd_putcharat(unsigned int xpos, unsigned int ypos, const char c, unsigned int attr);
 void osd_puts(const char *str);
+void osd_putint(int value, unsigned int width, unsigned int flags);
 void osd_putsat(unsigned int xpos, unsigned int ypos, const char *str);
 void osd_gotoxy(unsigned int x, unsigned int y);
 void osd_setattr(bool dim_background, bool dim_text);
 void osd_fillbox(unsigned int xpos, unsigned int ypos,
                  unsigned int xsize, unsigned int ysize, uint32_t ch);
+void osd_dimbox(unsigned int xpos, unsigned int ypos,
+                unsigned int xsize, unsigned int ysize, unsigned int attr);
 void osd_drawborder(unsigned int xpos, unsigned int ypos,
                     unsigned int xsize, unsigned int ysize);
 
@@ -0,0 +1,80 @@
+/* GCVideo DVI Firmware
+
+   Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+   THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+   overlay.c: Code overlays loaded from SPI flash
+
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "spiflash.h"
+#include "overlay.h"
+
+/* overlay image location in flash, must match fwtagger-main.pl */
+#define OVERLAY_FLASH_ADDRESS 0x60000
+#define OVERLAY_FLASH_SIZE    0x8000
+
+/* directory entry at the start of the overlay image */
+typedef struct {
+  uint32_t offset; // relative to start of image
+  uint32_t length;
+  uint32_t crc;
+} overlayentry_t;
+
+/* defined by the linker script */
+extern char __overlay_start[];
+extern char __overlay_end[];
+
+static overlay_t loaded_overlay = OVERLAY_COUNT;
+
+bool overlay_load(overlay_t overlay) {
+  overlayentry_t entry;
+
+  if (overlay == loaded_overlay)
+    return true;
+
+  /* region will be overwritten, invalidate the current overlay */
+  loaded_overlay = OVERLAY_COUNT;
+
+  spiflash_read_block(&entry, OVERLAY_FLASH_ADDRESS + overlay * sizeof(overlayentry_t),
+                      sizeof(overlayentry_t));
+
+  if (entry.offset > OVERLAY_FLASH_SIZE ||
+      entry.length > OVERLAY_FLASH_SIZE - entry.offset ||
+      entry.length > (uint32_t)(__overlay_end - __overlay_start) ||
+      (entry.length & 3))
+    return false;
+
+  if (spiflash_crc32(OVERLAY_FLASH_ADDRESS + entry.offset, entry.length) != entry.crc)
+    return false;
+
+  spiflash_read_block(__overlay_start, OVERLAY_FLASH_ADDRESS + entry.offset, entry.length);
+  loaded_overlay = overlay;
+
+  return true;
+}
@@ -29,6 +29,7 @@
 
 */
 
+#include "irq.h"
 #include "portdefs.h"
 #include "vsync.h"
 #include "pad.h"
@@ -76,10 +77,13 @@ void pad_clear_irq(uint32_t which) {
 
 void pad_wait_for_release(void) {
   /* wait until all controller buttons are released */
-  while (pad_buttons & PAD_ALL_GC)
+  while (pad_buttons & PAD_ALL_GC) {
     if (pad_buttons & PAD_VIDEOCHANGE)
       return;
 
+    irq_wait();
+  }
+
   /* clear IR remote buttons too */
   pad_clear(PAD_ALL);
 }
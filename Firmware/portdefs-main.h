@@ -42,6 +42,8 @@
 #define __O  volatile
 #define __IO volatile
 
+#define HAVE_SPI_HWCRC
+
 /* --- InfoFrame RAM --- */
 
 typedef struct {
@@ -58,12 +60,27 @@ typedef struct {
   /*__IO*/ uint32_t profiles[SCANLINERAM_ENTRIES];
 } SCANLINERAM_TypeDef;
 
+/* --- Audio diagnostics --- */
+
+typedef struct {
+  // all values cover the last one-second window
+  __I uint32_t sequence;        // incremented at the end of each window
+  __I uint32_t bclock_glitches;
+  __I uint32_t lrclock_glitches;
+  __I uint32_t adata_glitches;
+  __I uint32_t samplerate;      // stereo samples
+  __I uint32_t peak;            // left in the upper half, right in the lower
+  __I uint32_t clipped;         // full-scale input samples
+} AUDIODIAG_TypeDef;
+
 /* --- mixing it all together --- */
 
 #define IFRAM_BASE       ((uint32_t)0xffff8000UL)
 #define SCANLINERAM_BASE ((uint32_t)0xffffe000UL)
+#define AUDIODIAG_BASE   ((uint32_t)0xfffff800UL)
 
 #define IFRAM       ((IFRAM_TypeDef *)IFRAM_BASE)
 #define SCANLINERAM ((SCANLINERAM_TypeDef *)SCANLINERAM_BASE)
+#define AUDIODIAG   ((AUDIODIAG_TypeDef *)AUDIODIAG_BASE)
 
 #endif
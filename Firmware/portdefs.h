@@ -56,11 +56,14 @@ typedef struct {
     __O uint32_t Enable;
   };
   __IO uint32_t TempDisable;
+  __I  uint32_t Wait;         // read stalls until an interrupt is pending
 } IRQController_TypeDef;
 
 #define IRQ_FLAG_VSYNC    (1U<<0)
 #define IRQ_FLAG_PAD      (1U<<1)
 #define IRQ_FLAG_IRRX     (1U<<2)
+#define IRQ_FLAG_VIDEOMODE (1U<<3)
+#define IRQ_FLAG_SPIDMA   (1U<<4)
 #define IRQ_FLAG_ANY      (1U<<31)  // read
 #define IRQ_FLAG_GLOBALEN (1U<<31)  // write
 
@@ -80,6 +83,8 @@ typedef union {
     __I uint32_t vhoffset0;
     __I uint32_t vactive_start1;
     __I uint32_t vhoffset1;
+    // reading clears the mode change IRQ flag
+    __I uint32_t videomode;
   };
   struct {
     __O uint32_t settings;
@@ -97,6 +102,10 @@ typedef union {
     __O uint32_t vactive_lines;
     // "virtual" register, any write clears IRQ flag
     __O uint32_t clear_irq;
+    __O uint32_t infoframe_set;
+    // any write activates the shadowed timing and matrix registers at the next VSync
+    __O uint32_t commit;
+    __O uint32_t mode_config;
   };
 } VideoInterface_TypeDef;
 
@@ -109,6 +118,13 @@ typedef union {
 #define VIDEOIF_FLAG_LD_PROGRESSIVE (1<<6)
 #define VIDEOIF_FLAG_LD_PAL         (1<<7)
 #define VIDEOIF_FLAG_LD_31KHZ       (1<<8)
+#define VIDEOIF_FLAG_COMMIT_PENDING (1<<9)
+
+#define VIDEOIF_VIDMODE_IN_SHIFT     0
+#define VIDEOIF_VIDMODE_OUT_SHIFT    4
+#define VIDEOIF_VIDMODE_MASK         7
+
+#define VIDEOIF_MODECFG_CROP486      (1<<0)
 
 #define VIDEOIF_BIT_SL_EVEN          2
 #define VIDEOIF_BIT_SL_ALTERNATE     3
@@ -126,6 +142,7 @@ typedef union {
 #define VIDEOIF_BIT_COLOR_RGBLIMITED 15 // not completely true, but useful
 #define VIDEOIF_BIT_COLOR_YCBCR      16
 #define VIDEOIF_BIT_REGENCSYNC       17
+#define VIDEOIF_BIT_LD_FACTOR        18 // two bits, line multiplier minus two
 #define VIDEOIF_BIT_SPOOFINTERLACE   31 // implemented in software, ignored by hardware
 
 #define VIDEOIF_SET_SL_EVEN          (1<<VIDEOIF_BIT_SL_EVEN)
@@ -149,6 +166,9 @@ typedef union {
 #define VIDEOIF_SET_ANALOG_MASK      (3 << VIDEOIF_BIT_ANALOGMODE)
 #define VIDEOIF_SET_ANALOG_SHIFT     VIDEOIF_BIT_ANALOGMODE
 
+#define VIDEOIF_SET_LD_FACTOR_SHIFT  VIDEOIF_BIT_LD_FACTOR
+#define VIDEOIF_SET_LD_FACTOR_MASK   (3 << VIDEOIF_SET_LD_FACTOR_SHIFT)
+
 #define VIDEOIF_SET_COLORMODE_SHIFT  VIDEOIF_BIT_COLOR_RGBLIMITED
 #define VIDEOIF_SET_COLORMODE_MASK   (3 << VIDEOIF_SET_COLORMODE_SHIFT)
 #define VIDEOIF_SET_COLORMODE_RGBF   (0 << VIDEOIF_SET_COLORMODE_SHIFT)
@@ -185,14 +205,29 @@ typedef struct {
   __IO uint32_t spi_data32;
   __IO uint32_t icap_data;
   __O  uint32_t icap_flags;
+  __IO uint32_t dma_command;  // command byte and 24 bit flash address
+  __IO uint32_t dma_control;  // write starts a transfer, read clears the done flag
 } SPICAP_TypeDef;
 
 #define SPI_FLAG_CSEL     (1 << 0)
 #define SPI_FLAG_BUSY     (1 << 1)
+#define SPI_FLAG_FLASHBUSY (1 << 2) // flash cache waits for WIP before reading
 #define ICAP_FLAG_CLOCK   (1 << 0)
 #define ICAP_FLAG_CE      (1 << 1)
 #define ICAP_FLAG_WRITE   (1 << 2)
 #define ICAP_FLAG_BUSY    (1 << 0)
+#define SPI_DMA_WRITE     (1U << 31) // buffer to flash, length in bits 0-8
+#define SPI_DMA_BUSY      (1 << 0)
+#define SPI_DMA_DONE      (1 << 1)
+
+/* --- SPI DMA buffer --- */
+
+#define SPIBUF_SIZE 256
+
+typedef struct {
+  // word access only, bytes are stored big-endian
+  __IO uint32_t data[SPIBUF_SIZE / 4];
+} SPIBUF_TypeDef;
 
 /* --- IR receiver --- */
 
@@ -206,12 +241,42 @@ typedef struct {
 #define IRRX_BUTTON     (1 << 10)
 #define IRRX_IRQ        (1 << 11)
 
+/* --- flash cache --- */
+
+typedef struct {
+  __IO uint32_t hits;       // write: clear both counters
+  __I  uint32_t misses;
+  __O  uint32_t invalidate; // write: discard all cached lines
+} FlashCache_TypeDef;
+
+/* address of the flash in the CPU address space */
+#define FLASHCACHE_WINDOW  0x800000
+
+/* places a function in the flash, must not be called with the flash selected */
+#define FLASHCODE __attribute__((section(".xip.text")))
+
 /* --- OSD RAM --- */
 
 typedef struct {
   __IO uint32_t data[2048];
 } OSDRAM_TypeDef;
 
+/* --- OSD blitter --- */
+
+typedef struct {
+  __IO uint32_t dest;    // character cell index
+  __IO uint32_t source;  // character cell index, for copies
+  __IO uint32_t size;    // (height << 8) | width
+  __IO uint32_t value;   // fill value or operand
+  __IO uint32_t command; // write starts an operation
+} OSDBlitter_TypeDef;
+
+/* any access to OSD RAM or blitter waits until the current operation is done */
+#define OSDBLIT_OP_FILL 0 // dest = value
+#define OSDBLIT_OP_COPY 1 // dest = source
+#define OSDBLIT_OP_OR   2 // dest |= value
+#define OSDBLIT_OP_AND  3 // dest &= value
+
 /* --- mixing it all together --- */
 
 // ffff8000: module-specific
@@ -223,6 +288,9 @@ typedef struct {
 #define PADREADER_BASE     (PERIPH_BASE + 0x200)
 #define SPICAP_BASE        (PERIPH_BASE + 0x300)
 #define IRRX_BASE          (PERIPH_BASE + 0x400)
+#define FLASHCACHE_BASE    (PERIPH_BASE + 0x500)
+#define OSDBLITTER_BASE    (PERIPH_BASE + 0x600)
+#define SPIBUF_BASE        (PERIPH_BASE + 0x700)
 
 #define IRQController ((IRQController_TypeDef *)IRQController_BASE)
 #define VIDEOIF       ((VideoInterface_TypeDef *)VIDEOIF_BASE)
@@ -230,5 +298,8 @@ typedef struct {
 #define OSDRAM        ((OSDRAM_TypeDef *)OSDRAM_BASE)
 #define SPICAP        ((SPICAP_TypeDef *)SPICAP_BASE)
 #define IRRX          ((IRRX_TypeDef *)IRRX_BASE)
+#define FLASHCACHE    ((FlashCache_TypeDef *)FLASHCACHE_BASE)
+#define OSDBLITTER    ((OSDBlitter_TypeDef *)OSDBLITTER_BASE)
+#define SPIBUF        ((SPIBUF_TypeDef *)SPIBUF_BASE)
 
 #endif
@@ -32,6 +32,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "infoframe.h"
+#include "modelog.h"
 #include "pad.h"
 #include "portdefs.h"
 #include "settings.h"
@@ -55,11 +56,23 @@ static const VideoParameters_t ModeParameters[] = {
   // no entry for non-standard modes needed, array isn't accessed when one is used
 };
 
+/* 3x/4x line multiplied 240p/288p/480i/576i, indexed by [factor - 3][PAL] */
+/* horizontal values are in pipeline pixels, same as 480p/576p            */
+static const VideoParameters_t MultipliedParameters[2][2] = {
+  { { 62, 60,  720, 5, 20 },   // 720p60-ish (960x720 on the DVI output)
+    { 64, 68,  864, 5, 36 } }, // 864p50
+  { { 62, 60,  960, 6, 40 },   // 960p60
+    { 64, 68, 1152, 6, 48 } }, // 1152p50
+};
+
 static video_mode_t prev_inmode  = VIDMODE_NONSTANDARD;
 static video_mode_t prev_outmode = VIDMODE_NONSTANDARD;
+static unsigned int prev_factor  = 1;
 static uint32_t     prev_xres    = 0;
 static uint32_t     prev_yres    = 0;
 static uint8_t      disable_frames;
+static uint32_t     window_modes;
+static bool         input_blanked;
 
 static uint32_t min(uint32_t a, uint32_t b) {
   if (a < b) {
@@ -70,16 +83,19 @@ static uint32_t min(uint32_t a, uint32_t b) {
 }
 
 static void check_modechange(uint32_t cur_xres, uint32_t cur_yres,
-                             video_mode_t inmode, video_mode_t outmode) {
+                             video_mode_t inmode, video_mode_t outmode,
+                             unsigned int factor) {
   /* check for changes of the input/output modes */
-  bool inmode_changed  = false;
-  bool outmode_changed = false;
+  bool     inmode_changed  = false;
+  bool     outmode_changed = false;
+  uint32_t modes           = (factor << 8) | (inmode << 4) | outmode;
 
   if (inmode != prev_inmode) {
     inmode_changed = true;
   }
 
-  if (outmode != prev_outmode) {
+  /* 3x/4x are classified as 480p/576p, but change the output timing */
+  if (outmode != prev_outmode || factor != prev_factor) {
     outmode_changed = true;
   }
 
@@ -87,6 +103,12 @@ static void check_modechange(uint32_t cur_xres, uint32_t cur_yres,
     /* still disabled, count down */
     disable_frames--;
 
+    if (modes != window_modes) {
+      window_modes = modes;
+      modelog_add(MODELOG_UNSTABLE, inmode, outmode, factor,
+                  cur_xres, cur_yres, disable_frames);
+    }
+
     if (disable_frames == 0) {
       /* done, reenable */
       if (inmode_changed) {
@@ -94,11 +116,12 @@ static void check_modechange(uint32_t cur_xres, uint32_t cur_yres,
       }
 
       if (outmode_changed) {
-        update_infoframe(outmode);
+        update_infoframe(outmode, factor);
       }
 
       prev_inmode  = inmode;
       prev_outmode = outmode;
+      prev_factor  = factor;
       /* enable output again */
       if ((video_settings_global & VIDEOIF_SET_COLORMODE_MASK) ==
           VIDEOIF_SET_COLORMODE_Y422) {
@@ -106,17 +129,25 @@ static void check_modechange(uint32_t cur_xres, uint32_t cur_yres,
       } else {
         VIDEOIF->osd_bg = osdbg_settings;
       }
+
+      modelog_add(MODELOG_ENABLE, inmode, outmode, factor,
+                  cur_xres, cur_yres, 0);
     }
   } else if (inmode_changed || outmode_changed) {
     /* first detection of mode change, disable output for three frames */
     /* (avoids missed mode switches on some TVs, e.g. from 480i to 240p) */
     disable_frames = 3;
+    window_modes   = modes;
     VIDEOIF->osd_bg = VIDEOIF_OSDBG_DISABLE_OUTPUT;
+    modelog_add(MODELOG_CHANGE, inmode, outmode, factor,
+                cur_xres, cur_yres, disable_frames);
   } else if (prev_xres != cur_xres || prev_yres != cur_yres) {
     /* input resolution changed, just set videochange to trigger resbox */
     pad_set_irq(PAD_VIDEOCHANGE);
     prev_xres = cur_xres;
     prev_yres = cur_yres;
+    modelog_add(MODELOG_RESOLUTION, inmode, outmode, factor,
+                cur_xres, cur_yres, 0);
   }
 }
 
@@ -127,14 +158,22 @@ void update_reblanker(void) {
   /* don't do anything while GC has disabled its output  */
   /* (fixes menu transitions in Eternal Darkness and RE0) */
   if (cur_xres == 0 || cur_yres == 0) {
+    if (!input_blanked) {
+      input_blanked = true;
+      modelog_add(MODELOG_BLANK, prev_inmode, prev_outmode, prev_factor,
+                  cur_xres, cur_yres, disable_frames);
+    }
     return;
   }
 
+  input_blanked = false;
+
   /* set up reblanker */
   video_mode_t cur_inmode  = detect_input_videomode();
   video_mode_t cur_outmode = detect_output_videomode();
+  unsigned int factor      = line_multiplier(cur_inmode);
 
-  check_modechange(cur_xres, cur_yres, cur_inmode, cur_outmode);
+  check_modechange(cur_xres, cur_yres, cur_inmode, cur_outmode, factor);
 
   /* if input mode is nonstandard, enable bypass instead of trying to fix it */
   if (cur_inmode == VIDMODE_NONSTANDARD) {
@@ -142,6 +181,10 @@ void update_reblanker(void) {
     return;
   }
 
+  const VideoParameters_t *params = &ModeParameters[cur_outmode];
+  if (factor > 2)
+    params = &MultipliedParameters[factor - 3][cur_outmode & 1];
+
   int32_t actual_x_shift = screen_x_shift << 2;
   int32_t actual_y_shift = screen_y_shift;
   if (!(video_settings_global & VIDEOIF_SET_ENABLERESYNC)) {
@@ -172,8 +215,8 @@ void update_reblanker(void) {
   VIDEOIF->hactive_end_start = h_act_start | (h_act_end << 16);
 
   /* shift hsync to nominal location */
-  int32_t hsync_end   = h_act_start - ModeParameters[cur_outmode].HBackporch;
-  int32_t hsync_start = hsync_end   - ModeParameters[cur_outmode].HSync;
+  int32_t hsync_end   = h_act_start - params->HBackporch;
+  int32_t hsync_start = hsync_end   - params->HSync;
 
   if (hsync_end <= 0)
     hsync_end += htotal;
@@ -186,12 +229,9 @@ void update_reblanker(void) {
   }
 
   /* center image vertically */
-  int32_t ld_yres = cur_yres; // y resolution after linedoubler
-  if (video_settings[cur_inmode] & VIDEOIF_SET_LD_ENABLE) {
-    ld_yres *= 2;
-  }
+  int32_t ld_yres = cur_yres * factor; // y resolution after linedoubler
 
-  int32_t vactive = ModeParameters[cur_outmode].VActive;
+  int32_t vactive = params->VActive;
   int32_t v_pad_front = (vactive - ld_yres) / 2;
 
   /* limit shift to available padding space */
@@ -210,7 +250,7 @@ void update_reblanker(void) {
   }
 
   /* v active start/end are relative to output vsync */
-  uint32_t v_act_start = ModeParameters[cur_outmode].VSync + ModeParameters[cur_outmode].VBackporch;
+  uint32_t v_act_start = params->VSync + params->VBackporch;
 
   VIDEOIF->vactive_start = v_act_start;
   VIDEOIF->vactive_lines = vactive - 1;
@@ -230,8 +270,8 @@ void update_reblanker(void) {
   }
 
   int32_t vsync_end = hsync_start + vhoffset + htotal *
-    (v_act_start_in - ModeParameters[cur_outmode].VBackporch);
-  int32_t vsync_start = vsync_end - ModeParameters[cur_outmode].VSync * htotal;
+    (v_act_start_in - params->VBackporch);
+  int32_t vsync_start = vsync_end - params->VSync * htotal;
 
   /* wrap */
   if (vsync_start <= 0)
@@ -241,4 +281,7 @@ void update_reblanker(void) {
 
   VIDEOIF->vsync_start = vsync_start;
   VIDEOIF->vsync_end   = vsync_end;
+
+  /* activate all timing values together at the next VSync */
+  VIDEOIF->commit = 1;
 }
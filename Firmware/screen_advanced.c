@@ -45,6 +45,8 @@ enum {
   MENUITEM_SPOOFINTERLACE,
   MENUITEM_COLORMODE,
   MENUITEM_SAMPLERATEHACK,
+  MENUITEM_AUDIODIAG,
+  MENUITEM_MODELOG,
   MENUITEM_EXIT
 };
 
@@ -72,18 +74,20 @@ static void advanced_draw(menu_t *menu);
 
 static menuitem_t advanced_items[] = {
   { "Chroma Interpolation", &value_chromainterpol, 1, 0 },
-  { "Fix Resolution",       &value_reblanking,     2, 0 },
-  { "Fix Sync Timing",      &value_resync,         3, 0 },
+  { "Fix Resolution",       &value_reblanking,     2, 0, MENU_ITEM(MENUITEM_RESYNC) },
+  { "Fix Sync Timing",      &value_resync,         3, 0, MENU_ITEM(MENUITEM_RESYNC) },
   { "Regenerate CSync",     &value_regencsync,     4, 0 },
   { "Digital Color Format", &value_colormode,      5, 0 },
   { "Report 240p as 480i",  &value_spoofinterlace, 6, 0 },
   { "Sample Rate Hack",     &value_sampleratehack, 7, 0 },
-  { "Exit",                 NULL,                  9, 0 },
+  { "Audio Diagnostics...", NULL,                  8, 0 },
+  { "Mode Change Log...",   NULL,                  9, 0 },
+  { "Exit",                 NULL,                 10, 0 },
 };
 
 static menu_t advanced_menu = {
   7, 9,
-  31, 11,
+  31, 12,
   advanced_draw,
   sizeof(advanced_items) / sizeof(*advanced_items),
   advanced_items
@@ -112,7 +116,18 @@ static void advanced_draw(menu_t *menu) {
 }
 
 void screen_advanced(void) {
-  osd_clrscr();
-  menu_draw(&advanced_menu);
-  menu_exec(&advanced_menu, 0);
+  int current_item = 0;
+
+  while (1) {
+    osd_clrscr();
+    menu_draw(&advanced_menu);
+    current_item = menu_exec(&advanced_menu, current_item);
+
+    if (current_item == MENUITEM_AUDIODIAG)
+      screen_audiodiag();
+    else if (current_item == MENUITEM_MODELOG)
+      screen_modelog();
+    else
+      return;
+  }
 }
@@ -42,11 +42,11 @@
 /* ----- per-mode settings menu ----- */
 
 static menuitem_t modeset_items[] = {
-  { "Linedoubler",            &modeset_value_linedoubler, 2, 0 }, // 0
-  { "Scanline Profile",       &modeset_value_slprofile,   3, 0 }, // 1
-  { " Apply to",              &modeset_value_sleven,      4, 0 }, // 2
-  { " Alternating Scanlines", &modeset_value_slalt,       5, 0 }, // 3
-  { "Exit",                   NULL,                       7, 0 }, // 4
+  { "Line Multiplier",        &modeset_value_linedoubler, 2, 0, MODESET_DEPENDS_LD }, // 0
+  { "Scanline Profile",       &modeset_value_slprofile,   3, 0, MODESET_DEPENDS_SL }, // 1
+  { " Apply to",              &modeset_value_sleven,      4, 0, 0 },                  // 2
+  { " Alternating Scanlines", &modeset_value_slalt,       5, 0, 0 },                  // 3
+  { "Exit",                   NULL,                       7, 0, 0 },                  // 4
 };
 
 static menu_t modeset_menu = {
@@ -0,0 +1,165 @@
+/* GCVideo DVI Firmware
+
+   Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+   THE POSSIBILITY OF SUCH DAMAGE.
+
+
+   screen_audiodiag.c: Audio path statistics
+
+
+   This screen runs from the flash window, so it must not use static data.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "irq.h"
+#include "osd.h"
+#include "pad.h"
+#include "portdefs.h"
+#include "screens.h"
+
+#define COL_NOW   20
+#define COL_TOTAL 32
+
+typedef struct {
+  unsigned int seconds;
+  unsigned int last_rate;
+  unsigned int rate_min;
+  unsigned int rate_max;
+  unsigned int rate_changes;
+  unsigned int peak_left;
+  unsigned int peak_right;
+  unsigned int clipped;
+  unsigned int glitches[3];
+} audiototals_t;
+
+/* peak values are magnitudes, full scale is 0x8000 */
+static unsigned int peak_percent(unsigned int peak) {
+  return (peak * 100) >> 15;
+}
+
+static void print_row(unsigned int line, const char *name,
+                      unsigned int now, unsigned int total) {
+  osd_clearline(line, ATTRIB_DIM_BG);
+  osd_putsat(3, line, name);
+  osd_gotoxy(COL_NOW, line);
+  printf("%8u", now);
+  osd_gotoxy(COL_TOTAL, line);
+  printf("%8u", total);
+}
+
+static void update_screen(audiototals_t *totals) {
+  unsigned int rate    = AUDIODIAG->samplerate;
+  uint32_t     peak    = AUDIODIAG->peak;
+  unsigned int clipped = AUDIODIAG->clipped;
+  unsigned int glitches[3];
+
+  glitches[0] = AUDIODIAG->bclock_glitches;
+  glitches[1] = AUDIODIAG->lrclock_glitches;
+  glitches[2] = AUDIODIAG->adata_glitches;
+
+  /* accumulate */
+  if (totals->seconds == 0) {
+    totals->rate_min = rate;
+    totals->rate_max = rate;
+  } else {
+    if (rate < totals->rate_min)
+      totals->rate_min = rate;
+    if (rate > totals->rate_max)
+      totals->rate_max = rate;
+
+    /* ignore the jitter caused by the measurement window */
+    unsigned int diff = (rate > totals->last_rate) ?
+      rate - totals->last_rate : totals->last_rate - rate;
+    if (diff > totals->last_rate / 100)
+      totals->rate_changes++;
+  }
+
+  totals->seconds++;
+  totals->last_rate = rate;
+
+  if ((peak >> 16) > totals->peak_left)
+    totals->peak_left = peak >> 16;
+  if ((peak & 0xffff) > totals->peak_right)
+    totals->peak_right = peak & 0xffff;
+
+  totals->clipped += clipped;
+  for (unsigned int i = 0; i < 3; i++) {
+    totals->glitches[i] += glitches[i];
+  }
+
+  /* draw */
+  osd_clearline(7, ATTRIB_DIM_BG);
+  osd_putsat(3, 7, "Sample rate");
+  osd_gotoxy(COL_NOW, 7);
+  printf("%8u", rate);
+  osd_gotoxy(COL_TOTAL - 4, 7);
+  printf("%6u-%u", totals->rate_min, totals->rate_max);
+
+  osd_clearline(8, ATTRIB_DIM_BG);
+  osd_putsat(3, 8, "Rate changes");
+  osd_gotoxy(COL_TOTAL, 8);
+  printf("%8u", totals->rate_changes);
+
+  print_row( 9, "Peak left  (%)",  peak_percent(peak >> 16),    peak_percent(totals->peak_left));
+  print_row(10, "Peak right (%)",  peak_percent(peak & 0xffff), peak_percent(totals->peak_right));
+  print_row(11, "Full scale",      clipped,                     totals->clipped);
+
+  print_row(13, "BClock glitches",  glitches[0], totals->glitches[0]);
+  print_row(14, "LRClock glitches", glitches[1], totals->glitches[1]);
+  print_row(15, "AData glitches",   glitches[2], totals->glitches[2]);
+
+  osd_clearline(17, ATTRIB_DIM_BG);
+  osd_gotoxy(3, 17);
+  printf("Measured for %u seconds", totals->seconds);
+}
+
+void screen_audiodiag(void) {
+  audiototals_t totals = { 0 };
+
+  osd_clrscr();
+  for (unsigned int i = 2; i <= 18; i++) {
+    osd_clearline(i, ATTRIB_DIM_BG);
+  }
+  osd_putsat(14, 3, "Audio Diagnostics");
+  osd_putsat(COL_NOW + 5,   5, "Now");
+  osd_putsat(COL_TOTAL + 3, 5, "Total");
+
+  pad_wait_for_release();
+
+  /* statistics are updated once per second */
+  uint32_t sequence = AUDIODIAG->sequence;
+
+  while (!(pad_buttons & PAD_ALL)) {
+    if (AUDIODIAG->sequence != sequence) {
+      sequence = AUDIODIAG->sequence;
+      update_screen(&totals);
+    }
+
+    irq_wait();
+  }
+
+  pad_clear(PAD_ALL);
+}
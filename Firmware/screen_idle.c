@@ -33,7 +33,9 @@
 #include <stddef.h>
 #include <stdio.h>
 #include "menu.h"
+#include "irq.h"
 #include "osd.h"
+#include "overlay.h"
 #include "pad.h"
 #include "portdefs.h"
 #include "screens.h"
@@ -52,6 +54,9 @@ void screen_idle(void) {
   osd_clrscr();
 
   while (1) {
+    /* sleep until the next vsync or pad event */
+    irq_wait();
+
     tick_t now = getticks();
 
     /* check for menu button combination on controller */
@@ -113,7 +118,8 @@ void run_mainloop(void) {
     screen_idle();
     if (pad_buttons & IRBUTTON_LONG) {
       pad_clear(IRBUTTON_LONG);
-      screen_irconfig(true);
+      if (overlay_load(OVERLAY_IRCONFIG))
+        screen_irconfig(true);
     } else
       screen_mainmenu();
   }
@@ -33,6 +33,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
+#include "irq.h"
 #include "irrx.h"
 #include "menu.h"
 #include "osd.h"
@@ -70,7 +71,7 @@ void screen_irconfig(bool in_box) {
 
     /* wait for input */
     while (!ir_gotcommand && !(pad_buttons & (IRBUTTON_SHORT | PAD_ALL_GC)))
-      ;
+      irq_wait();
 
     if (pad_buttons & (IRBUTTON_SHORT | PAD_ALL_GC))
       break;
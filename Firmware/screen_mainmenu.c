@@ -35,6 +35,7 @@
 #include "menu.h"
 #include "modeset_common.h"
 #include "osd.h"
+#include "overlay.h"
 #include "pad.h"
 #include "portdefs.h"
 #include "screens.h"
@@ -57,7 +58,7 @@ static menuitem_t mainmenu_items[];
 /* --- menu items --- */
 
 static menuitem_t mainmenu_items[] = {
-  { "Linedoubler",            &modeset_value_linedoubler, 2, 0 }, // 0
+  { "Line Multiplier",        &modeset_value_linedoubler, 2, 0 }, // 0
   { "Scanline Profile",       &modeset_value_slprofile,   3, 0 }, // 1
   { " Apply to",              &modeset_value_sleven,      4, 0 }, // 2
   { " Alternating Scanlines", &modeset_value_slalt,       5, 0 }, // 3
@@ -119,12 +120,12 @@ static void mainmenu_draw(menu_t *menu) {
 
   uint32_t outputpixels = 720;
   uint32_t outputlines  = video_out_lines[current_videomode];
+  unsigned int factor   = line_multiplier(current_videomode);
   bool interlaced = false;
 
   if (video_settings_global & VIDEOIF_SET_ENABLEREBLANK) {
-    if (current_videomode <= VIDMODE_576i &&
-        (video_settings[current_videomode] & VIDEOIF_SET_LD_ENABLE))
-      outputlines *= 2;
+    if (factor > 1)
+      outputlines = (outputlines & ~1) * factor;
 
     if (outputlines & 1) {
       outputlines *= 2;
@@ -137,9 +138,8 @@ static void mainmenu_draw(menu_t *menu) {
     outputpixels = VIDEOIF->xres;
     outputlines  = VIDEOIF->yres;
 
-    if (current_videomode <= VIDMODE_576i &&
-        (video_settings[current_videomode] & VIDEOIF_SET_LD_ENABLE)) {
-      outputlines *= 2;
+    if (factor > 1) {
+      outputlines *= factor;
       interlaced = false;
     } else {
       if (!(VIDEOIF->flags & VIDEOIF_FLAG_IN_PROGRESSIVE)) {
@@ -149,6 +149,10 @@ static void mainmenu_draw(menu_t *menu) {
     }
   }
 
+  /* 3x repeats every third pixel on the 54MHz DVI output */
+  if (factor == 3)
+    outputpixels = outputpixels * 4 / 3;
+
   printf("Out: %3dx%3d%c%d",
          outputpixels,
          outputlines,
@@ -175,7 +179,8 @@ void screen_mainmenu(void) {
       return;
 
     case MENUITEM_SLSET:
-      screen_scanlines();
+      if (overlay_load(OVERLAY_SCANLINES))
+        screen_scanlines();
       break;
 
     case MENUITEM_PICTURESET:
@@ -191,7 +196,8 @@ void screen_mainmenu(void) {
       break;
 
     case MENUITEM_VIEWALL:
-      screen_allmodes();
+      if (overlay_load(OVERLAY_ALLMODES))
+        screen_allmodes();
       break;
 
     case MENUITEM_ADVANCED:
@@ -199,7 +205,8 @@ void screen_mainmenu(void) {
       break;
 
     case MENUITEM_ABOUT:
-      screen_about();
+      if (overlay_load(OVERLAY_ABOUT))
+        screen_about();
       break;
 
     case MENUITEM_STORE:
@@ -0,0 +1,184 @@
+/* GCVideo DVI Firmware
+
+   Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+   THE POSSIBILITY OF SUCH DAMAGE.
+
+
+   screen_modelog.c: Video mode change event log
+
+
+   This screen runs from the flash window, so it must not use static data.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "irq.h"
+#include "modelog.h"
+#include "osd.h"
+#include "pad.h"
+#include "portdefs.h"
+#include "screens.h"
+#include "spiflash.h"
+#include "vsync.h"
+
+#define FIRST_ROW   6
+#define STATUS_LINE 20
+
+static const char event_names[][6] = {
+  "", "Mode", "Flap", "Out", "Res", "Blank"
+};
+
+static const char short_mode_names[][5] = {
+  "240p", "288p", "480i", "576i", "480p", "576p", "NStd"
+};
+
+static void print_entry(unsigned int line, const modelog_entry_t *entry) {
+  unsigned int seconds = entry->ticks / HZ;
+  unsigned int hundredths = (entry->ticks - seconds * HZ) * 100 / HZ;
+  unsigned int inmode  = entry->modes >> 4;
+  unsigned int outmode = entry->modes & 0x0f;
+  unsigned int lines   = 0;
+
+  if (entry->event > MODELOG_BLANK || inmode >= VIDMODE_COUNT || outmode >= VIDMODE_COUNT)
+    return;
+
+  if (entry->htotal != 0)
+    lines = entry->vtotal / entry->htotal;
+
+  /* the time column wraps after 10000 seconds to keep the line width */
+  osd_gotoxy(0, line);
+  printf("%4u.%02u %-5s %4s>%-4s x%u %3ux%-3u %4u/%-3u %u",
+         seconds % 10000, hundredths, event_names[entry->event],
+         short_mode_names[inmode], short_mode_names[outmode], entry->factor,
+         entry->xres, entry->yres, entry->htotal, lines,
+         entry->disable_frames);
+}
+
+/* shows the live log or the one at flash_address, newest entry first */
+static void draw_log(uint32_t flash_address) {
+  modelog_header_t header;
+  modelog_entry_t  entry;
+  unsigned int     index, valid;
+
+  for (unsigned int i = 0; i < MODELOG_ENTRIES; i++) {
+    osd_clearline(FIRST_ROW + i, ATTRIB_DIM_BG);
+  }
+
+  osd_clearline(4, ATTRIB_DIM_BG);
+  if (flash_address) {
+    /* entries are read one by one */
+    spiflash_read_block(&header, flash_address, sizeof(header));
+    osd_gotoxy(3, 4);
+    printf("Saved log, stored after %u s", header.saved_ticks / HZ);
+  } else {
+    header = modelog.header;
+    osd_putsat(3, 4, "Live log");
+  }
+
+  valid = header.count;
+  if (valid > MODELOG_ENTRIES)
+    valid = MODELOG_ENTRIES;
+
+  index = header.next;
+  for (unsigned int i = 0; i < valid; i++) {
+    if (index == 0)
+      index = MODELOG_ENTRIES;
+    index--;
+
+    if (flash_address) {
+      spiflash_read_block(&entry, flash_address + offsetof(modelog_t, entries) +
+                          index * sizeof(modelog_entry_t), sizeof(entry));
+    } else {
+      entry = modelog.entries[index];
+    }
+
+    print_entry(FIRST_ROW + i, &entry);
+  }
+
+  if (valid == 0)
+    osd_putsat(3, FIRST_ROW, "No mode changes recorded");
+}
+
+static void show_status(const char *text) {
+  osd_clearline(STATUS_LINE, ATTRIB_DIM_BG);
+  osd_putsat(3, STATUS_LINE, text);
+}
+
+void screen_modelog(void) {
+  uint32_t flash_address = 0;
+  uint32_t count;
+
+  osd_clrscr();
+  for (unsigned int i = 2; i <= STATUS_LINE + 1; i++) {
+    osd_clearline(i, ATTRIB_DIM_BG);
+  }
+  osd_putsat(14, 2, "Mode Change Log");
+  osd_putsat(0, FIRST_ROW - 1, "   Time Event   In>Out  LM   Res   HTot/Ln  D");
+  osd_putsat(3, STATUS_LINE - 1, "X: Live/saved log  Y: Save log");
+
+  pad_wait_for_release();
+
+  count = modelog_count();
+  draw_log(0);
+
+  while (1) {
+    if (pad_buttons & PAD_X) {
+      pad_clear(PAD_X);
+      show_status("");
+
+      if (flash_address) {
+        flash_address = 0;
+      } else {
+        flash_address = modelog_saved_address();
+        if (!flash_address)
+          show_status("No saved log found");
+      }
+
+      count = modelog_count();
+      draw_log(flash_address);
+
+    } else if (pad_buttons & PAD_Y) {
+      pad_clear(PAD_Y);
+
+      /* runs from BRAM, flash is idle again when it returns */
+      if (modelog_save())
+        show_status("Log saved until settings are stored");
+      else
+        show_status("No free page, store settings first");
+
+    } else if (pad_buttons & PAD_ALL) {
+      break;
+
+    } else if (!flash_address && modelog_count() != count) {
+      count = modelog_count();
+      draw_log(0);
+    }
+
+    irq_wait();
+  }
+
+  pad_clear(PAD_ALL);
+}
@@ -33,6 +33,7 @@
 #include <stddef.h>
 #include "menu.h"
 #include "osd.h"
+#include "overlay.h"
 #include "pad.h"
 #include "portdefs.h"
 #include "screens.h"
@@ -94,7 +95,8 @@ void screen_osdsettings(void) {
         return;
 
       case MENUITEM_IRCONFIG:
-        screen_irconfig(true);
+        if (overlay_load(OVERLAY_IRCONFIG))
+          screen_irconfig(true);
         break;
     }
   }
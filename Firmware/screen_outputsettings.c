@@ -64,6 +64,7 @@ enum {
 static int get_dvienhanced(void) { return video_settings_global & VIDEOIF_SET_DVIENHANCED; }
 static int get_volume(void)      { return audio_volume;                                    }
 static int get_mute(void)        { return audio_mute;                                      }
+static int get_crop486(void)     { return crop_486_to_480;                                 }
 
 static int get_analogmode(void) {
   uint32_t val = (video_settings_global & VIDEOIF_SET_ANALOG_MASK)
@@ -85,6 +86,12 @@ static bool set_dvienhanced(int value) {
   return true;
 }
 
+static bool set_crop486(int value) {
+  crop_486_to_480 = value;
+  update_mode_config();
+  return false;
+}
+
 static bool set_volume(int value) {
   audio_volume = value;
   if (!audio_mute)
@@ -111,8 +118,7 @@ static bool set_analogmode(int value) {
 
 static valueitem_t value_cabledetect = { VALTYPE_BOOL, true,
                                          { .field = { NULL, VIDEOIF_BIT_CABLEDETECT, 0, VIFLAG_ALLMODES }} };
-static valueitem_t value_crop486     = { VALTYPE_BOOL, true,
-                                         { .field = { &crop_486_to_480, 8, 24, 0 }} };
+static valueitem_t value_crop486     = { VALTYPE_BOOL, false, {{ get_crop486,     set_crop486     }} };
 static valueitem_t value_rgblimited  = { VALTYPE_BOOL, true,
                                          { .field = { NULL, VIDEOIF_BIT_COLOR_RGBLIMITED, 0, VIFLAG_ALLMODES | VIFLAG_COLORMATRIX }} };
 static valueitem_t value_169         = { VALTYPE_BOOL, true,
@@ -98,14 +98,21 @@ static valueitem_t value_slvalue    = { VALTYPE_FIXPOINT1, false, {{ get_slvalue
 
 static void scanline_draw(menu_t *menu);
 
+#define SL_DEPENDS_ALL   (MENU_ITEM(MENUITEM_CUSTOM)    | MENU_ITEM(MENUITEM_STRENGTH) | \
+                          MENU_ITEM(MENUITEM_HYBRID)    | MENU_ITEM(MENUITEM_LUMINANCE) | \
+                          MENU_ITEM(MENUITEM_VALUE))
+#define SL_DEPENDS_FLAGS (MENU_ITEM(MENUITEM_STRENGTH)  | MENU_ITEM(MENUITEM_HYBRID) | \
+                          MENU_ITEM(MENUITEM_VALUE))
+#define SL_DEPENDS_VALUE (MENU_ITEM(MENUITEM_VALUE))
+
 static menuitem_t scanline_items[] = {
-  { "Scanline Profile", &value_profile,    1, 0 },
-  { " Full Custom",     &value_custom,     2, 0 },
-  { " Brightness",      &value_slstrength, 3, 0 },
-  { " Hybrid Factor",   &value_hybrid,     4, 0 },
-  { " Luminance",       &value_slluma,     5, 0 },
-  { " Applied Factor",  &value_slvalue,    6, MENU_FLAG_DISABLED },
-  { "Exit",             NULL,              8, 0 },
+  { "Scanline Profile", &value_profile,    1, 0,                  SL_DEPENDS_ALL   },
+  { " Full Custom",     &value_custom,     2, 0,                  SL_DEPENDS_FLAGS },
+  { " Brightness",      &value_slstrength, 3, 0,                  SL_DEPENDS_VALUE },
+  { " Hybrid Factor",   &value_hybrid,     4, 0,                  SL_DEPENDS_VALUE },
+  { " Luminance",       &value_slluma,     5, 0,                  SL_DEPENDS_VALUE },
+  { " Applied Factor",  &value_slvalue,    6, MENU_FLAG_DISABLED, 0 },
+  { "Exit",             NULL,              8, 0,                  0 },
 };
 
 static menu_t scanline_menu = {
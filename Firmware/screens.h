@@ -35,9 +35,11 @@
 void screen_about(void);
 void screen_advanced(void);
 void screen_allmodes(void);
+void screen_audiodiag(void);
 void screen_idle(void);
 void screen_irconfig(bool in_box);
 void screen_mainmenu(void);
+void screen_modelog(void);
 void screen_osdsettings(void);
 void screen_outputsettings(void);
 void screen_picturesettings(void);
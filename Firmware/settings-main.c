@@ -34,6 +34,7 @@
 #include <string.h>
 #include "colormatrix.h"
 #include "irrx.h"
+#include "osd.h"
 #include "portdefs.h"
 #include "spiflash.h"
 #include "vsync.h"
@@ -81,17 +82,6 @@ const char *mode_names[VIDMODE_COUNT] = {
   "NonStd"
 };
 
-static const unsigned char vidmode_by_flags[] = {
-  VIDMODE_480i, // none
-  VIDMODE_240p, // prog
-  VIDMODE_576i, // pal
-  VIDMODE_288p, // pal+prog
-  VIDMODE_480p, // 31khz - technically 960i
-  VIDMODE_480p, // prog+31khz
-  VIDMODE_576p, // pal+31khz - technically 1152i
-  VIDMODE_576p, // pal+prog+31khz
-};
-
 uint32_t     video_settings[VIDMODE_COUNT];
 uint32_t     video_settings_global;
 uint32_t     osdbg_settings;
@@ -135,67 +125,24 @@ void update_scanlines(void) {
   }
 }
 
-video_mode_t detect_videomode(bool inputmode) {
-  uint32_t cur_flags = VIDEOIF->flags;
-  uint32_t cur_yres  = VIDEOIF->yres;
-  uint32_t htotal    = VIDEOIF->htotal;
-  uint32_t vtotal    = VIDEOIF->vtotal & 0xfffff;
-
-  if (inputmode) {
-    cur_flags &= (VIDEOIF_FLAG_IN_PROGRESSIVE | VIDEOIF_FLAG_IN_PAL | VIDEOIF_FLAG_IN_31KHZ);
-  } else {
-    cur_flags = (cur_flags & (VIDEOIF_FLAG_LD_PROGRESSIVE | VIDEOIF_FLAG_LD_PAL | VIDEOIF_FLAG_LD_31KHZ))
-      >> 6;
-  }
-
-  if (htotal > 870 || htotal < 800 || VIDEOIF->xres > 720 ||
-      vtotal > 540000 || cur_yres > 576 )
-    return VIDMODE_NONSTANDARD;
-
-  /* GBI 486i/p to 480i/p crop */
-  if (crop_486_to_480) {
-    if (cur_yres == 486) {
-      cur_yres = 480;
-    }
-    if (cur_yres == 243) {
-      cur_yres = 240;
-    }
-  }
-
-  /* figure out the maximum number of lines based on mode flags */
-  unsigned int max_lines = 240;
-
-  if (cur_flags & VIDEOIF_FLAG_IN_PAL) {
-    max_lines = 288;
-  }
-
-  if ((cur_flags & VIDEOIF_FLAG_IN_31KHZ) ||
-      (inputmode && (video_settings[current_videomode] & VIDEOIF_SET_LD_ENABLE))) {
-    /* note: double-clocked SD modes are already detected by xres/htotal checks */
-    max_lines *= 2;
-  }
-
-  if (cur_yres > max_lines) {
-    return VIDMODE_NONSTANDARD;
-  }
-
-  return vidmode_by_flags[cur_flags];
-}
-
 void print_resolution(void) {
   uint32_t xres  = VIDEOIF->xres;
   uint32_t yres  = VIDEOIF->yres;
   uint32_t flags = VIDEOIF->flags;
 
   if (current_videomode == VIDMODE_NONSTANDARD) {
-    printf("%4dx%3d", xres, yres);
+    osd_putint(xres, 4, 0);
+    osd_putchar('x');
+    osd_putint(yres, 3, 0);
   } else {
     if (!(flags & VIDEOIF_FLAG_IN_PROGRESSIVE))
       yres *= 2;
 
-    printf("%3dx%3d%c%d", xres, yres,
-          (flags & VIDEOIF_FLAG_IN_PROGRESSIVE) ? 'p' : 'i',
-          (flags & VIDEOIF_FLAG_IN_PAL        ) ? 50  : 60);
+    osd_putint(xres, 3, 0);
+    osd_putchar('x');
+    osd_putint(yres, 3, 0);
+    osd_putchar((flags & VIDEOIF_FLAG_IN_PROGRESSIVE) ? 'p' : 'i');
+    osd_puts   ((flags & VIDEOIF_FLAG_IN_PAL        ) ? "50" : "60");
   }
 }
 
@@ -266,13 +213,21 @@ void settings_load(void) {
   screen_x_shift     = set.st.xshift;
   screen_y_shift     = set.st.yshift;
 
-  spiflash_start_read(SETTINGS_OFFSET + ((current_setid + 2) << 8));
-  for (unsigned int i = 256; i < SCANLINERAM_ENTRIES; i ++) {
-    uint16_t val = spiflash_send_byte(0) << 8;
-    val |= spiflash_send_byte(0);
-    SCANLINERAM->profiles[i] = val;
+  /* scanline profiles, two entries per DMA buffer word */
+  uint32_t address = SETTINGS_OFFSET + ((current_setid + 2) << 8);
+
+  for (unsigned int i = 256; i < SCANLINERAM_ENTRIES; i += SPIBUF_SIZE / 2) {
+    spiflash_read_spibuf(address, SPIBUF_SIZE);
+    spiflash_wait_buffer();
+
+    for (unsigned int j = 0; j < SPIBUF_SIZE / 4; j++) {
+      uint32_t val = SPIBUF->data[j];
+      SCANLINERAM->profiles[i + 2 * j]     = val >> 16;
+      SCANLINERAM->profiles[i + 2 * j + 1] = val & 0xffff;
+    }
+
+    address += SPIBUF_SIZE;
   }
-  spiflash_end_read();
 }
 
 void settings_save(void) {
@@ -333,27 +288,39 @@ void settings_save(void) {
 
   /* write data to flash */
   current_setid -= 8;
-  spiflash_write_page(SETTINGS_OFFSET + current_setid * 256, &set, sizeof(set));
+  spiflash_program_start(SETTINGS_OFFSET + current_setid * 256, &set, sizeof(set));
 
-  unsigned int page_remain = 0;
   // note: first 256 word block of scanline RAM is unused
-  for (unsigned int i = 256; i < SCANLINERAM_ENTRIES; i++) {
-    if (page_remain == 0) {
-      spiflash_end_write();
-      spiflash_start_write(SETTINGS_OFFSET + current_setid * 256 + i * 2);
-      page_remain = 128;
+  uint32_t address = SETTINGS_OFFSET + current_setid * 256 + 256 * 2;
+
+  for (unsigned int i = 256; i < SCANLINERAM_ENTRIES; i += SPIBUF_SIZE / 2) {
+    /* fill the buffer while the previous page is being programmed */
+    spiflash_wait_buffer();
+
+    for (unsigned int j = 0; j < SPIBUF_SIZE / 4; j++) {
+      SPIBUF->data[j] = (SCANLINERAM->profiles[i + 2 * j] << 16) |
+                        (SCANLINERAM->profiles[i + 2 * j + 1] & 0xffff);
     }
 
-    spiflash_send_byte((SCANLINERAM->profiles[i] >> 8) & 0xff);
-    spiflash_send_byte(SCANLINERAM->profiles[i] & 0xff);
-    page_remain--;
+    spiflash_program_spibuf(address, SPIBUF_SIZE);
+    address += SPIBUF_SIZE;
   }
 
-  spiflash_end_write();
+  spiflash_complete();
+}
+
+/* the second page of a settings record is never written, */
+/* so it can hold other data until the next save          */
+uint32_t settings_spare_page(void) {
+  if (current_setid >= 256)
+    return 0;
+
+  return SETTINGS_OFFSET + ((current_setid + 1) << 8);
 }
 
 
-void settings_init(void) {
+/* only used at boot and for resets to defaults */
+void FLASHCODE settings_init(void) {
   resbox_enabled = true;
 
   video_settings_global = VIDEOIF_SET_ENABLEREBLANK | VIDEOIF_SET_ENABLERESYNC |
@@ -414,4 +381,5 @@ void settings_commit(void) {
     VIDEOIF->audio_volume = audio_volume;
   }
   update_colormatrix();
+  update_mode_config();
 }
@@ -34,6 +34,8 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "portdefs.h"
+#include "vsync.h"
 
 #define SETTINGS_OFFSET 0x70000
 
@@ -70,23 +72,41 @@ extern minibool     crop_486_to_480;
 
 void set_all_modes(uint32_t flag, bool state);
 void update_scanlines(void);
-video_mode_t detect_videomode(bool inputmode);
 void print_resolution(void);
 void settings_load(void);
 void settings_save(void);
 void settings_init(void);
 void settings_commit(void);
+uint32_t settings_spare_page(void);
 
+/* video modes are classified in hardware and cached on change */
 static inline video_mode_t detect_input_videomode(void) {
-   return detect_videomode(true);
+   return (video_modes >> VIDEOIF_VIDMODE_IN_SHIFT) & VIDEOIF_VIDMODE_MASK;
 }
 
 static inline video_mode_t detect_output_videomode(void) {
-   return detect_videomode(false);
+   return (video_modes >> VIDEOIF_VIDMODE_OUT_SHIFT) & VIDEOIF_VIDMODE_MASK;
+}
+
+static inline void update_mode_config(void) {
+   VIDEOIF->mode_config = crop_486_to_480 ? VIDEOIF_MODECFG_CROP486 : 0;
 }
 
 static inline bool is_progressive(video_mode_t mode) {
    return (mode != VIDMODE_480i) && (mode != VIDMODE_576i);
 }
 
+/* number of output lines per input line in a mode, 1 if not multiplied */
+static inline unsigned int line_multiplier(video_mode_t mode) {
+   if (mode > VIDMODE_576i || !(video_settings[mode] & VIDEOIF_SET_LD_ENABLE))
+      return 1;
+
+#ifdef ENABLE_FULLRATE
+   return 2 + ((video_settings[mode] & VIDEOIF_SET_LD_FACTOR_MASK) >> VIDEOIF_SET_LD_FACTOR_SHIFT);
+#else
+   /* the hardware ignores the factor bits without full rate support */
+   return 2;
+#endif
+}
+
 #endif
@@ -32,6 +32,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
+#include "irq.h"
 #include "irrx.h"
 #include "portdefs.h"
 #include "settings.h"
@@ -50,6 +51,12 @@
 
 #define STATUSREG_WIP      (1<<0) // write in progress
 
+/* asynchronous erase/program operation */
+static bool           async_active;
+static const uint8_t *async_data;
+static uint32_t       async_address;
+static uint32_t       async_remain;
+
 static void set_cs(bool state) {
   if (state)
     SPICAP->spi_flags |=  SPI_FLAG_CSEL;
@@ -57,6 +64,15 @@ static void set_cs(bool state) {
     SPICAP->spi_flags &= ~SPI_FLAG_CSEL;
 }
 
+/* also tells the flash cache to wait until the flash is ready */
+static void set_async_active(bool state) {
+  async_active = state;
+  if (state)
+    SPICAP->spi_flags |=  SPI_FLAG_FLASHBUSY;
+  else
+    SPICAP->spi_flags &= ~SPI_FLAG_FLASHBUSY;
+}
+
 unsigned int spiflash_send_byte(unsigned int byte) {
   SPICAP->spi_data = byte;
   /* no busy check, handled via hardware waitstates */
@@ -69,15 +85,61 @@ static void write_enable(void) {
   set_cs(true);
 }
 
+static bool write_in_progress(void) {
+  set_cs(false);
+  spiflash_send_byte(CMD_READ_STATUS);
+  unsigned int result = spiflash_send_byte(0x00);
+  set_cs(true);
+
+  return result & STATUSREG_WIP;
+}
+
 static void wait_write_done(void) {
-  unsigned int result;
+  while (write_in_progress()) ;
+}
 
-  do {
-    set_cs(false);
-    spiflash_send_byte(CMD_READ_STATUS);
-    result = spiflash_send_byte(0x00);
-    set_cs(true);
-  } while (result & STATUSREG_WIP);
+/* --- DMA helpers --- */
+
+static bool dma_busy(void) {
+  return SPICAP->dma_control & SPI_DMA_BUSY;
+}
+
+/* sleeps until the completion interrupt, a transfer that finishes */
+/* between the check and irq_wait leaves its interrupt pending      */
+static void dma_wait(void) {
+  while (dma_busy())
+    irq_wait();
+}
+
+static void dma_start(uint8_t command, uint32_t address, unsigned int length, uint32_t flags) {
+  SPICAP->dma_command = ((uint32_t)command << 24) | (address & 0xffffff);
+  SPICAP->dma_control = flags | length;
+}
+
+static void copy_to_spibuf(const uint8_t *data, unsigned int length) {
+  volatile uint32_t *dest = SPIBUF->data;
+  uint32_t word = 0;
+
+  for (unsigned int i = 0; i < length; i++) {
+    word = (word << 8) | data[i];
+    if ((i & 3) == 3)
+      *dest++ = word;
+  }
+
+  if (length & 3)
+    *dest = word << (8 * (4 - (length & 3)));
+}
+
+static void copy_from_spibuf(uint8_t *data, unsigned int length) {
+  const volatile uint32_t *src = SPIBUF->data;
+  uint32_t word = 0;
+
+  for (unsigned int i = 0; i < length; i++) {
+    if ((i & 3) == 0)
+      word = *src++;
+    data[i] = word >> 24;
+    word <<= 8;
+  }
 }
 
 bool spiflash_is_blank(uint32_t address, unsigned int length) {
@@ -103,6 +165,7 @@ static void start_command_addr(uint8_t command, uint32_t address) {
 }
 
 void spiflash_start_write(uint32_t address) {
+  spiflash_complete();
   write_enable();
   start_command_addr(CMD_PAGE_PROGRAM, address);
 }
@@ -113,6 +176,7 @@ void spiflash_end_write(void) {
 }
 
 void spiflash_start_read(uint32_t address) {
+  spiflash_complete();
   start_command_addr(CMD_READ_BYTES, address);
 }
 
@@ -121,33 +185,126 @@ void spiflash_end_read(void) {
 }
 
 void spiflash_erase_sector(uint32_t address) {
-  write_enable();
-  start_command_addr(CMD_SECTOR_ERASE, address);
-  spiflash_end_write();
+  spiflash_erase_start(address);
+  spiflash_complete();
 }
 
 void spiflash_read_block(void* buffer, uint32_t address, uint32_t length) {
   uint8_t *bytebuf = (uint8_t *)buffer;
 
-  spiflash_start_read(address);
-  for (unsigned int i = 0; i < length; i++)
-    bytebuf[i] = spiflash_send_byte(0x00);
-  set_cs(true);
+  while (length > 0) {
+    unsigned int chunk = length;
+
+    if (chunk > SPIBUF_SIZE)
+      chunk = SPIBUF_SIZE;
+
+    spiflash_read_spibuf(address, chunk);
+    spiflash_wait_buffer();
+    copy_from_spibuf(bytebuf, chunk);
+
+    bytebuf += chunk;
+    address += chunk;
+    length  -= chunk;
+  }
 }
 
 void spiflash_write_page(uint32_t address, void* buffer, uint32_t length) {
-  uint8_t *bytebuf = (uint8_t *)buffer;
-  while (length > 0) {
-   spiflash_start_write(address);
+  spiflash_program_start(address, buffer, length);
+  spiflash_complete();
+}
+
+/* --- asynchronous erase/program --- */
+
+/* send the next page of the current program operation */
+static void program_next_page(void) {
+  unsigned int length = 256 - (async_address & 0xff);
+
+  if (length > async_remain)
+    length = async_remain;
+
+  copy_to_spibuf(async_data, length);
+  write_enable();
+  dma_start(CMD_PAGE_PROGRAM, async_address, length, SPI_DMA_WRITE);
+
+  async_data    += length;
+  async_address += length;
+  async_remain  -= length;
+}
+
+void spiflash_erase_start(uint32_t address) {
+  spiflash_complete();
+
+  write_enable();
+  start_command_addr(CMD_SECTOR_ERASE, address);
+  set_cs(true);
+
+  async_remain = 0;
+  set_async_active(true);
+}
+
+void spiflash_program_start(uint32_t address, const void *buffer, uint32_t length) {
+  spiflash_complete();
+
+  if (length == 0)
+    return;
+
+  async_data    = buffer;
+  async_address = address;
+  async_remain  = length;
+  set_async_active(true);
+  program_next_page();
+}
 
-    do {
-      spiflash_send_byte(*bytebuf++);
-      address++;
-      length--;
-    } while (length > 0 && (address & 0xff) != 0);
+void spiflash_program_spibuf(uint32_t address, unsigned int length) {
+  spiflash_complete();
 
-    spiflash_end_write();
+  if (length == 0)
+    return;
+
+  write_enable();
+  dma_start(CMD_PAGE_PROGRAM, address, length, SPI_DMA_WRITE);
+
+  async_remain = 0;
+  set_async_active(true);
+}
+
+void spiflash_read_spibuf(uint32_t address, unsigned int length) {
+  spiflash_complete();
+
+  if (length > 0)
+    dma_start(CMD_READ_BYTES, address, length, 0);
+}
+
+bool spiflash_poll(void) {
+  if (dma_busy())
+    return true;
+
+  if (!async_active)
+    return false;
+
+  if (write_in_progress())
+    return true;
+
+  if (async_remain > 0) {
+    program_next_page();
+    return true;
   }
+
+  set_async_active(false);
+  return false;
+}
+
+/* the flash has no ready interrupt, only DMA transfers sleep */
+void spiflash_complete(void) {
+  do {
+    dma_wait();
+  } while (spiflash_poll());
+}
+
+void spiflash_wait_buffer(void) {
+  do {
+    dma_wait();
+  } while (async_remain > 0 && spiflash_poll());
 }
 
 #ifdef HAVE_SPI_HWCRC
@@ -46,4 +46,21 @@ unsigned int spiflash_send_byte(unsigned int byte);
 void spiflash_end_read(void);
 void spiflash_end_write(void);
 
+/* Asynchronous erase/program: Only one operation can be active, starting */
+/* another or reading waits until it is finished. The flash cannot be     */
+/* read while it is busy, XIP code that runs in the meantime stalls on    */
+/* cache misses until the operation has finished. A program buffer must   */
+/* stay valid until spiflash_wait_buffer has returned.                    */
+void spiflash_erase_start(uint32_t address);
+void spiflash_program_start(uint32_t address, const void *buffer, uint32_t length);
+bool spiflash_poll(void);
+void spiflash_complete(void);
+void spiflash_wait_buffer(void);
+
+/* DMA transfers directly to/from SPIBUF: A program must not cross a page */
+/* boundary. The buffer must not be accessed until spiflash_wait_buffer   */
+/* has returned, spiflash_program_start also uses it.                     */
+void spiflash_program_spibuf(uint32_t address, unsigned int length);
+void spiflash_read_spibuf(uint32_t address, unsigned int length);
+
 #endif
@@ -0,0 +1,177 @@
+/* GCVideo DVI Firmware
+
+   Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+   THE POSSIBILITY OF SUCH DAMAGE.
+
+
+   updateline.c: Decoding of firmware update lines
+
+   This is the part of the flasher that turns a captured line into
+   flash contents. It does not touch any hardware, so it is also
+   built into the host-side transport simulator.
+
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "crc32mpeg.h"
+#include "exodecr.h"
+#include "flasher.h"
+#include "lz4dec.h"
+#include "updateline.h"
+
+#define RNG_MULT            1103515245
+#define RNG_ADD             12345
+#define RNG_MOD             (1U << 31)
+#define RNG_SHIFT           8
+
+/* decode a captured line to a buffer, returns the number of bytes */
+size_t updateline_decode(const volatile uint32_t *linedata, void *destination,
+                         size_t buffersize) {
+  size_t length = linedata[1] - 0x4040;
+  length = (length & 0x7f) | ((length & 0x7f00) >> 1);
+
+  if (length > (buffersize / 2)) {
+    return 0;
+  }
+
+  unsigned int bitbuffer = 0;
+  unsigned int bits_remain = 0;
+  uint16_t *writeptr = (uint16_t*)destination;
+  const volatile uint32_t *readptr = linedata + 2;
+
+  while (length > 0) {
+    unsigned int curword = *readptr++ - 0x4040;
+
+    if (bits_remain == 0) {
+      bitbuffer = curword;
+      bits_remain = 7;
+      continue;
+    }
+
+    uint16_t dataword = (curword << 1) | (bitbuffer & 0x0101);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    /* the line data is big-endian, only relevant for the host-side simulator */
+    dataword = (dataword >> 8) | (dataword << 8);
+#endif
+    *writeptr++ = dataword;
+    bitbuffer = (bitbuffer & 0xfefe) >> 1;
+    bits_remain--;
+    length--;
+  }
+
+  return 2 * (writeptr - (uint16_t*)destination);
+}
+
+/* unscramble a decoded line in place and check its CRC */
+bool updateline_validate(uint8_t *buffer, size_t length, uint32_t lineinfo) {
+  uint8_t prefix[2] = {
+    (lineinfo >> 8) & 0xff,
+     lineinfo & 0xff
+  };
+
+  if (length < 4) {
+    return false;
+  }
+
+  /* unscramble */
+  uint32_t rngstate = (prefix[0] << 8) | prefix[1];
+  for (unsigned int i = 0; i < length; i++) {
+    rngstate = (RNG_MULT * rngstate + RNG_ADD) % RNG_MOD;
+    uint8_t randval = (rngstate >> RNG_SHIFT) & 0xff;
+    buffer[i] ^= randval;
+  }
+
+  uint32_t buffercrc = ((uint32_t)buffer[0] << 24) | ((uint32_t)buffer[1] << 16) |
+                       ((uint32_t)buffer[2] <<  8) |           buffer[3];
+
+  crc_t crc = crc_init();
+  crc = crc_update(crc, prefix, 2);
+  crc = crc_update(crc, buffer + 4, length - 4);
+  crc = crc_finalize(crc);
+
+  return buffercrc == crc;
+}
+
+/* unpack the chunk at *readptr to output, which must be preceded by */
+/* dictsize bytes of dictionary (only used by LZ chunks). Returns the */
+/* number of bytes unpacked (0 if the chunk is corrupted) and its     */
+/* offset in the main image.                                          */
+unsigned int updateline_unpack_chunk(const uint8_t **readptr, const uint8_t *end,
+                                     char *output, unsigned int dictsize,
+                                     uint32_t *offset) {
+  const uint8_t *ptr = *readptr;
+
+  if (end - ptr < 3) {
+    return 0;
+  }
+
+  unsigned int chunknum  = ptr[0];
+  unsigned int chunklen  = (ptr[1] << 8) | ptr[2];
+  bool         lz_chunk  = chunklen & CHUNK_FLAG_LZ;
+  unsigned int chunksize = UNCOMPRESSED_CHUNK_SIZE;
+
+  ptr += 3;
+
+  if (chunklen & CHUNK_FLAG_LARGE) {
+    /* large chunks cover whole pages of the small ones */
+    if (chunknum % (LARGE_CHUNK_SIZE / UNCOMPRESSED_CHUNK_SIZE) != 0) {
+      return 0;
+    }
+
+    chunksize = LARGE_CHUNK_SIZE;
+  }
+
+  chunklen &= ~(CHUNK_FLAG_LZ | CHUNK_FLAG_LARGE);
+
+  if (chunklen > end - ptr ||
+      chunknum * UNCOMPRESSED_CHUNK_SIZE + chunksize > MAIN_APP_SIZE) {
+    return 0;
+  }
+
+  if (lz_chunk) {
+    size_t decoded = lz4_decode(ptr, chunklen, (uint8_t *)output, chunksize,
+                                dictsize);
+
+    if (decoded != chunksize) {
+      return 0;
+    }
+  } else if (chunklen != UNCOMPRESSED_CHUNK_SIZE || chunksize != UNCOMPRESSED_CHUNK_SIZE) {
+    char *startptr =
+      exo_decrunch((const char *)ptr + chunklen, chunklen,
+                   output + chunksize, chunksize);
+
+    if (startptr == NULL || (unsigned int)(output + chunksize - startptr) != chunksize) {
+      return 0;
+    }
+  } else {
+    memcpy(output, ptr, UNCOMPRESSED_CHUNK_SIZE);
+  }
+
+  *readptr = ptr + chunklen;
+  *offset  = chunknum * UNCOMPRESSED_CHUNK_SIZE;
+  return chunksize;
+}
@@ -0,0 +1,56 @@
+/* GCVideo DVI Firmware
+
+   Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+   THE POSSIBILITY OF SUCH DAMAGE.
+
+
+   updateline.h: Decoding of firmware update lines
+
+*/
+
+#ifndef UPDATELINE_H
+#define UPDATELINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define INFO_PAGE           0x10
+#define INFO_LINE           0
+#define DICTIONARY_LINE     1
+
+/* format tag after a zero firmware count, hides LZ updates from old flashers */
+#define INFO_FORMAT_LZ      0x4c5a
+#define INFO_FORMAT_LZDICT  0x4c44 // same, with a preset dictionary on DICTIONARY_LINE
+#define CHUNK_FLAG_LZ       0x8000
+#define CHUNK_FLAG_LARGE    0x4000
+
+size_t updateline_decode(const volatile uint32_t *linedata, void *destination,
+                         size_t buffersize);
+bool updateline_validate(uint8_t *buffer, size_t length, uint32_t lineinfo);
+unsigned int updateline_unpack_chunk(const uint8_t **readptr, const uint8_t *end,
+                                     char *output, unsigned int dictsize,
+                                     uint32_t *offset);
+
+#endif
@@ -0,0 +1,408 @@
+/* GCVideo DVI Firmware
+
+   Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+   THE POSSIBILITY OF SUCH DAMAGE.
+
+
+   bench.c: Host throughput benchmark for the update decoding
+
+   Times the flasher's line and chunk decoders on chunks of a firmware
+   image (or generated data if none is given), compressed with the
+   encoders in encoders.c. Lines encoded by buildupdate.pl can be added
+   with -l, see mkcorpus.pl. The numbers are host throughput and only
+   useful to compare changes of the decoders, see buildupdate.pl for
+   the cycle estimates of the ZPU.
+
+*/
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "encoders.h"
+#include "exodecr.h"
+#include "flasher.h"
+#include "lz4dec.h"
+#include "updateline.h"
+
+#define CAPTURE_WORDS  1024
+#define ENCODED_WORDS  719  // captured words of a buildupdate.pl line
+#define LINE_BYTES     1254 // longest line that buildupdate.pl generates
+#define DEFAULT_SIZE   0x40000
+#define MIN_TIME       0.25
+
+typedef struct {
+  const uint8_t *plain;
+  unsigned int   plainsize;
+  uint8_t       *packed;
+  unsigned int   packedsize;
+} chunk_t;
+
+static uint8_t *image;
+static size_t   imagesize;
+static chunk_t *exo_chunks;
+static chunk_t *lz4_chunks;
+static unsigned int chunkcount;
+static uint32_t *captured_lines;
+static unsigned int captured_count;
+
+static uint32_t linedata[CAPTURE_WORDS];
+static uint8_t __attribute__((aligned(4))) decodebuf[DECODEBUFFER_SIZE];
+static char     chunkbuffer[DICTIONARY_SIZE + LARGE_CHUNK_SIZE];
+static volatile unsigned int sink;
+
+static double now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* repeats a pass over the data until enough time has passed, */
+/* returns bytes per second of output                         */
+static double measure(size_t (*pass)(void)) {
+  unsigned long bytes = 0;
+  double start = now();
+  double elapsed;
+
+  do {
+    bytes  += pass();
+    elapsed = now() - start;
+  } while (elapsed < MIN_TIME);
+
+  return bytes / elapsed;
+}
+
+/* something like code: small values, many repeats */
+static void generate_image(size_t size) {
+  uint64_t state = 1;
+
+  image     = malloc(size);
+  imagesize = size;
+
+  for (size_t pos = 0; pos < size; ) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    unsigned int random = state >> 33;
+
+    if (pos >= 64 && random % 4 == 0) {
+      size_t offset = 1 + (random >> 2) % (pos < 4096 ? pos : 4096);
+      size_t length = 3 + (random >> 14) % 24;
+
+      for (size_t i = 0; i < length && pos < size; i++, pos++) {
+        image[pos] = image[pos - offset];
+      }
+    } else {
+      image[pos++] = (random >> 8) % 8 ? (random >> 12) % 32 : random >> 16;
+    }
+  }
+}
+
+static bool read_image(const char *filename) {
+  FILE *fd = fopen(filename, "rb");
+
+  if (fd == NULL) {
+    perror(filename);
+    return false;
+  }
+
+  fseek(fd, 0, SEEK_END);
+  imagesize = ftell(fd);
+  fseek(fd, 0, SEEK_SET);
+
+  image = malloc(imagesize + 1);
+  if (image == NULL || fread(image, 1, imagesize, fd) != imagesize) {
+    fprintf(stderr, "%s: read failed\n", filename);
+    fclose(fd);
+    return false;
+  }
+
+  fclose(fd);
+  return true;
+}
+
+/* lines from mkcorpus.pl: big endian capture words, ENCODED_WORDS per line */
+static bool read_lines(const char *filename) {
+  FILE *fd = fopen(filename, "rb");
+
+  if (fd == NULL) {
+    perror(filename);
+    return false;
+  }
+
+  fseek(fd, 0, SEEK_END);
+  long size = ftell(fd);
+  fseek(fd, 0, SEEK_SET);
+
+  captured_count = size / (2 * ENCODED_WORDS);
+  captured_lines = calloc(captured_count * ENCODED_WORDS + 1, sizeof(uint32_t));
+
+  for (unsigned int i = 0; i < captured_count * ENCODED_WORDS; i++) {
+    uint8_t word[2];
+
+    if (fread(word, 1, 2, fd) != 2) {
+      fprintf(stderr, "%s: read failed\n", filename);
+      fclose(fd);
+      return false;
+    }
+
+    captured_lines[i] = (word[0] << 8) | word[1];
+  }
+
+  fclose(fd);
+
+  if (captured_count == 0) {
+    fprintf(stderr, "%s: no lines found\n", filename);
+    return false;
+  }
+
+  return true;
+}
+
+static void pack_chunks(void) {
+  unsigned long exo_total = 0, lz4_total = 0;
+
+  chunkcount = imagesize / UNCOMPRESSED_CHUNK_SIZE;
+  exo_chunks = calloc(chunkcount, sizeof(chunk_t));
+  lz4_chunks = calloc(chunkcount, sizeof(chunk_t));
+
+  for (unsigned int i = 0; i < chunkcount; i++) {
+    const uint8_t *plain = image + i * UNCOMPRESSED_CHUNK_SIZE;
+    uint8_t buffer[2 * UNCOMPRESSED_CHUNK_SIZE];
+
+    exo_chunks[i].plain      = plain;
+    exo_chunks[i].plainsize  = UNCOMPRESSED_CHUNK_SIZE;
+    exo_chunks[i].packedsize = exo_encode(plain, UNCOMPRESSED_CHUNK_SIZE, buffer, sizeof(buffer));
+    exo_chunks[i].packed     = malloc(exo_chunks[i].packedsize);
+    memcpy(exo_chunks[i].packed, buffer, exo_chunks[i].packedsize);
+    exo_total += exo_chunks[i].packedsize;
+
+    /* the previous chunk stands in for the preset dictionary */
+    size_t dictsize = i > 0 ? DICTIONARY_SIZE : 0;
+    lz4_chunks[i].plain      = plain;
+    lz4_chunks[i].plainsize  = UNCOMPRESSED_CHUNK_SIZE;
+    lz4_chunks[i].packedsize = lz4_encode(plain, UNCOMPRESSED_CHUNK_SIZE, dictsize,
+                                          buffer, sizeof(buffer));
+    lz4_chunks[i].packed     = malloc(lz4_chunks[i].packedsize);
+    memcpy(lz4_chunks[i].packed, buffer, lz4_chunks[i].packedsize);
+    lz4_total += lz4_chunks[i].packedsize;
+  }
+
+  printf("%u chunks of %u bytes: exomizer %.1f%%, LZ4 %.1f%% of the original size\n\n",
+         chunkcount, UNCOMPRESSED_CHUNK_SIZE,
+         100.0 * exo_total / (chunkcount * UNCOMPRESSED_CHUNK_SIZE),
+         100.0 * lz4_total / (chunkcount * UNCOMPRESSED_CHUNK_SIZE));
+}
+
+
+/* -------------- */
+/* --- passes --- */
+/* -------------- */
+
+static size_t pass_line_decode(void) {
+  size_t length = updateline_decode(linedata, decodebuf, sizeof(decodebuf));
+
+  sink += decodebuf[0];
+  return length;
+}
+
+static size_t pass_line_validate(void) {
+  /* the CRC does not match after the first pass, the work is the same */
+  sink += updateline_validate(decodebuf, LINE_BYTES, linedata[0]);
+  return LINE_BYTES;
+}
+
+/* decode and check every line, as the flasher does after a capture */
+static size_t pass_captured_lines(void) {
+  size_t bytes = 0;
+
+  for (unsigned int i = 0; i < captured_count; i++) {
+    memcpy(linedata, captured_lines + i * ENCODED_WORDS, ENCODED_WORDS * sizeof(uint32_t));
+
+    size_t length = updateline_decode(linedata, decodebuf, sizeof(decodebuf));
+    if (updateline_validate(decodebuf, length, linedata[0]))
+      bytes += length;
+  }
+
+  return bytes;
+}
+
+static size_t pass_raw_chunks(void) {
+  uint8_t chunk[3 + UNCOMPRESSED_CHUNK_SIZE];
+  size_t bytes = 0;
+
+  for (unsigned int i = 0; i < chunkcount; i++) {
+    const uint8_t *readptr = chunk;
+    uint32_t offset;
+
+    chunk[0] = i;
+    chunk[1] = UNCOMPRESSED_CHUNK_SIZE >> 8;
+    chunk[2] = UNCOMPRESSED_CHUNK_SIZE & 0xff;
+    memcpy(chunk + 3, image + i * UNCOMPRESSED_CHUNK_SIZE, UNCOMPRESSED_CHUNK_SIZE);
+
+    bytes += updateline_unpack_chunk(&readptr, chunk + sizeof(chunk),
+                                     chunkbuffer + DICTIONARY_SIZE, 0, &offset);
+  }
+
+  return bytes;
+}
+
+static size_t pass_exo(void) {
+  size_t bytes = 0;
+
+  for (unsigned int i = 0; i < chunkcount; i++) {
+    char *end      = chunkbuffer + DICTIONARY_SIZE + UNCOMPRESSED_CHUNK_SIZE;
+    char *startptr = exo_decrunch((const char *)exo_chunks[i].packed + exo_chunks[i].packedsize,
+                                  exo_chunks[i].packedsize, end, UNCOMPRESSED_CHUNK_SIZE);
+
+    if (startptr != NULL)
+      bytes += end - startptr;
+  }
+
+  return bytes;
+}
+
+static size_t pass_lz4(void) {
+  size_t bytes = 0;
+
+  for (unsigned int i = 0; i < chunkcount; i++) {
+    if (i > 0)
+      memcpy(chunkbuffer, image + (i - 1) * UNCOMPRESSED_CHUNK_SIZE, DICTIONARY_SIZE);
+
+    bytes += lz4_decode(lz4_chunks[i].packed, lz4_chunks[i].packedsize,
+                        (uint8_t *)chunkbuffer + DICTIONARY_SIZE,
+                        UNCOMPRESSED_CHUNK_SIZE, i > 0 ? DICTIONARY_SIZE : 0);
+  }
+
+  return bytes;
+}
+
+/* check the passes once before timing them */
+static bool verify(void) {
+  for (unsigned int i = 0; i < captured_count; i++) {
+    memcpy(linedata, captured_lines + i * ENCODED_WORDS, ENCODED_WORDS * sizeof(uint32_t));
+
+    size_t length = updateline_decode(linedata, decodebuf, sizeof(decodebuf));
+    if (!updateline_validate(decodebuf, length, linedata[0]))
+      return false;
+  }
+
+  /* the line passes use this line */
+  memset(linedata, 0, sizeof(linedata));
+  linedata[0] = 0x0110;
+  if (line_encode(image, LINE_BYTES, linedata, CAPTURE_WORDS) == 0 ||
+      updateline_decode(linedata, decodebuf, sizeof(decodebuf)) != LINE_BYTES ||
+      memcmp(decodebuf, image, LINE_BYTES))
+    return false;
+
+  for (unsigned int i = 0; i < chunkcount; i++) {
+    char *end = chunkbuffer + DICTIONARY_SIZE + UNCOMPRESSED_CHUNK_SIZE;
+
+    if (exo_decrunch((const char *)exo_chunks[i].packed + exo_chunks[i].packedsize,
+                     exo_chunks[i].packedsize, end, UNCOMPRESSED_CHUNK_SIZE) !=
+        end - UNCOMPRESSED_CHUNK_SIZE ||
+        memcmp(end - UNCOMPRESSED_CHUNK_SIZE, exo_chunks[i].plain, UNCOMPRESSED_CHUNK_SIZE))
+      return false;
+  }
+
+  for (unsigned int i = 0; i < chunkcount; i++) {
+    if (i > 0)
+      memcpy(chunkbuffer, image + (i - 1) * UNCOMPRESSED_CHUNK_SIZE, DICTIONARY_SIZE);
+
+    if (lz4_decode(lz4_chunks[i].packed, lz4_chunks[i].packedsize,
+                   (uint8_t *)chunkbuffer + DICTIONARY_SIZE, UNCOMPRESSED_CHUNK_SIZE,
+                   i > 0 ? DICTIONARY_SIZE : 0) != UNCOMPRESSED_CHUNK_SIZE ||
+        memcmp(chunkbuffer + DICTIONARY_SIZE, lz4_chunks[i].plain, UNCOMPRESSED_CHUNK_SIZE))
+      return false;
+  }
+
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  int opt;
+
+  while ((opt = getopt(argc, argv, "l:h")) != -1) {
+    switch (opt) {
+    case 'l':
+      if (!read_lines(optarg))
+        return 2;
+      break;
+
+    default:
+      printf("Usage: %s [-l lines.dat] [image.bin]\n\n"
+             "Without an image, %d KByte of generated data are used.\n"
+             "-l adds a pass over lines encoded by buildupdate.pl\n",
+             argv[0], DEFAULT_SIZE / 1024);
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  if (optind < argc - 1) {
+    fprintf(stderr, "Only one image can be given\n");
+    return 1;
+  }
+
+  if (optind < argc) {
+    if (!read_image(argv[optind]))
+      return 2;
+  } else {
+    generate_image(DEFAULT_SIZE);
+  }
+
+  if (imagesize < LINE_BYTES || imagesize < UNCOMPRESSED_CHUNK_SIZE) {
+    fprintf(stderr, "Image is too small\n");
+    return 2;
+  }
+
+  pack_chunks();
+
+  if (!verify()) {
+    fprintf(stderr, "Decoded data does not match\n");
+    return 3;
+  }
+
+  const struct {
+    const char *name;
+    size_t (*pass)(void);
+  } passes[] = {
+    { "updateline_decode",        pass_line_decode   },
+    { "updateline_validate",      pass_line_validate },
+    { "unpack_chunk (raw)",       pass_raw_chunks    },
+    { "exo_decrunch",             pass_exo           },
+    { "lz4_decode (dictionary)",  pass_lz4           },
+  };
+
+  for (unsigned int i = 0; i < sizeof(passes) / sizeof(passes[0]); i++) {
+    printf("%-26s %8.1f MByte/s\n", passes[i].name, measure(passes[i].pass) / 1e6);
+  }
+
+  if (captured_count > 0)
+    printf("%-26s %8.1f MByte/s (%u lines)\n", "decode+validate (lines)",
+           measure(pass_captured_lines) / 1e6, captured_count);
+
+  return 0;
+}
@@ -0,0 +1,418 @@
+/* GCVideo DVI Firmware
+
+   Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+   THE POSSIBILITY OF SUCH DAMAGE.
+
+
+   encoders.c: Host-side encoders for the update decoding checks
+
+   Small greedy versions of the formats that buildupdate.pl generates,
+   so the fuzzer and the benchmark can build valid input for the
+   flasher's decoders without the external tools.
+
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "encoders.h"
+
+#define HASH_BITS      12
+#define MAX_CHAIN      64
+#define MAX_INPUT      65536
+
+/* ------------ */
+/* --- LZ4 --- */
+/* ------------ */
+
+#define LZ4_MIN_MATCH  4
+#define LZ4_MAX_OFFSET 65535
+
+typedef struct {
+  uint8_t *ptr;
+  uint8_t *end;
+  bool     overflow;
+} outbuf_t;
+
+static void put_byte(outbuf_t *buf, uint8_t value) {
+  if (buf->ptr >= buf->end) {
+    buf->overflow = true;
+    return;
+  }
+
+  *buf->ptr++ = value;
+}
+
+static void put_length(outbuf_t *buf, size_t length) {
+  while (length >= 255) {
+    put_byte(buf, 255);
+    length -= 255;
+  }
+
+  put_byte(buf, length);
+}
+
+static void put_sequence(outbuf_t *buf, const uint8_t *literals, size_t litlen,
+                         size_t offset, size_t matchlen) {
+  size_t  matchcode = matchlen ? matchlen - LZ4_MIN_MATCH : 0;
+  uint8_t token     = (litlen < 15 ? litlen : 15) << 4;
+
+  token |= matchcode < 15 ? matchcode : 15;
+  put_byte(buf, token);
+
+  if (litlen >= 15)
+    put_length(buf, litlen - 15);
+
+  for (size_t i = 0; i < litlen; i++) {
+    put_byte(buf, literals[i]);
+  }
+
+  if (matchlen == 0)
+    return;
+
+  put_byte(buf, offset & 0xff);
+  put_byte(buf, offset >> 8);
+
+  if (matchcode >= 15)
+    put_length(buf, matchcode - 15);
+}
+
+static unsigned int hash4(const uint8_t *ptr) {
+  uint32_t value = ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+
+  return (value * 2654435761U) >> (32 - HASH_BITS);
+}
+
+size_t lz4_encode(const uint8_t *in, size_t insize, size_t dictsize,
+                  uint8_t *out, size_t outsize) {
+  static int32_t head[1 << HASH_BITS];
+  static int32_t chain[MAX_INPUT];
+  const uint8_t *base  = in - dictsize;
+  size_t         total = dictsize + insize;
+  size_t         anchor = dictsize;
+  outbuf_t       buf = { out, out + outsize, false };
+
+  if (total > MAX_INPUT)
+    return 0;
+
+  memset(head, 0xff, sizeof(head));
+
+  size_t pos = 0;
+  while (pos + LZ4_MIN_MATCH <= total) {
+    size_t best_len    = 0;
+    size_t best_offset = 0;
+
+    if (pos >= dictsize) {
+      int32_t candidate = head[hash4(base + pos)];
+
+      for (unsigned int depth = 0; candidate >= 0 && depth < MAX_CHAIN; depth++) {
+        size_t offset = pos - candidate;
+        size_t len    = 0;
+
+        if (offset > LZ4_MAX_OFFSET)
+          break;
+
+        while (pos + len < total && base[candidate + len] == base[pos + len]) {
+          len++;
+        }
+
+        if (len > best_len) {
+          best_len    = len;
+          best_offset = offset;
+        }
+
+        candidate = chain[candidate];
+      }
+    }
+
+    if (best_len < LZ4_MIN_MATCH) {
+      chain[pos] = head[hash4(base + pos)];
+      head[hash4(base + pos)] = pos;
+      pos++;
+      continue;
+    }
+
+    put_sequence(&buf, base + anchor, pos - anchor, best_offset, best_len);
+
+    for (size_t end = pos + best_len; pos < end; pos++) {
+      if (pos + LZ4_MIN_MATCH <= total) {
+        chain[pos] = head[hash4(base + pos)];
+        head[hash4(base + pos)] = pos;
+      }
+    }
+
+    anchor = pos;
+  }
+
+  /* the last sequence only has literals */
+  put_sequence(&buf, base + anchor, total - anchor, 0, 0);
+
+  if (buf.overflow)
+    return 0;
+
+  return buf.ptr - out;
+}
+
+
+/* ---------------- */
+/* --- exomizer --- */
+/* ---------------- */
+
+/* bit counts of the decoding table: lengths, offsets for lengths */
+/* of three or more, offsets for length 2 and for length 1        */
+static const uint8_t exo_bits[52] = {
+  0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 6, 7, 8, 9, 10,
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 12, 12, 12,
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 12, 12, 12,
+  0, 1, 2, 3
+};
+
+#define EXO_LENGTHS    0
+#define EXO_OFFSETS3   16
+#define EXO_OFFSETS2   32
+#define EXO_OFFSETS1   48
+#define EXO_MAX_LENGTH 2078 // base + range of the last length entry
+
+/* the stream is built in the order exo_decrunch reads it and reversed */
+/* at the end. Bit bytes are inserted at the point where the decoder   */
+/* fetches them, between the plain bytes.                              */
+typedef struct {
+  outbuf_t buf;
+  uint8_t *bitbyte;
+  unsigned int bitcount;
+} exowriter_t;
+
+static void exo_put_bit(exowriter_t *w, unsigned int bit) {
+  if (w->bitcount == 8 || w->bitbyte == NULL) {
+    w->bitbyte = w->buf.ptr;
+    w->bitcount = 0;
+    put_byte(&w->buf, 0);
+    if (w->buf.overflow) {
+      w->bitbyte = NULL;
+      return;
+    }
+  }
+
+  if (bit)
+    *w->bitbyte |= 0x80 >> w->bitcount;
+  w->bitcount++;
+}
+
+/* same split as read_bits: the low byte is read as a plain byte */
+static void exo_put_bits(exowriter_t *w, unsigned int count, unsigned int value) {
+  unsigned int high = (count & 8) ? value >> 8 : value;
+
+  for (int i = (count & 7) - 1; i >= 0; i--) {
+    exo_put_bit(w, (high >> i) & 1);
+  }
+
+  if (count & 8)
+    put_byte(&w->buf, value & 0xff);
+}
+
+/* find the table entry for value in a 16 entry group, -1 if too large */
+static int exo_find_index(unsigned int group, unsigned int value) {
+  unsigned int base = 1;
+
+  for (unsigned int i = group; i < group + 16 && i < 52; i++) {
+    if (value >= base && value < base + (1U << exo_bits[i]))
+      return i;
+
+    base += 1 << exo_bits[i];
+  }
+
+  return -1;
+}
+
+static unsigned int exo_base(unsigned int index) {
+  unsigned int base = 1;
+
+  for (unsigned int i = index & ~15; i < index; i++) {
+    base += 1 << exo_bits[i];
+  }
+
+  return base;
+}
+
+static int exo_offset_index(unsigned int length, unsigned int offset) {
+  if (length == 1) {
+    int index = exo_find_index(EXO_OFFSETS1, offset);
+    return index < 0 || index >= EXO_OFFSETS1 + 4 ? -1 : index;
+  } else if (length == 2) {
+    return exo_find_index(EXO_OFFSETS2, offset);
+  } else {
+    return exo_find_index(EXO_OFFSETS3, offset);
+  }
+}
+
+/* positions are hashed together with the byte in front of them, */
+/* which is the order in which the decoder produces them          */
+static int32_t exo_head[1 << 16];
+static int32_t exo_chain[MAX_INPUT];
+
+static unsigned int exo_key(const uint8_t *in, int pos) {
+  return (in[pos] << 8) | in[pos - 1];
+}
+
+static void exo_insert(const uint8_t *in, int pos) {
+  unsigned int key = exo_key(in, pos);
+
+  exo_chain[pos] = exo_head[key];
+  exo_head[key]  = pos;
+}
+
+size_t exo_encode(const uint8_t *in, size_t insize, uint8_t *out, size_t outsize) {
+  exowriter_t w = { { out, out + outsize, false }, NULL, 8 };
+
+  if (insize == 0 || insize > MAX_INPUT)
+    return 0;
+
+  memset(exo_head, 0xff, sizeof(exo_head));
+
+  /* initial bit buffer without any data bits */
+  put_byte(&w.buf, 0x80);
+
+  for (unsigned int i = 0; i < 52; i++) {
+    exo_put_bits(&w, 3, exo_bits[i] & 7);
+    exo_put_bits(&w, 1, exo_bits[i] >> 3);
+  }
+
+  /* the output is written backwards, starting with an implicit literal */
+  int pos = insize - 1;
+  put_byte(&w.buf, in[pos]);
+  pos--;
+
+  while (pos >= 0) {
+    /* data behind pos has been written and can be referenced */
+    exo_insert(in, pos + 1);
+
+    unsigned int best_len    = 0;
+    unsigned int best_offset = 0;
+    int32_t candidate = pos >= 1 ? exo_head[exo_key(in, pos)] : -1;
+
+    for (unsigned int depth = 0; candidate >= 0 && depth < MAX_CHAIN; depth++) {
+      unsigned int offset = candidate - pos;
+      unsigned int len    = 0;
+
+      while (len <= (unsigned int)pos && len < EXO_MAX_LENGTH &&
+             in[pos - len] == in[pos - len + offset]) {
+        len++;
+      }
+
+      if (len > best_len && exo_offset_index(len, offset) >= 0) {
+        best_len    = len;
+        best_offset = offset;
+      }
+
+      candidate = exo_chain[candidate];
+    }
+
+    if (best_len < 2) {
+      exo_put_bit(&w, 1);
+      put_byte(&w.buf, in[pos]);
+      pos--;
+      continue;
+    }
+
+    int length_index = exo_find_index(EXO_LENGTHS, best_len);
+    int offset_index = exo_offset_index(best_len, best_offset);
+
+    exo_put_bit(&w, 0);
+    for (int i = 0; i < length_index; i++) {
+      exo_put_bit(&w, 0);
+    }
+    exo_put_bit(&w, 1);
+    exo_put_bits(&w, exo_bits[length_index], best_len - exo_base(length_index));
+
+    if (best_len == 1)
+      exo_put_bits(&w, 2, offset_index - EXO_OFFSETS1);
+    else
+      exo_put_bits(&w, 4, offset_index & 15);
+    exo_put_bits(&w, exo_bits[offset_index], best_offset - exo_base(offset_index));
+
+    for (unsigned int i = 0; i < best_len; i++, pos--) {
+      if (i > 0)
+        exo_insert(in, pos + 1);
+    }
+  }
+
+  /* end of stream: table index 16 */
+  exo_put_bit(&w, 0);
+  for (unsigned int i = 0; i < 16; i++) {
+    exo_put_bit(&w, 0);
+  }
+  exo_put_bit(&w, 1);
+
+  if (w.buf.overflow)
+    return 0;
+
+  /* exo_decrunch reads from the end towards the start */
+  size_t length = w.buf.ptr - out;
+  for (size_t i = 0; i < length / 2; i++) {
+    uint8_t tmp = out[i];
+    out[i] = out[length - 1 - i];
+    out[length - 1 - i] = tmp;
+  }
+
+  return length;
+}
+
+
+/* ------------ */
+/* --- line --- */
+/* ------------ */
+
+size_t line_encode(const uint8_t *in, size_t insize, uint32_t *linedata,
+                   size_t maxwords) {
+  size_t datawords = insize / 2;
+  size_t used      = 2;
+
+  if (datawords > 0x3fff || maxwords < 2)
+    return 0;
+
+  linedata[1] = 0x4040 + ((datawords & 0x7f) | ((datawords & 0x3f80) << 1));
+
+  for (size_t group = 0; group < datawords; group += 7) {
+    uint32_t lowbits = 0;
+
+    if (used >= maxwords)
+      return 0;
+
+    size_t lowword = used++;
+    for (size_t i = 0; i < 7 && group + i < datawords; i++) {
+      uint8_t hi = in[2 * (group + i)];
+      uint8_t lo = in[2 * (group + i) + 1];
+
+      if (used >= maxwords)
+        return 0;
+
+      lowbits |= ((hi & 1) << (8 + i)) | ((lo & 1) << i);
+      linedata[used++] = 0x4040 + (((hi >> 1) << 8) | (lo >> 1));
+    }
+
+    linedata[lowword] = 0x4040 + lowbits;
+  }
+
+  return used;
+}
@@ -0,0 +1,52 @@
+/* GCVideo DVI Firmware
+
+   Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+   THE POSSIBILITY OF SUCH DAMAGE.
+
+
+   encoders.h: Host-side encoders for the update decoding checks
+
+*/
+
+#ifndef ENCODERS_H
+#define ENCODERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* all encoders return the number of bytes written to out */
+/* or 0 if the result does not fit into outsize bytes     */
+
+/* LZ4 block, matches may reach into the dictsize bytes in front of in */
+size_t lz4_encode(const uint8_t *in, size_t insize, size_t dictsize,
+                  uint8_t *out, size_t outsize);
+
+/* exomizer raw stream as read backwards by exo_decrunch */
+size_t exo_encode(const uint8_t *in, size_t insize, uint8_t *out, size_t outsize);
+
+/* reverse of updateline_decode, output words are in linedata format */
+size_t line_encode(const uint8_t *in, size_t insize, uint32_t *linedata,
+                   size_t maxwords);
+
+#endif
@@ -0,0 +1,349 @@
+/* GCVideo DVI Firmware
+
+   Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+   THE POSSIBILITY OF SUCH DAMAGE.
+
+
+   fuzz.c: Fuzz target for the flasher's update decoding
+
+   Every input goes through the line decoder, the chunk decoder and both
+   decompressors, and is used as plain data for encode/decode round
+   trips. Build with "make fuzz-libfuzzer" for a libFuzzer binary; the
+   plain "make fuzz" build has a small driver that replays files and
+   feeds random and mutated valid inputs to the same entry point.
+
+*/
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "encoders.h"
+#include "exodecr.h"
+#include "flasher.h"
+#include "lz4dec.h"
+#include "updateline.h"
+
+#define CAPTURE_WORDS  1024
+#define MAX_CHUNKS     64
+#define MAX_INPUT_SIZE 8192
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/* exactly sized, so the sanitizers catch accesses beyond the ends */
+static uint32_t linedata[CAPTURE_WORDS];
+static uint8_t __attribute__((aligned(4))) decodebuf[DECODEBUFFER_SIZE];
+static char     chunkbuffer[DICTIONARY_SIZE + LARGE_CHUNK_SIZE];
+static uint8_t  roundtrip[DICTIONARY_SIZE + LARGE_CHUNK_SIZE];
+static uint8_t  packed[2 * LARGE_CHUNK_SIZE + 1024];
+
+/* copy the input to its own allocation so reads beyond it are caught */
+static uint8_t *copy_input(const uint8_t *data, size_t size) {
+  uint8_t *copy = malloc(size ? size : 1);
+
+  if (copy == NULL)
+    abort();
+
+  memcpy(copy, data, size);
+  return copy;
+}
+
+static void unpack_chunks(const uint8_t *ptr, const uint8_t *end) {
+  for (unsigned int i = 0; i < MAX_CHUNKS; i++) {
+    uint32_t offset;
+    unsigned int chunksize =
+      updateline_unpack_chunk(&ptr, end, chunkbuffer + DICTIONARY_SIZE,
+                              DICTIONARY_SIZE, &offset);
+
+    if (chunksize == 0)
+      return;
+
+    if (offset + chunksize > MAIN_APP_SIZE)
+      abort();
+  }
+}
+
+/* input as capture words, like ZPULineCapture delivers them */
+static void fuzz_line(const uint8_t *data, size_t size) {
+  memset(linedata, 0, sizeof(linedata));
+
+  for (size_t i = 0; i < CAPTURE_WORDS && 2 * i + 1 < size; i++) {
+    linedata[i] = (data[2 * i] << 8) | data[2 * i + 1];
+  }
+
+  size_t length = updateline_decode(linedata, decodebuf, sizeof(decodebuf));
+  if (length > sizeof(decodebuf))
+    abort();
+
+  /* the chunks are parsed even if the CRC does not match */
+  updateline_validate(decodebuf, length, linedata[0]);
+
+  if (length > 5)
+    unpack_chunks(decodebuf + 5, decodebuf + length);
+}
+
+static void fuzz_decoders(const uint8_t *data, size_t size) {
+  uint8_t *input = copy_input(data, size);
+
+  unpack_chunks(input, input + size);
+
+  exo_decrunch((const char *)input + size, size,
+               chunkbuffer + sizeof(chunkbuffer), LARGE_CHUNK_SIZE);
+
+  lz4_decode(input, size, (uint8_t *)chunkbuffer + DICTIONARY_SIZE,
+             LARGE_CHUNK_SIZE, DICTIONARY_SIZE);
+
+  free(input);
+}
+
+/* the input as plain data must survive all encoders and decoders */
+static void fuzz_roundtrip(const uint8_t *data, size_t size) {
+  size_t dictsize = size / 4 < DICTIONARY_SIZE ? size / 4 : DICTIONARY_SIZE;
+  size_t datasize = size - dictsize;
+
+  if (size == 0)
+    return;
+
+  if (datasize > LARGE_CHUNK_SIZE)
+    datasize = LARGE_CHUNK_SIZE;
+
+  /* exomizer, without a dictionary */
+  size_t packedsize = exo_encode(data, size < LARGE_CHUNK_SIZE ? size : LARGE_CHUNK_SIZE,
+                                 packed, sizeof(packed));
+  if (packedsize > 0) {
+    size_t outsize  = size < LARGE_CHUNK_SIZE ? size : LARGE_CHUNK_SIZE;
+    uint8_t *input  = copy_input(packed, packedsize);
+    char *startptr  = exo_decrunch((const char *)input + packedsize, packedsize,
+                                   (char *)roundtrip + sizeof(roundtrip), outsize);
+
+    if (startptr != (char *)roundtrip + sizeof(roundtrip) - outsize ||
+        memcmp(startptr, data, outsize))
+      abort();
+
+    free(input);
+  }
+
+  /* LZ4 with the start of the input as dictionary */
+  memcpy(roundtrip + DICTIONARY_SIZE - dictsize, data, dictsize);
+  packedsize = lz4_encode(data + dictsize, datasize, dictsize, packed, sizeof(packed));
+  if (packedsize > 0) {
+    uint8_t *input = copy_input(packed, packedsize);
+    size_t decoded = lz4_decode(input, packedsize, roundtrip + DICTIONARY_SIZE,
+                                datasize, dictsize);
+
+    if (decoded != datasize || memcmp(roundtrip + DICTIONARY_SIZE, data + dictsize, datasize))
+      abort();
+
+    free(input);
+  }
+
+  /* line encoding */
+  size_t linebytes = size & ~1;
+  if (linebytes > DECODEBUFFER_SIZE)
+    linebytes = DECODEBUFFER_SIZE;
+
+  memset(linedata, 0, sizeof(linedata));
+  if (line_encode(data, linebytes, linedata, CAPTURE_WORDS) > 0) {
+    size_t length = updateline_decode(linedata, decodebuf, sizeof(decodebuf));
+
+    if (length != linebytes || memcmp(decodebuf, data, linebytes))
+      abort();
+  }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  fuzz_line(data, size);
+  fuzz_decoders(data, size);
+  fuzz_roundtrip(data, size);
+  return 0;
+}
+
+
+#ifndef FUZZ_LIBFUZZER
+
+/* ------------------------- */
+/* --- standalone driver --- */
+/* ------------------------- */
+
+static uint64_t rng_state = 1;
+
+/* xorshift64*, same as updatesim */
+static uint32_t random_u32(void) {
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+
+  return (rng_state * 0x2545f4914f6cdd1dULL) >> 32;
+}
+
+/* somewhat compressible data, so the encoders produce matches */
+static void random_data(uint8_t *buffer, size_t size) {
+  size_t pos = 0;
+
+  while (pos < size) {
+    if (pos > 0 && random_u32() % 3 == 0) {
+      size_t offset = 1 + random_u32() % pos;
+      size_t length = 2 + random_u32() % 40;
+
+      for (size_t i = 0; i < length && pos < size; i++, pos++) {
+        buffer[pos] = buffer[pos - offset];
+      }
+    } else {
+      buffer[pos++] = random_u32() % 4 ? random_u32() % 16 : random_u32();
+    }
+  }
+}
+
+static void flip_bits(uint8_t *buffer, size_t size) {
+  unsigned int flips = random_u32() % 4;
+
+  for (unsigned int i = 0; i < flips && size > 0; i++) {
+    buffer[random_u32() % size] ^= 1 << (random_u32() % 8);
+  }
+}
+
+/* random data or a damaged encoding of it */
+static size_t make_input(uint8_t *buffer, size_t maxsize) {
+  static uint8_t plain[LARGE_CHUNK_SIZE];
+  size_t plainsize = 1 + random_u32() % sizeof(plain);
+  size_t size = 0;
+
+  random_data(plain, plainsize);
+
+  switch (random_u32() % 5) {
+  case 0:
+    size = plainsize < maxsize ? plainsize : maxsize;
+    memcpy(buffer, plain, size);
+    break;
+
+  case 1:
+    size = exo_encode(plain, plainsize, buffer, maxsize);
+    break;
+
+  case 2:
+    size = lz4_encode(plain, plainsize, 0, buffer, maxsize);
+    break;
+
+  case 3:
+    /* a single chunk */
+    if (maxsize < 3)
+      break;
+
+    if (random_u32() % 2) {
+      plainsize = LARGE_CHUNK_SIZE;
+      random_data(plain, plainsize);
+      size = lz4_encode(plain, plainsize, 0, buffer + 3, maxsize - 3);
+      buffer[0] = (random_u32() % 64) * 4;
+      buffer[1] = ((size | CHUNK_FLAG_LZ | CHUNK_FLAG_LARGE) >> 8) & 0xff;
+    } else {
+      plainsize = UNCOMPRESSED_CHUNK_SIZE;
+      random_data(plain, plainsize);
+      size = exo_encode(plain, plainsize, buffer + 3, maxsize - 3);
+      buffer[0] = random_u32() % 256;
+      buffer[1] = size >> 8;
+    }
+
+    buffer[2] = size & 0xff;
+    if (size > 0)
+      size += 3;
+    break;
+
+  case 4: {
+    /* a captured line */
+    size_t words = line_encode(plain, plainsize < DECODEBUFFER_SIZE ? plainsize & ~1 : DECODEBUFFER_SIZE,
+                               linedata, maxsize / 2);
+    for (size_t i = 0; i < words; i++) {
+      buffer[2 * i]     = linedata[i] >> 8;
+      buffer[2 * i + 1] = linedata[i] & 0xff;
+    }
+    size = 2 * words;
+    break;
+  }
+  }
+
+  if (size == 0) {
+    size = plainsize < maxsize ? plainsize : maxsize;
+    memcpy(buffer, plain, size);
+  }
+
+  flip_bits(buffer, size);
+  return size;
+}
+
+static bool run_file(const char *filename) {
+  FILE *fd = fopen(filename, "rb");
+
+  if (fd == NULL) {
+    perror(filename);
+    return false;
+  }
+
+  static uint8_t buffer[MAX_INPUT_SIZE];
+  size_t size = fread(buffer, 1, sizeof(buffer), fd);
+  fclose(fd);
+
+  LLVMFuzzerTestOneInput(buffer, size);
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  unsigned long runs = 10000;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:x:h")) != -1) {
+    switch (opt) {
+    case 'n': runs      = strtoul(optarg, NULL, 0); break;
+    case 'x': rng_state = strtoull(optarg, NULL, 0) | 1; break;
+    default:
+      printf("Usage: %s [-n runs] [-x seed] [input files]\n\n"
+             "Replays the given inputs or, without any, runs the decoders\n"
+             "on random and damaged valid inputs (default 10000 runs)\n",
+             argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  if (optind < argc) {
+    for (int i = optind; i < argc; i++) {
+      if (!run_file(argv[i]))
+        return 2;
+    }
+
+    printf("%d inputs ok\n", argc - optind);
+    return 0;
+  }
+
+  static uint8_t buffer[MAX_INPUT_SIZE];
+  for (unsigned long i = 0; i < runs; i++) {
+    size_t size = make_input(buffer, sizeof(buffer));
+    LLVMFuzzerTestOneInput(buffer, size);
+  }
+
+  printf("%lu runs ok\n", runs);
+  return 0;
+}
+
+#endif
@@ -0,0 +1,145 @@
+#!/usr/bin/env perl
+#
+# GCVideo DVI Firmware
+# Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# 1. Redistributions of source code must retain the above copyright notice,
+#    this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+#    this list of conditions and the following disclaimer in the documentation
+#    and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+# THE POSSIBILITY OF SUCH DAMAGE.
+#
+# mkcorpus.pl: Build a fuzzing seed corpus and benchmark lines with the
+#              encoders of buildupdate.pl
+#
+
+use FindBin;
+use warnings;
+use strict;
+use feature ':5.10';
+
+# constants and encoders of the real update builder
+BEGIN { require "$FindBin::Bin/../../HDL/gcvideo_dvi/scripts/buildupdate.pl"; }
+
+use constant IMAGE_SIZE    => 0x10000;
+use constant FIRMWARE_PAGE => INFO_PAGE + 1;
+
+if (scalar(@ARGV) < 1 || scalar(@ARGV) > 2) {
+    say "Usage: $0 outputdir [firmware.bin]";
+    exit 1;
+}
+
+my $outdir = shift;
+my $image;
+
+if (scalar(@ARGV) > 0) {
+    my $inname = shift;
+
+    open IN, "<", $inname or do {
+        say STDERR "ERROR: Unable to open $inname: $!";
+        exit 2;
+    };
+    binmode IN;
+    sysread(IN, $image, -s $inname);
+    close IN;
+    $image = substr($image, 0, IMAGE_SIZE);
+} else {
+    # something like code: small values, many repeats
+    my $state = 1;
+    my @bytes;
+
+    while (scalar(@bytes) < IMAGE_SIZE) {
+        $state = ($state * 1103515245 + 12345) % 2**31;
+        my $random = $state >> 4;
+
+        if (scalar(@bytes) >= 64 && $random % 4 == 0) {
+            my $pos    = scalar(@bytes);
+            my $offset = 1 + ($random >> 2) % ($pos < 4096 ? $pos : 4096);
+            my $length = 3 + ($random >> 14) % 24;
+
+            for (my $i = 0; $i < $length && scalar(@bytes) < IMAGE_SIZE; $i++) {
+                push @bytes, $bytes[$pos + $i - $offset];
+            }
+        } else {
+            push @bytes, ($random >> 8) % 8 ? ($random >> 12) % 32 : ($random >> 16) & 0xff;
+        }
+    }
+
+    $image = pack("C*", @bytes);
+}
+
+mkdir $outdir unless -d $outdir;
+
+sub write_file {
+    my $name = shift;
+    my $data = shift;
+
+    open OUT, ">", "$outdir/$name" or do {
+        say STDERR "ERROR: Unable to write to $outdir/$name: $!";
+        exit 2;
+    };
+    binmode OUT;
+    print OUT $data;
+    close OUT;
+}
+
+# an encoded line as ZPULineCapture stores it: without the marker pixel
+# and with the luma offset removed, one 16 bit word per pixel
+sub capture_words {
+    my @pixels = unpack("n*", shift);
+
+    shift @pixels;
+    return pack("n*", map { ($_ - 0x1000) & 0xffff } @pixels);
+}
+
+# the same variants that an updater with all options would transmit
+my %opts = (lz => 1, large => 1, newformat => 1, policy => "time");
+$opts{dict} = build_dictionary($image);
+
+my @blocks = compress_firmware("corpus", $image, \%opts);
+my @lines  = binpack(LINE_BYTES, 0, @blocks);
+
+my $infoline = pack("nnnNnna8", 0, INFO_FORMAT_LZDICT, 1, 0x47434455,
+                    scalar(@lines), FIRMWARE_PAGE, "corpus");
+
+write_file("line-info.bin", capture_words(encode_line($infoline, 0, INFO_PAGE)));
+write_file("line-dict.bin", capture_words(encode_line($opts{dict}, DICT_LINE, INFO_PAGE)));
+
+my $benchlines = "";
+my $codecfiles = 0;
+
+for (my $i = 0; $i < scalar(@lines); $i++) {
+    my $captured = capture_words(encode_line($lines[$i], $i, FIRMWARE_PAGE));
+
+    write_file(sprintf("line-%03d.bin", $i), $captured);
+    write_file(sprintf("chunks-%03d.bin", $i), substr($lines[$i], 1));
+    $benchlines .= $captured;
+}
+
+# individual compressed chunks for the decompressors
+foreach my $block (@blocks) {
+    my ($chunknum, $lenfield, $cdata) = unpack("Cna*", $block);
+
+    next if $lenfield == BLOCKSIZE;
+    write_file(sprintf("%s-%03d.bin", $lenfield & CHUNK_FLAG_LZ ? "lz4" : "exo", $codecfiles++), $cdata);
+}
+
+write_file("bench-lines.dat", $benchlines);
+
+say "$outdir: ", scalar(@lines) + 2, " lines, ", $codecfiles, " compressed chunks";
@@ -0,0 +1,863 @@
+/* GCVideo DVI Firmware
+
+   Copyright (C) 2015-2021, Ingo Korb <ingo@akana.de>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+   THE POSSIBILITY OF SUCH DAMAGE.
+
+
+   updatesim.c: Host-side simulation of the firmware update transport
+
+   Renders the screens of a configured updater DOL the way the updater
+   copies them to its XFB, passes them through a model of the video bus
+   and ZPULineCapture and runs the flasher's line decoding on the result.
+   Bit errors, stuck bits and dropped lines can be injected to see how
+   they affect the time needed to complete an update.
+
+*/
+
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "crc32mpeg.h"
+#include "flasher.h"
+#include "updateline.h"
+
+/* updater */
+#define TARGET_ADDRESS      0x80800000
+#define DOL_SECTIONS        18
+#define XFB_WIDTH           720
+#define XFB_HEIGHT          480
+#define XFB_ROW_BYTES       (2 * XFB_WIDTH)
+#define START_LINE          80
+
+/* video timing, NTSC 480i */
+#define FIELD_TIME          (1001.0 / 60000.0)
+#define FRAME_TIME          (2 * FIELD_TIME)
+#define ROW_TIME            (FIELD_TIME / 262.5)
+#define FIRST_ACTIVE_ROW    21
+#define PIXELS_PER_ROW      858
+
+/* flasher, busy times use the same model as buildupdate.pl */
+#define LINE_TIME           0.01
+#define CPU_CLOCK           54000000.0
+#define RAW_CYCLES          4
+#define EXO_CYCLES          300
+#define LZ_CYCLES           30
+#define PAGE_PROGRAM_TIME   0.0015
+#define SECTOR_ERASE_TIME   0.6
+#define ERASE_BLOCK_SIZE    0x10000
+#define MAIN_IMAGE_SIZE     0x50000
+#define IMAGE_BLOCKS        4 // sectors below the settings, erased ahead
+#define IMAGE_HEADER_SIZE   20
+#define MARKER_OFFSET       0x3ff00 // install marker page behind the image
+#define CAPTURE_WORDS       1024
+#define MAX_LINES           256
+
+typedef enum {
+  RESULT_OK,
+  RESULT_TIMEOUT,
+  RESULT_CORRUPTED,
+  RESULT_BADIMAGE,
+  RESULT_COUNT
+} result_t;
+
+static const char *result_names[RESULT_COUNT] = {
+  "completed",
+  "timed out",
+  "data corrupted",
+  "installation failed",
+};
+
+typedef struct {
+  uint32_t hardware_id;
+  unsigned int lines;
+  unsigned int page;
+  char version[9];
+  bool have_dictionary;
+} updateinfo_t;
+
+/* simulation parameters */
+static double   bit_error_rate;
+static uint8_t  error_mask = 0xff;
+static uint8_t  stuck_zero;
+static uint8_t  stuck_one;
+static double   drop_rate;
+static double   timeout = 600;
+static unsigned int runs = 100;
+static uint64_t rng_state = 1;
+
+/* rendered update */
+static unsigned int screen_count;
+static const uint8_t *(*xfb_rows)[XFB_HEIGHT];
+static unsigned int display_order[XFB_HEIGHT];
+
+/* emulated hardware */
+static uint8_t  needed_lines[256];
+static uint8_t  selected_page;
+static uint32_t linedata[CAPTURE_WORDS];
+static uint64_t bits_to_error;
+static uint8_t  flash[MAIN_IMAGE_SIZE];
+static bool     erased_blocks[MAIN_IMAGE_SIZE / ERASE_BLOCK_SIZE];
+static unsigned int next_erase_block;
+static double   flash_busy_until;
+static double   buffer_free_at;
+static double   armed_at = -1;
+
+static uint8_t __attribute__((aligned(4))) decodebuf[DECODEBUFFER_SIZE];
+static char chunkbuffer[DICTIONARY_SIZE + LARGE_CHUNK_SIZE];
+static char *const decrunchbuffer = chunkbuffer + DICTIONARY_SIZE;
+
+
+/* ------------- */
+/* --- utils --- */
+/* ------------- */
+
+static uint32_t get_be32(const uint8_t *ptr) {
+  return ((uint32_t)ptr[0] << 24) | ((uint32_t)ptr[1] << 16) |
+         ((uint32_t)ptr[2] <<  8) | ptr[3];
+}
+
+/* xorshift64*, so runs are reproducible across C libraries */
+static double random_uniform(void) {
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+
+  /* (0, 1] */
+  return ((rng_state * 0x2545f4914f6cdd1dULL >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+/* number of bits that pass before the next bit error */
+static uint64_t draw_error_distance(void) {
+  if (bit_error_rate >= 1.0) {
+    return 0;
+  }
+
+  double distance = floor(log(random_uniform()) / log1p(-bit_error_rate));
+  if (distance > 1e18) {
+    return UINT64_MAX;
+  }
+
+  return distance;
+}
+
+static int compare_double(const void *a, const void *b) {
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+
+  return (da > db) - (da < db);
+}
+
+
+/* ------------------- */
+/* --- updater DOL --- */
+/* ------------------- */
+
+static uint8_t *read_file(const char *filename, size_t *size) {
+  FILE *file = fopen(filename, "rb");
+  if (file == NULL) {
+    perror(filename);
+    return NULL;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  uint8_t *data = malloc(length > 0 ? length : 1);
+  if (data == NULL || fread(data, 1, length, file) != (size_t)length) {
+    fprintf(stderr, "%s: read failed\n", filename);
+    fclose(file);
+    free(data);
+    return NULL;
+  }
+
+  fclose(file);
+  *size = length;
+  return data;
+}
+
+/* find the data section that the updater expects at TARGET_ADDRESS */
+static const uint8_t *find_update_data(const uint8_t *dol, size_t dolsize, size_t *datasize) {
+  if (dolsize < 0x100) {
+    return NULL;
+  }
+
+  for (unsigned int i = 0; i < DOL_SECTIONS; i++) {
+    uint32_t offset  = get_be32(dol + 4 * i);
+    uint32_t address = get_be32(dol + 0x48 + 4 * i);
+    uint32_t length  = get_be32(dol + 0x90 + 4 * i);
+
+    if (address == TARGET_ADDRESS && length > 0 &&
+        offset <= dolsize && length <= dolsize - offset) {
+      *datasize = length;
+      return dol + offset;
+    }
+  }
+
+  return NULL;
+}
+
+/* replay the memcpys of the updater to find the XFB contents during every screen */
+static bool render_screens(const uint8_t *data, size_t datasize) {
+  if (datasize < 20 || memcmp(data, "gcvupd10", 8)) {
+    fprintf(stderr, "Update data signature not found, is the updater configured?\n");
+    return false;
+  }
+
+  screen_count = get_be32(data + 16);
+  if (screen_count == 0 || 20 + 4 * (screen_count + 1) > datasize) {
+    fprintf(stderr, "Invalid screen count %u\n", screen_count);
+    return false;
+  }
+
+  xfb_rows = calloc(screen_count, sizeof(*xfb_rows));
+  if (xfb_rows == NULL) {
+    return false;
+  }
+
+  /* rows that are not overwritten keep the contents of earlier screens, */
+  /* so go through the carousel twice to get its steady state            */
+  const uint8_t *xfb[XFB_HEIGHT] = { NULL };
+
+  for (unsigned int pass = 0; pass < 2; pass++) {
+    for (unsigned int i = 0; i < screen_count; i++) {
+      uint32_t start = 4 * get_be32(data + 20 + 4 * i);
+      uint32_t end   = 4 * get_be32(data + 24 + 4 * i);
+
+      if (start > end || end > datasize ||
+          (end - start) % XFB_ROW_BYTES != 0 ||
+          (end - start) / XFB_ROW_BYTES > XFB_HEIGHT - START_LINE) {
+        fprintf(stderr, "Screen %u has an invalid size\n", i);
+        return false;
+      }
+
+      for (unsigned int row = 0; row < (end - start) / XFB_ROW_BYTES; row++) {
+        xfb[START_LINE + row] = data + start + row * XFB_ROW_BYTES;
+      }
+
+      memcpy(xfb_rows[i], xfb, sizeof(xfb));
+    }
+  }
+
+  /* even rows are shown in the first field, odd rows in the second */
+  for (unsigned int i = 0; i < XFB_HEIGHT; i++) {
+    display_order[i] = i < XFB_HEIGHT / 2 ? 2 * i : 2 * (i - XFB_HEIGHT / 2) + 1;
+  }
+
+  return true;
+}
+
+static double row_time(uint64_t frame, unsigned int row) {
+  return frame * FRAME_TIME + (row & 1) * FIELD_TIME +
+         (FIRST_ACTIVE_ROW + (row >> 1)) * ROW_TIME;
+}
+
+
+/* ------------------------- */
+/* --- video and capture --- */
+/* ------------------------- */
+
+/* one byte of a pixel as seen by GCVideo */
+static uint8_t transmit_byte(uint8_t value) {
+  if (bit_error_rate > 0) {
+    for (unsigned int bit = 0; bit < 8; bit++) {
+      if (!(error_mask & (1 << bit)))
+        continue;
+
+      if (bits_to_error == 0) {
+        value ^= 1 << bit;
+        bits_to_error = draw_error_distance();
+      } else {
+        bits_to_error--;
+      }
+    }
+  }
+
+  return (value & ~stuck_zero) | stuck_one;
+}
+
+/* one pixel in the format stored by ZPULineCapture */
+static uint32_t transmit_pixel(const uint8_t *pixel) {
+  uint8_t luma   = transmit_byte(pixel[0]) - 0x10;
+  uint8_t chroma = transmit_byte(pixel[1]);
+
+  return (luma << 8) | chroma;
+}
+
+/* wait for a wanted line like ZPULineCapture, advances *now to the end of */
+/* the captured line. Returns false if nothing was captured until timeout. */
+static bool capture_line(double *now, double deadline) {
+  uint64_t frame = *now / FRAME_TIME;
+
+  while (row_time(frame, 0) < deadline) {
+    const uint8_t *const *rows = xfb_rows[frame % screen_count];
+
+    for (unsigned int i = 0; i < XFB_HEIGHT; i++) {
+      unsigned int row = display_order[i];
+      double       time = row_time(frame, row);
+
+      if (time < *now || rows[row] == NULL)
+        continue;
+
+      if (time >= deadline)
+        return false;
+
+      if (drop_rate > 0 && random_uniform() <= drop_rate)
+        continue;
+
+      const uint8_t *pixels = rows[row];
+
+      /* marker at the start of the line */
+      if (transmit_pixel(pixels) != 0x55aa)
+        continue;
+
+      uint32_t lineinfo = transmit_pixel(pixels + 2);
+      if (!needed_lines[lineinfo >> 8] || (lineinfo & 0xff) != selected_page)
+        continue;
+
+      needed_lines[lineinfo >> 8] = 0;
+      linedata[0] = lineinfo;
+
+      for (unsigned int x = 2; x < XFB_WIDTH; x++) {
+        linedata[x - 1] = transmit_pixel(pixels + 2 * x);
+      }
+
+      *now = time + XFB_WIDTH * ROW_TIME / PIXELS_PER_ROW;
+      return true;
+    }
+
+    frame++;
+  }
+
+  return false;
+}
+
+/* background erase of the flasher while it waits for lines */
+static void erase_ahead(double from, double until) {
+  while (next_erase_block < IMAGE_BLOCKS) {
+    if (erased_blocks[next_erase_block]) {
+      next_erase_block++;
+      continue;
+    }
+
+    double begin = flash_busy_until > from ? flash_busy_until : from;
+    if (begin >= until)
+      break;
+
+    erased_blocks[next_erase_block] = true;
+    memset(flash + next_erase_block * ERASE_BLOCK_SIZE, 0xff, ERASE_BLOCK_SIZE);
+    flash_busy_until = begin + SECTOR_ERASE_TIME;
+  }
+}
+
+/* capture and decode lines until one passes the CRC check */
+static bool capture_valid_line(double *now, double deadline, size_t *length,
+                               unsigned int *rejected, unsigned int *line_rejects) {
+  double waitstart = *now;
+
+  while (1) {
+    /* the flasher arms the capture early while it writes the previous line */
+    double captured = armed_at >= 0 ? armed_at : *now;
+    armed_at = -1;
+
+    if (!capture_line(&captured, deadline))
+      return false;
+
+    if (captured > *now) {
+      erase_ahead(waitstart, captured);
+      *now = captured;
+    }
+
+    /* decoding time */
+    *now += LINE_TIME;
+    waitstart = *now;
+
+    *length = updateline_decode(linedata, decodebuf, sizeof(decodebuf));
+    if (updateline_validate(decodebuf, *length, linedata[0])) {
+      return true;
+    }
+
+    /* mark line as needed again */
+    needed_lines[linedata[0] >> 8] = 1;
+    line_rejects[linedata[0] >> 8]++;
+    (*rejected)++;
+  }
+}
+
+
+/* --------------- */
+/* --- flasher --- */
+/* --------------- */
+
+/* parse the info line like look_for_update does */
+static bool parse_info(const uint8_t *ptr, const uint8_t *end, uint32_t hardware_id,
+                       updateinfo_t *info) {
+  if (end - ptr < 2)
+    return false;
+
+  unsigned int fwcount = (ptr[0] << 8) | ptr[1];
+  ptr += 2;
+
+  info->have_dictionary = false;
+
+  if (fwcount == 0 && end - ptr >= 4) {
+    unsigned int format = (ptr[0] << 8) | ptr[1];
+
+    if (format == INFO_FORMAT_LZ || format == INFO_FORMAT_LZDICT) {
+      info->have_dictionary = (format == INFO_FORMAT_LZDICT);
+      fwcount = (ptr[2] << 8) | ptr[3];
+      ptr += 4;
+    }
+  }
+
+  for (unsigned int i = 0; i < fwcount && end - ptr >= 16; i++, ptr += 16) {
+    uint32_t entry_id = get_be32(ptr);
+
+    if (hardware_id != 0 && entry_id != hardware_id)
+      continue;
+
+    info->hardware_id = entry_id;
+    info->lines       = (ptr[4] << 8) | ptr[5];
+    info->page        = (ptr[6] << 8) | ptr[7];
+    memcpy(info->version, ptr + 8, 8);
+    info->version[8]  = 0;
+    return true;
+  }
+
+  return false;
+}
+
+static void write_flash(uint32_t offset, const char *data, unsigned int length) {
+  for (unsigned int i = 0; i < length && offset + i < MAIN_IMAGE_SIZE; i++) {
+    flash[offset + i] &= data[i];
+  }
+}
+
+/* check the written image like validate_main_image */
+static bool validate_image(uint32_t hardware_id) {
+  uint32_t length = get_be32(flash + 4);
+
+  if (length >= MARKER_OFFSET - IMAGE_HEADER_SIZE ||
+      get_be32(flash) != hardware_id) {
+    return false;
+  }
+
+  crc_t crc = crc_init();
+  crc = crc_update(crc, flash + IMAGE_HEADER_SIZE, length);
+  crc = crc_finalize(crc);
+
+  return crc == get_be32(flash + 8);
+}
+
+/* run the flasher from the given start time until the update is installed */
+static result_t simulate_update(const updateinfo_t *target, double start, double *duration,
+                                unsigned int *rejected, unsigned int *line_rejects) {
+  double now = start;
+  double deadline = start + timeout;
+  unsigned int dictionary_size = 0;
+  updateinfo_t info;
+  size_t length;
+
+  *rejected = 0;
+  memset(flash, 0x00, sizeof(flash)); // contents of the old firmware do not matter
+  next_erase_block = IMAGE_BLOCKS;
+  armed_at = -1;
+
+  /* grab info line */
+  memset(needed_lines, 0, sizeof(needed_lines));
+  needed_lines[INFO_LINE] = 1;
+  selected_page = INFO_PAGE;
+
+  do {
+    if (!capture_valid_line(&now, deadline, &length, rejected, line_rejects))
+      return RESULT_TIMEOUT;
+  } while (!parse_info(decodebuf + 4, decodebuf + length, target->hardware_id, &info));
+
+  /* the user confirms instantly, the first sector erase starts right away */
+  memset(erased_blocks, 0, sizeof(erased_blocks));
+  next_erase_block = 0;
+  flash_busy_until = now;
+  buffer_free_at   = now;
+  erase_ahead(now, now + SECTOR_ERASE_TIME);
+
+  if (info.have_dictionary) {
+    memset(needed_lines, 0, sizeof(needed_lines));
+    needed_lines[DICTIONARY_LINE] = 1;
+    selected_page = INFO_PAGE;
+
+    if (!capture_valid_line(&now, deadline, &length, rejected, line_rejects))
+      return RESULT_TIMEOUT;
+
+    dictionary_size = length - 4;
+    if (dictionary_size > DICTIONARY_SIZE)
+      return RESULT_CORRUPTED;
+
+    memcpy(decrunchbuffer - dictionary_size, decodebuf + 4, dictionary_size);
+  }
+
+  /* grab pieces of the update and apply them */
+  memset(line_rejects, 0, MAX_LINES * sizeof(*line_rejects));
+  memset(needed_lines, 0, sizeof(needed_lines));
+  memset(needed_lines, 1, info.lines);
+  selected_page = info.page;
+
+  for (unsigned int remain = info.lines; remain > 0; remain--) {
+    if (!capture_valid_line(&now, deadline, &length, rejected, line_rejects))
+      return RESULT_TIMEOUT;
+
+    if (remain > 1)
+      armed_at = now;
+
+    const uint8_t *readptr = decodebuf + 4;
+    const uint8_t *end     = decodebuf + length;
+    unsigned int   chunks  = *readptr++;
+
+    for (unsigned int i = 0; i < chunks; i++) {
+      unsigned int cycles = EXO_CYCLES;
+
+      /* spiflash_wait_buffer */
+      if (now < buffer_free_at)
+        now = buffer_free_at;
+
+      if (end - readptr >= 3) {
+        unsigned int chunklen = (readptr[1] << 8) | readptr[2];
+
+        if (chunklen & CHUNK_FLAG_LZ) {
+          cycles = LZ_CYCLES;
+        } else if (chunklen == UNCOMPRESSED_CHUNK_SIZE) {
+          cycles = RAW_CYCLES;
+        }
+      }
+
+      uint32_t offset;
+      unsigned int chunksize =
+        updateline_unpack_chunk(&readptr, end, decrunchbuffer, dictionary_size, &offset);
+
+      if (chunksize == 0 || offset + chunksize > MAIN_IMAGE_SIZE)
+        return RESULT_CORRUPTED;
+
+      now += chunksize * cycles / CPU_CLOCK;
+
+      /* starting an erase or program waits for the previous one */
+      if (now < flash_busy_until)
+        now = flash_busy_until;
+
+      if (!erased_blocks[offset / ERASE_BLOCK_SIZE]) {
+        erased_blocks[offset / ERASE_BLOCK_SIZE] = true;
+        memset(flash + (offset & ~(ERASE_BLOCK_SIZE - 1)), 0xff, ERASE_BLOCK_SIZE);
+        now += SECTOR_ERASE_TIME;
+      }
+
+      /* the buffer is free once the last page has been sent */
+      write_flash(offset, decrunchbuffer, chunksize);
+      buffer_free_at   = now + (chunksize / 256 - 1) * PAGE_PROGRAM_TIME;
+      flash_busy_until = now + chunksize / 256 * PAGE_PROGRAM_TIME;
+    }
+  }
+
+  /* spiflash_complete */
+  if (now < flash_busy_until)
+    now = flash_busy_until;
+
+  *duration = now - start;
+
+  if (!validate_image(info.hardware_id))
+    return RESULT_BADIMAGE;
+
+  return RESULT_OK;
+}
+
+/* decode the info line of the first screen without any errors */
+static bool read_update_info(uint32_t hardware_id, updateinfo_t *info) {
+  const uint8_t *const *rows = xfb_rows[0];
+
+  for (unsigned int row = START_LINE; row < XFB_HEIGHT; row++) {
+    const uint8_t *pixels = rows[row];
+
+    if (pixels == NULL || pixels[0] != 0x65 || pixels[1] != 0xaa ||
+        pixels[2] != INFO_LINE + 0x10 || pixels[3] != INFO_PAGE)
+      continue;
+
+    linedata[0] = (INFO_LINE << 8) | INFO_PAGE;
+    for (unsigned int x = 2; x < XFB_WIDTH; x++) {
+      linedata[x - 1] = ((pixels[2 * x] - 0x10) << 8) | pixels[2 * x + 1];
+    }
+
+    size_t length = updateline_decode(linedata, decodebuf, sizeof(decodebuf));
+    if (!updateline_validate(decodebuf, length, linedata[0]))
+      continue;
+
+    return parse_info(decodebuf + 4, decodebuf + length, hardware_id, info);
+  }
+
+  return false;
+}
+
+
+/* -------------------- */
+/* --- chunk checks --- */
+/* -------------------- */
+
+/* LZ4 block that expands to LARGE_CHUNK_SIZE bytes: one literal, then */
+/* a single match at offset 1 with 4076 extra bytes of match length     */
+static const uint8_t large_lz_block[] = {
+  0x1f, 'G', 0x01, 0x00,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 251
+};
+
+static unsigned int check_chunk(unsigned int chunknum, unsigned int flags,
+                                const uint8_t *payload, unsigned int length,
+                                uint32_t *offset) {
+  uint8_t chunk[3 + UNCOMPRESSED_CHUNK_SIZE];
+  const uint8_t *readptr = chunk;
+
+  chunk[0] = chunknum;
+  chunk[1] = (length | flags) >> 8;
+  chunk[2] = (length | flags) & 0xff;
+  memcpy(chunk + 3, payload, length);
+
+  unsigned int chunksize =
+    updateline_unpack_chunk(&readptr, chunk + 3 + length, decrunchbuffer, 0, offset);
+
+  if (chunksize != 0 && readptr != chunk + 3 + length)
+    return 0;
+
+  return chunksize;
+}
+
+/* feed a few hand-made chunks to updateline_unpack_chunk */
+static bool check_chunks(void) {
+  static uint8_t raw[UNCOMPRESSED_CHUNK_SIZE];
+  bool ok = true;
+  uint32_t offset;
+
+  const struct {
+    const char   *name;
+    unsigned int  chunknum;
+    unsigned int  flags;
+    const uint8_t *payload;
+    unsigned int  length;
+    unsigned int  expected; // chunk size, 0 if it must be rejected
+  } cases[] = {
+    { "raw chunk",                      5, 0, raw, sizeof(raw), UNCOMPRESSED_CHUNK_SIZE },
+    { "raw chunk at the end",         255, 0, raw, sizeof(raw), UNCOMPRESSED_CHUNK_SIZE },
+    { "truncated raw chunk",            5, 0, raw, sizeof(raw) - 1, 0 },
+    { "large chunk",                    4, CHUNK_FLAG_LZ | CHUNK_FLAG_LARGE,
+      large_lz_block, sizeof(large_lz_block), LARGE_CHUNK_SIZE },
+    { "large chunk at the end",       252, CHUNK_FLAG_LZ | CHUNK_FLAG_LARGE,
+      large_lz_block, sizeof(large_lz_block), LARGE_CHUNK_SIZE },
+    { "misaligned large chunk (+1)",    5, CHUNK_FLAG_LZ | CHUNK_FLAG_LARGE,
+      large_lz_block, sizeof(large_lz_block), 0 },
+    { "misaligned large chunk (+2)",    6, CHUNK_FLAG_LZ | CHUNK_FLAG_LARGE,
+      large_lz_block, sizeof(large_lz_block), 0 },
+    { "large chunk past the end",     253, CHUNK_FLAG_LZ | CHUNK_FLAG_LARGE,
+      large_lz_block, sizeof(large_lz_block), 0 },
+    { "large chunk with short data",    4, CHUNK_FLAG_LZ | CHUNK_FLAG_LARGE,
+      large_lz_block, sizeof(large_lz_block) - 1, 0 },
+  };
+
+  for (unsigned int i = 0; i < sizeof(raw); i++) {
+    raw[i] = i * 7;
+  }
+
+  for (unsigned int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    unsigned int chunksize = check_chunk(cases[i].chunknum, cases[i].flags,
+                                         cases[i].payload, cases[i].length, &offset);
+    bool pass = chunksize == cases[i].expected;
+
+    if (pass && chunksize != 0)
+      pass = offset == cases[i].chunknum * UNCOMPRESSED_CHUNK_SIZE &&
+             offset + chunksize <= MAIN_APP_SIZE;
+
+    printf("%-30s %s\n", cases[i].name, pass ? "ok" : "FAILED");
+    ok = ok && pass;
+  }
+
+  return ok;
+}
+
+
+/* -------------- */
+/* --- report --- */
+/* -------------- */
+
+static void usage(const char *name) {
+  printf("Usage: %s [options] updater.dol\n\n"
+         "  -H hwid  hardware ID to update (default: first in the update)\n"
+         "  -b rate  bit error rate on the video bus\n"
+         "  -m mask  bits of each byte affected by bit errors (default 0xff)\n"
+         "  -s mask  bits stuck at 0\n"
+         "  -S mask  bits stuck at 1\n"
+         "  -d rate  probability of a line being dropped\n"
+         "  -r runs  number of simulated updates (default 100)\n"
+         "  -t secs  give up after this many seconds (default 600)\n"
+         "  -x seed  random seed\n"
+         "  -c       only check the chunk decoder with hand-made chunks\n",
+         name);
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t hardware_id = 0;
+  bool chunks_only = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "H:b:m:s:S:d:r:t:x:ch")) != -1) {
+    switch (opt) {
+    case 'H': hardware_id    = strtoul(optarg, NULL, 0); break;
+    case 'b': bit_error_rate = strtod(optarg, NULL);     break;
+    case 'm': error_mask     = strtoul(optarg, NULL, 0); break;
+    case 's': stuck_zero     = strtoul(optarg, NULL, 0); break;
+    case 'S': stuck_one      = strtoul(optarg, NULL, 0); break;
+    case 'd': drop_rate      = strtod(optarg, NULL);     break;
+    case 'r': runs           = strtoul(optarg, NULL, 0); break;
+    case 't': timeout        = strtod(optarg, NULL);     break;
+    case 'x': rng_state      = strtoull(optarg, NULL, 0) | 1; break;
+    case 'c': chunks_only    = true; break;
+    default:
+      usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  if (chunks_only)
+    return check_chunks() ? 0 : 1;
+
+  if (optind != argc - 1 || runs == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  size_t dolsize, datasize;
+  uint8_t *dol = read_file(argv[optind], &dolsize);
+  if (dol == NULL)
+    return 2;
+
+  const uint8_t *data = find_update_data(dol, dolsize, &datasize);
+  if (data == NULL) {
+    fprintf(stderr, "%s: no update data at 0x%08x\n", argv[optind], TARGET_ADDRESS);
+    return 2;
+  }
+
+  if (!render_screens(data, datasize))
+    return 2;
+
+  updateinfo_t target;
+  if (!read_update_info(hardware_id, &target)) {
+    fprintf(stderr, "No matching firmware found in the info line\n");
+    return 2;
+  }
+
+  if (target.lines > MAX_LINES) {
+    fprintf(stderr, "Firmware uses more lines than the capture hardware supports\n");
+    return 2;
+  }
+
+  printf("Update: %u screens, carousel period %.2f s\n",
+         screen_count, screen_count * FRAME_TIME);
+  printf("Target: 0x%08x, version %s, %u lines on page 0x%02x%s\n",
+         target.hardware_id, target.version, target.lines, target.page,
+         target.have_dictionary ? ", preset dictionary" : "");
+  printf("Errors: bit error rate %g (mask 0x%02x), stuck-0 0x%02x, stuck-1 0x%02x, drop rate %g\n\n",
+         bit_error_rate, error_mask, stuck_zero, stuck_one, drop_rate);
+
+  unsigned int results[RESULT_COUNT] = { 0 };
+  double      *durations  = malloc(runs * sizeof(double));
+  unsigned int completed  = 0;
+  unsigned long total_rejected = 0;
+  unsigned int max_rejected = 0;
+  unsigned int retry_histogram[8] = { 0 };
+  unsigned int line_rejects[MAX_LINES];
+
+  bits_to_error = bit_error_rate > 0 ? draw_error_distance() : 0;
+
+  for (unsigned int run = 0; run < runs; run++) {
+    double start = random_uniform() * screen_count * FRAME_TIME;
+    double duration;
+    unsigned int rejected;
+
+    result_t result = simulate_update(&target, start, &duration, &rejected, line_rejects);
+    results[result]++;
+
+    total_rejected += rejected;
+    if (rejected > max_rejected)
+      max_rejected = rejected;
+
+    if (result != RESULT_OK)
+      continue;
+
+    durations[completed++] = duration;
+
+    for (unsigned int i = 0; i < target.lines; i++) {
+      unsigned int bucket = line_rejects[i];
+
+      if (bucket >= sizeof(retry_histogram) / sizeof(retry_histogram[0]))
+        bucket = sizeof(retry_histogram) / sizeof(retry_histogram[0]) - 1;
+
+      retry_histogram[bucket]++;
+    }
+  }
+
+  printf("Runs: %u", runs);
+  for (unsigned int i = 0; i < RESULT_COUNT; i++) {
+    printf(", %s %u", result_names[i], results[i]);
+  }
+  printf("\n");
+
+  if (completed > 0) {
+    double sum = 0;
+
+    qsort(durations, completed, sizeof(double), compare_double);
+    for (unsigned int i = 0; i < completed; i++) {
+      sum += durations[i];
+    }
+
+    printf("Time to complete: min %.2f s, mean %.2f s, median %.2f s, p90 %.2f s, max %.2f s\n",
+           durations[0], sum / completed, durations[completed / 2],
+           durations[(completed * 9) / 10 < completed ? (completed * 9) / 10 : completed - 1],
+           durations[completed - 1]);
+  }
+
+  printf("Rejected captures per run: mean %.1f, max %u\n",
+         (double)total_rejected / runs, max_rejected);
+
+  if (completed > 0) {
+    unsigned int buckets = sizeof(retry_histogram) / sizeof(retry_histogram[0]);
+
+    printf("Retries per line in completed runs:\n");
+    for (unsigned int i = 0; i < buckets; i++) {
+      printf("  %u%s: %6u (%5.1f%%)\n", i, i == buckets - 1 ? "+" : " ",
+             retry_histogram[i], 100.0 * retry_histogram[i] / (completed * target.lines));
+    }
+  }
+
+  free(durations);
+  free(xfb_rows);
+  free(dol);
+
+  return results[RESULT_OK] == runs ? 0 : 1;
+}
@@ -41,10 +41,16 @@
 #define IRBUTTON_LONG_FRAMES 60
 
 volatile tick_t tick_counter;
+volatile uint32_t video_modes;
 
 static uint32_t prev_irbutton = IRRX_BUTTON;
 static uint8_t  irbutton_count;
 
+void videomode_handler(void) {
+  /* cache the classified video modes, reading also clears the IRQ */
+  video_modes = VIDEOIF->videomode;
+}
+
 void vsync_handler(void) {
   /* update tick counter */
   if (VIDEOIF->flags & VIDEOIF_FLAG_IN_PAL) {
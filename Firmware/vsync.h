@@ -33,6 +33,7 @@
 #define VSYNC_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #define HZ 300
 
@@ -43,6 +44,7 @@ typedef unsigned int  tick_t;
 typedef   signed int stick_t;
 
 extern volatile tick_t tick_counter;
+extern volatile uint32_t video_modes;
 
 static inline tick_t getticks(void) { return tick_counter; }
 
@@ -56,5 +58,6 @@ static inline bool time_after(tick_t a, tick_t b) {
 }
 
 void vsync_handler(void);
+void videomode_handler(void);
 
 #endif
@@ -39,28 +39,47 @@ my @modes = ( # order matters!
     "Audio Clock Regeneration 48042",
     "Source Product Description",
     "Audio",
-    "empty",
+    "Audio Clock Regeneration 48042 full rate",
 
     # same, but for Wii
     "Audio Clock Regeneration 48000",
     "empty",
     "empty",
-    "empty",
+    "Audio Clock Regeneration 48000 full rate",
 
-    # four slots filled in software
-    "empty", # 256 - RGB full range 4:3
-    "empty", # 288 - RGB limited range 4:3
-    "empty", # 320 - YCbCr 4:4:4 4:3
-    "empty", # 352 - YCbCr 4:2:2 4:3
-
-    # four slots filled in software
-    "empty", # 384 - RGB full range 16:9
-    "empty", # 416 - RGB limited range 16:9
-    "empty", # 448 - YCbCr 4:4:4 16:9
-    "empty", # 480 - YCbCr 4:2:2 16:9
+    # followed by the generated AVI infoframe sets, see below
+    );
 
+# AVI infoframe sets, one group of eight frames per set starting at 256
+# (set number must match infoframe.c)
+# each group is RGB full, RGB limited, YCbCr 4:4:4, YCbCr 4:2:2 in 4:3,
+# followed by the same for 16:9 (VIC + 1, VIC 0 stays 0)
+my @avi_sets = ( # name, 4:3 VIC, pixel repetition
+    [ "240p",        8, 1 ], # set 1
+    [ "288p",       23, 1 ], # set 2
+    [ "480i",        6, 1 ], # set 3, also used for spoofed 240p
+    [ "576i",       21, 1 ], # set 4, also used for spoofed 288p
+    [ "480p",        2, 0 ], # set 5
+    [ "576p",       17, 0 ], # set 6
+    [ "non-CEA",     0, 0 ], # set 7, 3x/4x line multiplied modes
     );
 
+# AVI infoframe data byte values
+use constant {
+    DB1_SCANINFO_OVERSCAN  => 1 << 0,
+    DB1_COLOR_RGB          => 0 << 5,
+    DB1_COLOR_YCBCR422     => 1 << 5,
+    DB1_COLOR_YCBCR444     => 2 << 5,
+    DB2_FRAMEASPECT_4_3    => 1 << 4,
+    DB2_FRAMEASPECT_16_9   => 2 << 4,
+    DB2_COLORIMETRY_NODATA => 0 << 6,
+    DB2_COLORIMETRY_170M   => 1 << 6,
+    DB3_RGB_LIMITEDRANGE   => 1 << 2,
+    DB3_RGB_FULLRANGE      => 2 << 2,
+    DB3_ITCONTENT          => 1 << 7,
+    AVI_HEADER             => 0x0d0282,
+};
+
 # ----
 
 sub bitshuffle {
@@ -105,6 +124,55 @@ sub convert_frame {
     }
 }
 
+sub build_avi_frame {
+    my @db = (0, @_);
+
+    # checksum covers header and all data bytes
+    my $sum = (AVI_HEADER & 0xff) + ((AVI_HEADER >> 8) & 0xff) + (AVI_HEADER >> 16);
+    $sum += $_ foreach @db;
+    $db[0] = (256 - ($sum & 0xff)) & 0xff;
+
+    my $sub = 0;
+    for (my $i = 0; $i < @db; $i++) {
+        $sub |= $db[$i] << (8 * $i);
+    }
+
+    return [AVI_HEADER, $sub, 0, 0, 0];
+}
+
+sub add_avi_sets {
+    my $frames = shift;
+
+    foreach my $set (@avi_sets) {
+        my ($name, $vic, $pixelrep) = @$set;
+
+        foreach my $aspect ([ "4:3",  DB2_FRAMEASPECT_4_3,  $vic     ],
+                            [ "16:9", DB2_FRAMEASPECT_16_9, $vic ? $vic + 1 : 0 ]) {
+            my ($aname, $abits, $avic) = @$aspect;
+            my @variants = (
+                [ "RGB full",    DB1_COLOR_RGB,      DB2_COLORIMETRY_NODATA, DB3_ITCONTENT | DB3_RGB_FULLRANGE    ],
+                [ "RGB limited", DB1_COLOR_RGB,      DB2_COLORIMETRY_NODATA, DB3_ITCONTENT | DB3_RGB_LIMITEDRANGE ],
+                [ "YCbCr 444",   DB1_COLOR_YCBCR444, DB2_COLORIMETRY_170M,   DB3_ITCONTENT                        ],
+                [ "YCbCr 422",   DB1_COLOR_YCBCR422, DB2_COLORIMETRY_170M,   DB3_ITCONTENT                        ],
+                );
+
+            foreach my $v (@variants) {
+                my ($vname, $db1, $db2, $db3) = @$v;
+                my $framename = "AVI $name $aname $vname";
+
+                # Samsung C7000 series TVs fail i -> p switches if the
+                # game content type is set, so DB5 only holds the pixel repetition
+                $$frames{$framename} = build_avi_frame(DB1_SCANINFO_OVERSCAN | $db1,
+                                                       $abits | $db2,
+                                                       $db3,
+                                                       $avic,
+                                                       $pixelrep);
+                push @modes, $framename;
+            }
+        }
+    }
+}
+
 # ----
 
 my %frames;
@@ -153,6 +221,8 @@ if (defined($curframe)) {
 
 close IN;
 
+add_avi_sets(\%frames);
+
 # write to output
 open my $out, ">", $ARGV[1] or die "Can't open output $ARGV[1]: $!";
 
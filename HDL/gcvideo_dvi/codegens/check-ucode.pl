@@ -0,0 +1,786 @@
+#!/usr/bin/env perl
+#
+# GCVideo DVI HDL
+# Copyright (C) 2014-2021, Ingo Korb <ingo@akana.de>
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# 1. Redistributions of source code must retain the above copyright notice,
+#    this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+#    this list of conditions and the following disclaimer in the documentation
+#    and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+# THE POSSIBILITY OF SUCH DAMAGE.
+#
+# check-ucode.pl: Simulate the enhanced DVI sequencer and check its output
+#
+# Steps the generated microcode ROM together with a model of the
+# sequencer control in dvid.vhd through whole frames of every output
+# mode. The resulting symbol stream is checked against the HDMI rules
+# for preambles, guard bands and data island periods and the number of
+# data island packets that each mode sends and could carry is reported.
+#
+# Only the type of each symbol is modelled, not the actual data. Audio
+# samples arrive at exactly 48kHz.
+#
+
+use warnings;
+use strict;
+use feature ':5.10';
+
+my $ucode_file = $ARGV[0] // "../src/edvi_ucode.vhd";
+my $defs_file  = $ARGV[1] // "../src/dvienc_defs.vhd";
+my $frames     = 3; # the first one is not counted
+
+if (scalar(@ARGV) > 2) {
+    say "Usage: $0 [edvi_ucode.vhd [dvienc_defs.vhd]]";
+    exit 1;
+}
+
+# HDMI limits
+use constant {
+    PREAMBLE_LENGTH   => 8,
+    GUARD_LENGTH      => 2,
+    PACKET_LENGTH     => 32,
+    MAX_PACKETS       => 18,
+    MIN_CONTROL       => 12,
+    EXTENDED_CONTROL  => 32,
+};
+
+# CTL3..0 values during preambles
+my $ctl_video_pre = "0001";
+my $ctl_data_pre  = "0101";
+
+
+### parse the generated microcode ROM
+
+my @rom;
+my %fields;
+my %bools;
+
+open IN, "<", $ucode_file or die "Can't open $ucode_file: $!";
+
+my $case;
+while (<IN>) {
+    if (/case data\((\d+) downto (\d+)\) is/) {
+        $case = { "hi" => $1, "lo" => $2, "values" => {} };
+    } elsif ($case && /when "([01]+)" => (\w+) <= (\w+);/) {
+        $case->{values}{$1} = $3;
+        $fields{$2} = $case;
+    } elsif (/end case;/) {
+        undef $case;
+    } elsif (/^\s*(\w+) <= data\((\d+) downto (\d+)\);/) {
+        $fields{$1} = { "hi" => $2, "lo" => $3 };
+    } elsif (/^\s*(\w+) <= \(data\((\d+)\) = '1'\);/) {
+        $bools{$1} = $2;
+    } elsif (/when (\d+) => data <= "([01]+)";/) {
+        $rom[$1] = $2;
+    }
+}
+
+close IN;
+
+foreach my $name (qw(Enc_Mode C2C0_Value BT4_Mode)) {
+    die "$ucode_file: field $name not found\n" unless exists $fields{$name};
+}
+
+foreach my $name (qw(HeaderSendECC DataSendECC nFirstPacketBit Done)) {
+    die "$ucode_file: signal $name not found\n" unless exists $bools{$name};
+}
+
+die "$ucode_file: no ROM contents found\n" if scalar(@rom) == 0;
+
+# decode every word once
+my @uops;
+
+for (my $i = 0; $i < @rom; $i++) {
+    my $word = $rom[$i] // "0" x length($rom[0]);
+    my $len  = length($word);
+    my %uop;
+
+    foreach my $field (keys %fields) {
+        my $f    = $fields{$field};
+        my $bits = substr($word, $len - 1 - $f->{hi}, $f->{hi} - $f->{lo} + 1);
+
+        if (exists $f->{values}) {
+            $uop{$field} = $f->{values}{$bits};
+        } else {
+            $uop{$field} = $bits;
+        }
+    }
+
+    foreach my $bool (keys %bools) {
+        $uop{$bool} = substr($word, $len - 1 - $bools{$bool}, 1) eq "1";
+    }
+
+    push @uops, \%uop;
+}
+
+# sequence start addresses
+my %ucode_addr;
+
+open IN, "<", $defs_file or die "Can't open $defs_file: $!";
+
+while (<IN>) {
+    if (/constant UCode_Addr_(\w+)\s*: natural := (\d+);/) {
+        $ucode_addr{$1} = 0+$2;
+    }
+}
+
+close IN;
+
+foreach my $name (qw(Blank2Vid OnePacket TwoPackets TMDS)) {
+    die "$defs_file: UCode_Addr_$name not found\n" unless exists $ucode_addr{$name};
+}
+
+
+### output modes
+
+# horizontal values are in video pipeline pixels (see ModeParameters in
+# Firmware/reblanker.c), the encoder runs num/den times faster than that
+my @modes = (
+    { name => "240p",     clock => 27e6, num => 2, den => 1,
+      htotal => 858, hsync => 62, hbp => 57, vtotal =>  263, vactive =>  240, vsync => 3, vbp => 16 },
+    { name => "288p",     clock => 27e6, num => 2, den => 1,
+      htotal => 864, hsync => 63, hbp => 69, vtotal =>  313, vactive =>  288, vsync => 3, vbp => 20 },
+    { name => "480i",     clock => 27e6, num => 2, den => 1, # short field
+      htotal => 858, hsync => 62, hbp => 57, vtotal =>  262, vactive =>  240, vsync => 3, vbp => 16 },
+    { name => "576i",     clock => 27e6, num => 2, den => 1, # short field
+      htotal => 864, hsync => 63, hbp => 69, vtotal =>  312, vactive =>  288, vsync => 3, vbp => 20 },
+    { name => "480p",     clock => 27e6, num => 1, den => 1,
+      htotal => 858, hsync => 62, hbp => 60, vtotal =>  525, vactive =>  480, vsync => 6, vbp => 31 },
+    { name => "576p",     clock => 27e6, num => 1, den => 1,
+      htotal => 864, hsync => 64, hbp => 68, vtotal =>  625, vactive =>  576, vsync => 5, vbp => 40 },
+    { name => "720p 3x",  clock => 54e6, num => 4, den => 3,
+      htotal => 858, hsync => 62, hbp => 60, vtotal =>  789, vactive =>  720, vsync => 5, vbp => 20 },
+    { name => "864p 3x",  clock => 54e6, num => 4, den => 3,
+      htotal => 864, hsync => 64, hbp => 68, vtotal =>  939, vactive =>  864, vsync => 5, vbp => 36 },
+    { name => "960p 4x",  clock => 54e6, num => 1, den => 1,
+      htotal => 858, hsync => 62, hbp => 60, vtotal => 1052, vactive =>  960, vsync => 6, vbp => 40 },
+    { name => "1152p 4x", clock => 54e6, num => 1, den => 1,
+      htotal => 864, hsync => 64, hbp => 68, vtotal => 1252, vactive => 1152, vsync => 6, vbp => 48 },
+);
+
+
+### symbol stream checker
+
+# Symbols are strings:
+#   C<ctl3..0>   control period
+#   V            active video
+#   GV           video guard band
+#   GD<b3><b2>   data island guard band, b3/b2 of the channel 0 TERC4 input
+#   T<b3><b2><d> TERC4, b2 is 1, H (header) or E (header ECC),
+#                d is D (subpacket data) or P (subpacket ECC)
+
+my %mode_stats;
+my @errors;
+my $max_errors = 10;
+
+my ($cur_mode, $cur_ticks_line, $cur_ticks_frame);
+my ($chk_state, $chk_count, $ctl_run, $pre_value, $pre_run, $chk_tick);
+my ($island_start, $island_packets);
+my @pending_islands;
+my $measuring;
+
+sub position {
+    my $tick  = shift;
+    my $frame = int($tick / $cur_ticks_frame);
+    my $rest  = $tick - $frame * $cur_ticks_frame;
+
+    return sprintf("frame %d line %d pixel %d", $frame, int($rest / $cur_ticks_line),
+                   $rest % $cur_ticks_line);
+}
+
+sub error {
+    my $msg = shift;
+
+    # the first frame starts from an arbitrary state
+    return unless $measuring;
+
+    $mode_stats{errors}++;
+    if ($mode_stats{errors} <= $max_errors) {
+        push @errors, "$cur_mode, " . position($chk_tick) . ": $msg";
+    }
+}
+
+sub frame_error {
+    my $msg = shift;
+
+    $mode_stats{errors}++;
+    push @errors, "$cur_mode: $msg";
+}
+
+sub checker_reset {
+    $chk_state    = "CTL";
+    $chk_count    = 0;
+    $ctl_run      = 0;
+    $pre_value    = "";
+    $pre_run      = 0;
+    $chk_tick     = 0;
+    $island_start = undef;
+    @pending_islands = ();
+}
+
+# called with the start of every preamble
+sub preamble_start {
+    my ($start, $video) = @_;
+
+    if (defined($island_start)) {
+        # packets that would fit between the start of the previous data
+        # island and this preamble, keeping the minimum control period
+        my $window = $start - $island_start;
+        my $fits   = int(($window - 2 * GUARD_LENGTH - MIN_CONTROL) / PACKET_LENGTH);
+        $fits = MAX_PACKETS if $fits > MAX_PACKETS;
+        $fits = 0 if $fits < 0;
+
+        if ($measuring) {
+            $mode_stats{capacity} += $fits;
+            $mode_stats{twopkt_lines}++ if $fits >= 2;
+
+            if ($video && (!defined($mode_stats{hblank}) || $fits < $mode_stats{hblank})) {
+                $mode_stats{hblank} = $fits;
+            }
+        }
+
+        undef $island_start;
+    }
+}
+
+sub is_preamble {
+    my $value = shift;
+    return $value eq $ctl_video_pre || $value eq $ctl_data_pre;
+}
+
+sub control_end {
+    if ($pre_run >= PREAMBLE_LENGTH && is_preamble($pre_value)) {
+        error("preamble $pre_value without a following guard band");
+    }
+
+    if ($ctl_run > ($mode_stats{max_control} // 0) && $measuring) {
+        $mode_stats{max_control} = $ctl_run;
+    }
+}
+
+sub check_symbol {
+    my ($sym, $count) = @_;
+    $count //= 1;
+
+    if ($sym eq "V" && $chk_state eq "VIDEO") {
+        # fast path for runs of active video
+        $chk_count += $count;
+        $chk_tick  += $count;
+        return;
+    }
+
+    for (my $i = 0; $i < $count; $i++, $chk_tick++) {
+        if ($chk_state eq "CTL") {
+            if ($sym =~ /^C(....)/) {
+                my $value = $1;
+
+                $ctl_run++;
+                if ($value eq $pre_value) {
+                    $pre_run++;
+                } else {
+                    if ($pre_run >= PREAMBLE_LENGTH && is_preamble($pre_value)) {
+                        error("preamble $pre_value without a following guard band");
+                    }
+                    $pre_value = $value;
+                    $pre_run   = 1;
+                }
+                next;
+            }
+
+            my $ctl_before = $ctl_run;
+            my $pre_before = $pre_run;
+            my $value      = $pre_value;
+
+            $pre_run = 0; # already checked here
+            control_end();
+
+            if ($sym eq "GV") {
+                error("video preamble is $value x $pre_before, expected $ctl_video_pre x " . PREAMBLE_LENGTH)
+                    if $value ne $ctl_video_pre || $pre_before != PREAMBLE_LENGTH;
+                error("control period of $ctl_before symbols before video is too short")
+                    if $ctl_before < MIN_CONTROL;
+
+                preamble_start($chk_tick - PREAMBLE_LENGTH, 1);
+                $chk_state = "GUARDV";
+                $chk_count = 1;
+
+            } elsif ($sym =~ /^GD/) {
+                error("data island preamble is $value x $pre_before, expected $ctl_data_pre x " . PREAMBLE_LENGTH)
+                    if $value ne $ctl_data_pre || $pre_before != PREAMBLE_LENGTH;
+                error("control period of $ctl_before symbols before data island is too short")
+                    if $ctl_before < MIN_CONTROL;
+                error("leading guard band channel 0 bits are $sym")
+                    if $sym ne "GD11";
+
+                preamble_start($chk_tick - PREAMBLE_LENGTH, 0);
+                $island_start   = $chk_tick - PREAMBLE_LENGTH;
+                $island_packets = 0;
+                $chk_state = "LEAD";
+                $chk_count = 1;
+
+            } else {
+                error("$sym after a control period");
+                $chk_state = $sym eq "V" ? "VIDEO" : "CTL";
+                $chk_count = 0;
+            }
+
+        } elsif ($chk_state eq "GUARDV") {
+            if ($sym eq "GV") {
+                $chk_count++;
+            } elsif ($sym eq "V") {
+                error("video guard band is $chk_count symbols long")
+                    if $chk_count != GUARD_LENGTH;
+                $chk_state = "VIDEO";
+                $chk_count = 1;
+            } else {
+                error("$sym after video guard band");
+                $chk_state = "CTL";
+                $ctl_run   = 0;
+            }
+
+        } elsif ($chk_state eq "VIDEO") {
+            if ($sym =~ /^C(....)/) {
+                error("active video is $chk_count pixels wide, expected $mode_stats{hactive}")
+                    if $chk_count != $mode_stats{hactive};
+                $chk_state = "CTL";
+                $ctl_run   = 0;
+                $pre_run   = 0;
+                $pre_value = "";
+                redo;
+            } else {
+                error("$sym during active video");
+            }
+
+        } elsif ($chk_state eq "LEAD") {
+            if ($sym =~ /^GD/) {
+                error("leading guard band channel 0 bits are $sym")
+                    if $sym ne "GD11";
+                $chk_count++;
+            } elsif ($sym =~ /^T/) {
+                error("leading guard band is $chk_count symbols long")
+                    if $chk_count != GUARD_LENGTH;
+                $chk_state = "TERC";
+                $chk_count = 0;
+                redo;
+            } else {
+                error("$sym after leading guard band");
+                $chk_state = "CTL";
+                $ctl_run   = 0;
+            }
+
+        } elsif ($chk_state eq "TERC") {
+            if ($sym =~ /^T(.)(.)(.)/) {
+                my ($b3, $b2, $d) = ($1, $2, $3);
+                my $pos = $chk_count % PACKET_LENGTH;
+
+                if ($b3 ne ($chk_count == 0 ? "0" : "1")) {
+                    error("channel 0 bit 3 is $b3 at data island symbol $chk_count");
+                }
+
+                if ($b2 ne ($pos < 24 ? "H" : "E")) {
+                    error("header ECC framing wrong at packet symbol $pos ($b2)");
+                }
+
+                if ($d ne ($pos < 28 ? "D" : "P")) {
+                    error("subpacket ECC framing wrong at packet symbol $pos ($d)");
+                }
+
+                $chk_count++;
+
+            } elsif ($sym =~ /^GD/) {
+                my $packets   = $chk_count / PACKET_LENGTH;
+                my $expected  = shift @pending_islands;
+
+                if ($chk_count % PACKET_LENGTH != 0) {
+                    error("TERC4 period of $chk_count symbols is not a multiple of " . PACKET_LENGTH);
+                } elsif ($packets > MAX_PACKETS) {
+                    error("data island with $packets packets");
+                } elsif (defined($expected) && $packets != $expected) {
+                    error("data island has $packets packets, sequence should send $expected");
+                }
+
+                $chk_state = "TRAIL";
+                $chk_count = 0;
+                redo;
+
+            } else {
+                error("$sym during TERC4 period");
+                $chk_state = "CTL";
+                $ctl_run   = 0;
+            }
+
+        } elsif ($chk_state eq "TRAIL") {
+            if ($sym =~ /^GD/) {
+                error("trailing guard band channel 0 bits are $sym")
+                    if $sym ne "GD11";
+                $chk_count++;
+            } elsif ($sym =~ /^C/) {
+                error("trailing guard band is $chk_count symbols long")
+                    if $chk_count != GUARD_LENGTH;
+                $chk_state = "CTL";
+                $ctl_run   = 0;
+                $pre_run   = 0;
+                $pre_value = "";
+                redo;
+            } else {
+                error("$sym after trailing guard band");
+                $chk_state = "CTL";
+                $ctl_run   = 0;
+            }
+        }
+    }
+}
+
+
+### sequencer model
+
+sub scale {
+    my ($mode, $value) = @_;
+    return int($value * $mode->{num} / $mode->{den} + 0.5);
+}
+
+sub simulate {
+    my $mode = shift;
+
+    my $ht     = scale($mode, $mode->{htotal});
+    my $ha     = scale($mode, 720);
+    my $hfp    = $mode->{htotal} - 720 - $mode->{hsync} - $mode->{hbp};
+    my $hs_beg = scale($mode, 720 + $hfp);
+    my $hs_end = scale($mode, 720 + $hfp + $mode->{hsync});
+    my $vt     = $mode->{vtotal};
+    my $va     = $mode->{vactive};
+    my $vs_beg = $vt - $mode->{vsync} - $mode->{vbp}; # first vsync line
+    my $vs_end = $vs_beg + $mode->{vsync};
+
+    my $sample_period = $mode->{clock} / 48000;
+
+    $cur_mode        = $mode->{name};
+    $cur_ticks_line  = $ht;
+    $cur_ticks_frame = $ht * $vt;
+    %mode_stats      = ( hactive => $ha, errors => 0, capacity => 0, twopkt_lines => 0,
+                         audio => 0, acr => 0, infoframes => 0, lost => 0, overflow => 0,
+                         acr_skipped => 0, hblank => undef );
+    $measuring = 0;
+    checker_reset();
+
+    # registers of dvid.vhd, "delay" arrays hold true for active signals
+    my @blank_delay = (1) x 11;
+    my @hsync_delay = (0) x 11;
+    my @vsync_delay = (0) x 11;
+    my $blank_d     = 1;
+
+    my $seq_address = $ucode_addr{TMDS};
+    my $data        = $seq_address;
+    my $seq_active  = 0;
+    my $seq_start   = 0;
+    my $video_state = "DATA";
+    my $aux_ready   = 0;
+    my $per_frame   = 0;
+    my $needs_acr   = 0;
+    my $island_type = "";
+
+    my $tmds     = "C0000";
+    my $aux      = "111DD";
+    my $ecc_hdr  = "E";
+    my $ecc_data = "P";
+    my $hdr_send_run  = 8;
+    my $data_send_run = 4;
+
+    my $sample_ready  = 0;
+    my $sample_count  = 0;
+    my $samples_sent  = 0;
+    my $next_sample   = $sample_period;
+
+    my $tick = 0;
+
+    for (my $frame = 0; $frame < $frames; $frame++) {
+        $measuring = $frame > 0;
+
+        for (my $line = 0; $line < $vt; $line++) {
+            my $x = 0;
+
+            while ($x < $ht) {
+                # skip ahead through the stable part of active video
+                if ($video_state eq "DATA" && !$seq_active && !$seq_start &&
+                    $line < $va && $x >= 16 && $x + 16 < $ha &&
+                    $tmds eq "V" && $uops[$data]{Enc_Mode} eq "ENC_TMDS" &&
+                    $data == $seq_address) {
+                    my $skip = $ha - 16 - $x;
+
+                    check_symbol("V", $skip);
+
+                    while ($next_sample < $tick + $skip) {
+                        # captured immediately as the sequencer is idle
+                        $sample_count++;
+                        $mode_stats{overflow}++ if $sample_count > 4 && $measuring;
+                        if (++$samples_sent == 48) {
+                            $samples_sent = 0;
+                            $needs_acr    = 1;
+                        }
+                        $next_sample += $sample_period;
+                    }
+
+                    $tick += $skip;
+                    $x    += $skip;
+                    next;
+                }
+
+                my $blank_in = $line >= $va || $x >= $ha;
+                my $hs_in    = $x >= $hs_beg && $x < $hs_end;
+                my $vs_in    = ($line > $vs_beg || ($line == $vs_beg && $x >= $hs_beg)) &&
+                               ($line < $vs_end || ($line == $vs_end && $x <  $hs_beg));
+
+                my $u    = $uops[$data];
+                my $done = $u->{Done};
+
+                # output selection, registered
+                my $enc = $u->{Enc_Mode};
+                my $sym;
+
+                if ($enc eq "ENC_TMDS") {
+                    $sym = $tmds;
+                } elsif ($enc eq "ENC_TERC") {
+                    $sym = "T" . substr($aux, 0, 3);
+                } elsif ($enc eq "ENC_GuardV") {
+                    $sym = "GV";
+                } else {
+                    $sym = "GD" . substr($aux, 0, 2);
+                }
+
+                check_symbol($sym);
+
+                # encoders and ECC generators, all registered
+                my $c2c0 = $u->{C2C0_Value};
+                my $next_tmds = $blank_d ? "C0" . substr($c2c0, 0, 1) . "0" . substr($c2c0, 1, 1) : "V";
+                my $next_aux  = ($u->{nFirstPacketBit} ? "1" : "0") .
+                                ($u->{BT4_Mode} eq "BT4_Send_1" ? "1" : $ecc_hdr) .
+                                $ecc_data;
+
+                # the ECC registers must be empty before a new packet starts
+                if ($u->{HeaderSendECC}) {
+                    $hdr_send_run++;
+                } else {
+                    error("header ECC started after only $hdr_send_run output cycles")
+                        if $hdr_send_run > 0 && $hdr_send_run < 8;
+                    $hdr_send_run = 0;
+                }
+
+                if ($u->{DataSendECC}) {
+                    $data_send_run++;
+                } else {
+                    error("subpacket ECC started after only $data_send_run output cycles")
+                        if $data_send_run > 0 && $data_send_run < 4;
+                    $data_send_run = 0;
+                }
+
+                $tmds     = $next_tmds;
+                $aux      = $next_aux;
+                $ecc_hdr  = $u->{HeaderSendECC} ? "E" : "H";
+                $ecc_data = $u->{DataSendECC}   ? "P" : "D";
+
+                # microcode ROM
+                my $next_data = $seq_address;
+
+                # audio samples
+                if ($tick >= $next_sample) {
+                    if ($sample_ready) {
+                        $mode_stats{lost}++ if $measuring;
+                    }
+                    $sample_ready = 1;
+                    $next_sample += $sample_period;
+                }
+
+                my $next_needs_acr = $needs_acr;
+
+                if (!$seq_active && $sample_ready) {
+                    $sample_ready = 0;
+                    $sample_count++;
+                    $mode_stats{overflow}++ if $sample_count > 4 && $measuring;
+                    if (++$samples_sent == 48) {
+                        $samples_sent   = 0;
+                        $next_needs_acr = 1;
+                    }
+                }
+
+                # sequencer control
+                my $next_seq_address = $seq_address;
+                my $next_seq_active  = $seq_active;
+                my $next_seq_start   = $seq_start;
+
+                if ($seq_active || $seq_start) {
+                    if ($done && !$seq_start) {
+                        $next_seq_active = 0;
+                    } else {
+                        $next_seq_active  = 1;
+                        $next_seq_start   = 0;
+                        $next_seq_address = $seq_address + 1;
+                    }
+                }
+
+                # video state machine
+                my $next_video_state = $video_state;
+                my $next_aux_ready   = $aux_ready;
+                my $next_per_frame   = $per_frame;
+
+                if ($video_state eq "BLANKING") {
+                    if (!$blank_in) {
+                        $next_video_state = "PRE";
+                        $next_seq_start   = 1;
+                        $next_seq_address = $ucode_addr{Blank2Vid};
+
+                    } elsif ($aux_ready) {
+                        $next_aux_ready   = 0;
+                        $next_video_state = "AUX";
+                        $next_seq_start   = 1;
+
+                        if ($needs_acr) {
+                            $next_seq_address = $ucode_addr{TwoPackets};
+                            $island_type      = "acr";
+                            push @pending_islands, 2;
+
+                        } elsif ($per_frame != 0) {
+                            $next_seq_address = $ucode_addr{TwoPackets};
+                            $next_per_frame   = $per_frame - 1;
+                            $island_type      = "infoframes";
+                            push @pending_islands, 2;
+
+                        } else {
+                            $next_seq_address = $ucode_addr{OnePacket};
+                            $island_type      = "";
+                            push @pending_islands, 1;
+                        }
+
+                        if ($measuring) {
+                            $mode_stats{audio}++;
+                            $mode_stats{$island_type}++ if $island_type ne "";
+                        }
+                    }
+
+                } elsif ($video_state eq "PRE") {
+                    $next_video_state = "DATA" if $done;
+
+                } elsif ($video_state eq "DATA") {
+                    $next_video_state = "BLANKING" if $blank_delay[0];
+
+                } elsif ($video_state eq "AUX") {
+                    if ($done) {
+                        $next_video_state = "BLANKING";
+                        if ($next_needs_acr && $island_type ne "acr" && $measuring) {
+                            # request arrived as the island started
+                            $mode_stats{acr_skipped}++;
+                        }
+
+                        $sample_count   = 0;
+                        $next_needs_acr = 0;
+                    }
+                }
+
+                # packet transmission starts at HSync, once-per-frame packets at VSync
+                $next_aux_ready = 1 if !$hsync_delay[0] && $hsync_delay[1];
+                $next_per_frame = 3 if !$vsync_delay[0] && $vsync_delay[1];
+
+                # input delays
+                $blank_d = $blank_delay[0];
+                shift @blank_delay; push @blank_delay, $blank_in;
+                shift @hsync_delay; push @hsync_delay, $hs_in;
+                shift @vsync_delay; push @vsync_delay, $vs_in;
+
+                $data        = $next_data;
+                $seq_address = $next_seq_address;
+                $seq_active  = $next_seq_active;
+                $seq_start   = $next_seq_start;
+                $video_state = $next_video_state;
+                $aux_ready   = $next_aux_ready;
+                $per_frame   = $next_per_frame;
+                $needs_acr   = $next_needs_acr;
+
+                $tick++;
+                $x++;
+            }
+        }
+    }
+
+    # summary for the measured frames
+    my $measured = $frames - 1;
+    my %result;
+
+    $result{name}     = $mode->{name};
+    $result{clock}    = $mode->{clock};
+    $result{total}    = "${ht}x$vt";
+    $result{audio}    = $mode_stats{audio} / $measured;
+    $result{acr}      = $mode_stats{acr} / $measured;
+    $result{info}     = $mode_stats{infoframes} / $measured;
+    $result{packets}  = $result{audio} + $result{acr} + $result{info};
+    $result{capacity} = $mode_stats{capacity} / $measured;
+    $result{twopkt}   = $mode_stats{twopkt_lines} / $measured;
+    $result{hblank}   = $mode_stats{hblank} // 0;
+
+    frame_error("no extended control period in a frame")
+        if ($mode_stats{max_control} // 0) < EXTENDED_CONTROL;
+    frame_error(($mode_stats{lost} / $measured) . " audio samples per frame lost")
+        if $mode_stats{lost};
+    frame_error(($mode_stats{overflow} / $measured) . " audio samples per frame do not fit into their packet")
+        if $mode_stats{overflow};
+
+    $result{acr_skipped} = $mode_stats{acr_skipped} / $measured;
+    $result{errors}      = $mode_stats{errors};
+
+    return \%result;
+}
+
+
+### main
+
+my @results;
+
+foreach my $mode (@modes) {
+    push @results, simulate($mode);
+}
+
+say "Data island packets per frame (average over ", $frames - 1, " frames):";
+say "";
+say "mode      clock  total      sent  audio  ACR   info  hblank  2-pkt lines  capacity  errors";
+
+foreach my $r (@results) {
+    printf "%-9s %4.0fM  %-9s %6.1f %6.1f %5.1f %5.1f %7d %12.1f %9.1f %7d\n",
+        $r->{name}, $r->{clock} / 1e6, $r->{total}, $r->{packets}, $r->{audio},
+        $r->{acr}, $r->{info}, $r->{hblank}, $r->{twopkt}, $r->{capacity}, $r->{errors};
+}
+
+say "";
+say "sent:        packets sent by the current sequencer (audio + ACR + infoframes)";
+say "hblank:      packets that fit into a single island in horizontal blanking";
+say "2-pkt lines: lines whose island could carry two packets, each of them";
+say "             can hold one more infoframe (minus the ACR and info columns)";
+say "capacity:    packets per frame with one island per line and no other limit";
+
+my $skipped = 0;
+foreach my $r (@results) {
+    if ($r->{acr_skipped}) {
+        say "";
+        printf "Note: %s skipped %.1f ACR requests per frame (request arrived as an island started)\n",
+            $r->{name}, $r->{acr_skipped};
+    }
+}
+
+if (@errors) {
+    say STDERR "";
+    say STDERR $_ foreach @errors;
+    exit 1;
+}
@@ -0,0 +1,111 @@
+#!/usr/bin/env perl
+#
+# GCVideo DVI HDL
+# Copyright (C) 2014-2021, Ingo Korb <ingo@akana.de>
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# 1. Redistributions of source code must retain the above copyright notice,
+#    this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+#    this list of conditions and the following disclaimer in the documentation
+#    and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+# THE POSSIBILITY OF SUCH DAMAGE.
+#
+#
+# check-vtotal.pl: Check the VTotal limits of the line multiplier modes
+#
+# Models the output field lengths that Linedoubler.vhd produces for the
+# 15kHz input modes and compares them with the MaxVTotal constants in
+# ZPUVideoInterface.vhd, which would classify a longer field as a
+# non-standard mode.
+#
+# An input VSync that starts in the middle of a line is moved to the
+# start of output line Factor/2 (rounded down) of that input line, so
+# interlaced fields alternate between two lengths with an odd factor.
+#
+
+use warnings;
+use strict;
+use feature ':5.10';
+
+my $vif_file = $ARGV[0] // "../src/ZPUVideoInterface.vhd";
+
+if (scalar(@ARGV) > 1) {
+    say "Usage: $0 [ZPUVideoInterface.vhd]";
+    exit 1;
+}
+
+# name => [ pixels per line, whole lines per field, half line in the field ]
+my @modes = (
+    [ "240p", 858, 263, 0 ],
+    [ "288p", 864, 312, 0 ],
+    [ "480i", 858, 262, 1 ],
+    [ "576i", 864, 312, 1 ],
+);
+
+
+### parse the limits
+
+my %limit;
+
+open IN, "<", $vif_file or die "Can't open $vif_file: $!";
+while (<IN>) {
+    if (/constant\s+MaxVTotal(\d)x\s*:\s*natural\s*:=\s*(\d+)\s*\*\s*(\d+)\s*;/) {
+        $limit{$1} = $2 * $3;
+    }
+}
+close IN;
+
+foreach my $factor (2..4) {
+    die "MaxVTotal${factor}x not found in $vif_file\n" unless exists $limit{$factor};
+}
+
+
+### check all modes
+
+my $errors = 0;
+
+say "mode factor  lines  max. pixels  limit";
+
+foreach my $factor (2..4) {
+    foreach my $mode (@modes) {
+        my ($name, $htotal, $lines, $half) = @$mode;
+        my @fields;
+
+        if ($half) {
+            # VSync at a line start to one in the middle and back
+            my $mid = int($factor / 2);
+            @fields = ($lines * $factor + $mid, $lines * $factor + $factor - $mid);
+        } else {
+            @fields = ($lines * $factor);
+        }
+
+        my $max_lines = (sort { $b <=> $a } @fields)[0];
+        my $pixels    = $max_lines * $htotal;
+
+        printf "%-4s   %dx   %-9s %8d  %8d%s\n", $name, $factor,
+            join("/", @fields), $pixels, $limit{$factor},
+            $pixels > $limit{$factor} ? "  ERROR" : "";
+
+        $errors++ if $pixels > $limit{$factor};
+    }
+}
+
+if ($errors) {
+    say "$errors modes exceed their VTotal limit";
+    exit 1;
+}
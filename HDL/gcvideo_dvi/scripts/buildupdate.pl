@@ -29,21 +29,55 @@
 #
 
 use File::Temp qw/tempdir/;
+use Getopt::Long;
 use POSIX qw/ceil/;
 use warnings;
 use strict;
 use feature ':5.10';
 
 use constant BLOCKSIZE    => 1024;
+use constant LARGE_BLOCKS => 4; # 4 KByte chunks, only used if they fit into a line
+use constant DICT_SIZE    => 1024;
+use constant DICT_SEGMENT => 32;
+use constant DICT_KMER    => 8;
 use constant LINE_BYTES   => 1250;
 use constant SCREEN_LINES => 400;
 use constant INFO_PAGE    => 0x10;
+use constant DICT_LINE    => 1;
 use constant TARGET_ADDR  => 0x80800000;
 use constant RNG_MULT     => 1103515245;
 use constant RNG_ADD      => 12345;
 use constant RNG_MOD      => 2**31;
 use constant RNG_SHIFT    => 8;
 
+# LZ chunks are only understood by newer flashers, see below
+use constant INFO_FORMAT_LZ     => 0x4c5a;
+use constant INFO_FORMAT_LZDICT => 0x4c44;
+use constant CHUNK_FLAG_LZ      => 0x8000;
+use constant CHUNK_FLAG_LARGE   => 0x4000;
+use constant LZ_CHAIN_LIMIT => 64;
+
+# rough estimates for the codec choice: time the flasher needs to
+# capture and validate a line, flasher CPU clock and decode cycles per
+# output byte for each chunk type
+use constant LINE_TIME    => 0.01;
+use constant CPU_CLOCK    => 54_000_000;
+use constant RAW_CYCLES   => 4;
+use constant EXO_CYCLES   => 300;
+use constant LZ_CYCLES    => 30;
+
+# transport model for the optimizer: NTSC 480i timing as used by the
+# updater (each screen is shown for one frame) and typical M25P40 timing
+use constant FIELD_TIME        => 1001 / 60000;
+use constant SCREEN_TIME       => 2 * FIELD_TIME;
+use constant ROW_TIME          => FIELD_TIME / 262.5;
+use constant DATA_ROWS         => SCREEN_LINES - 2;
+use constant PAGE_PROGRAM_TIME => 0.0015;
+use constant SECTOR_ERASE_TIME => 0.6;
+use constant ERASE_BLOCKSIZE   => 0x10000;
+use constant SIM_STARTS        => 8;
+use constant MAX_DATA_BYTES    => 8 * 1024 * 1024; # larger updaters may not fit into memory
+
 # CRC table and update function translated from pycrc output, model crc-32-mpeg, https://pycrc.org
 my @CRC_TABLE = (
     0x00000000, 0x04c11db7, 0x09823b6e, 0x0d4326d9, 0x130476dc, 0x17c56b6b, 0x1a864db2, 0x1e475005,
@@ -113,16 +147,220 @@ sub have_exomizer {
     return $gotit;
 }
 
+# compress a block into the LZ4 block format, following its end-of-block
+# rules (last match starts 12 bytes before the end, last 5 bytes are literals)
+# matches may reach back into the optional preset dictionary
+sub lz4_length {
+    my $len = shift;
+    my $result = "";
+
+    while ($len >= 255) {
+        $result .= "\xff";
+        $len -= 255;
+    }
+
+    return $result . chr($len);
+}
+
+sub lz4_sequence {
+    my $literals = shift;
+    my $offset = shift;
+    my $matchlen = shift;
+    my $litlen = length($literals);
+    my $token = ($litlen < 15 ? $litlen : 15) << 4;
+    my $result = "";
+
+    if (defined($offset)) {
+        $token |= $matchlen - 4 < 15 ? $matchlen - 4 : 15;
+    }
+
+    $result .= lz4_length($litlen - 15) if $litlen >= 15;
+    $result .= $literals;
+
+    if (defined($offset)) {
+        $result .= pack("v", $offset);
+        $result .= lz4_length($matchlen - 4 - 15) if $matchlen - 4 >= 15;
+    }
+
+    return chr($token) . $result;
+}
+
+sub lz4_compress {
+    my $dict = shift // "";
+    my $indata = $dict . shift;
+    my $len = length($indata);
+    my $mflimit = $len - 12;
+    my $matchlimit = $len - 5;
+    my %chains;
+    my $output = "";
+    my $anchor = length($dict);
+    my $pos = length($dict);
+
+    for (my $i = 0; $i + 4 <= length($dict); $i++) {
+        push @{$chains{substr($indata, $i, 4)}}, $i;
+    }
+
+    while ($pos <= $mflimit) {
+        my $key = substr($indata, $pos, 4);
+        my $bestlen = 0;
+        my $bestpos;
+
+        if (exists $chains{$key}) {
+            my $chain = $chains{$key};
+
+            for (my $i = $#$chain; $i >= 0 && $#$chain - $i < LZ_CHAIN_LIMIT; $i--) {
+                my $candidate = $chain->[$i];
+                my $matchlen = 4;
+
+                $matchlen++ while $pos + $matchlen < $matchlimit &&
+                  substr($indata, $candidate + $matchlen, 1) eq substr($indata, $pos + $matchlen, 1);
+
+                if ($matchlen > $bestlen) {
+                    $bestlen = $matchlen;
+                    $bestpos = $candidate;
+                }
+            }
+        }
+
+        if ($bestlen == 0) {
+            push @{$chains{$key}}, $pos;
+            $pos++;
+            next;
+        }
+
+        $output .= lz4_sequence(substr($indata, $anchor, $pos - $anchor),
+                                $pos - $bestpos, $bestlen);
+
+        for (my $i = $pos; $i < $pos + $bestlen && $i <= $mflimit; $i++) {
+            push @{$chains{substr($indata, $i, 4)}}, $i;
+        }
+
+        $pos += $bestlen;
+        $anchor = $pos;
+    }
+
+    return $output . lz4_sequence(substr($indata, $anchor));
+}
+
+sub exomize_chunk {
+    my $data = shift;
+
+    state $tempdir = File::Temp->newdir();
+
+    open my $uncomp, ">", $tempdir . "/input.bin" or die "Can't open temporary file: $!";
+    binmode $uncomp;
+    print $uncomp $data;
+    close $uncomp;
+
+    system("exomizer", "raw", "-q", "-b", "-o", $tempdir . "/output.bin", $tempdir . "/input.bin") == 0
+      or do {
+          unlink $tempdir . "/input.bin";
+          die "Failed to run exomizer";
+      };
+
+    open my $compr, "<", $tempdir . "/output.bin" or die "Can't open compressed file: $!";
+    binmode $compr;
+    my $cdata;
+    my $len = sysread $compr, $cdata, 2 * length($data);
+    if ($len <= 0) {
+        unlink $tempdir . "/input.bin";
+        unlink $tempdir . "/output.bin";
+        die "Failed to read compressed data: $!";
+    }
+    close $compr;
+
+    # Workaround for a stupid flasher bug in 3.0-3.0c
+    #if ($len >= BLOCKSIZE) {
+    #    # compression did not gain anything, replace with original
+    #    $cdata = substr($indata, $i * BLOCKSIZE, BLOCKSIZE);
+    #}
+    if ($len == BLOCKSIZE) {
+        # append a dummy byte in front (ignored by decruncher) to
+        # make sure the flasher does not think this chunk is uncompressed
+        printf "%02x %02x %02x\n\n", ord(substr($cdata, 0, 1)), ord(substr($cdata, 1,1)), ord(substr($cdata, 2, 1));
+        $cdata = pack("Ca*", 0, $cdata);
+
+        say "\nnew cdata len: ", length($cdata);
+        printf "%02x %02x %02x\n\n", ord(substr($cdata, 0, 1)), ord(substr($cdata, 1,1)), ord(substr($cdata, 2, 1));
+    }
+
+    unlink $tempdir . "/input.bin";
+    unlink $tempdir . "/output.bin";
+
+    return $cdata;
+}
+
+# estimated time a chunk adds to the update: its share of the transmitted
+# lines plus the time the flasher needs to decode it
+sub chunk_cost {
+    my $candidate = shift;
+    my (undef, undef, $cdata, $cycles, $size) = @$candidate;
+
+    return length($cdata) * LINE_TIME / LINE_BYTES + $size * $cycles / CPU_CLOCK;
+}
+
+# the "time" policy minimizes the estimated update time, "size" the transmitted bytes
+sub chunk_score {
+    my $candidate = shift;
+    my $opts = shift;
+
+    return ($opts->{policy} // "time") eq "size" ? length($candidate->[2]) : chunk_cost($candidate);
+}
+
+# returns the best encoding of a chunk as [codec, length field, data, cycles, size]
+sub encode_chunk {
+    my $chunk = shift;
+    my $opts = shift;
+
+    # the optimizer asks for the same chunks repeatedly
+    state %cache;
+    $cache{$chunk} //= [ chunk_candidates($chunk, $opts) ];
+
+    return (sort { chunk_score($a, $opts) <=> chunk_score($b, $opts) } @{$cache{$chunk}})[0];
+}
+
+sub chunk_candidates {
+    my $chunk = shift;
+    my $opts = shift;
+    my $size = length($chunk);
+    my $largeflag = $size > BLOCKSIZE ? CHUNK_FLAG_LARGE : 0;
+    my @candidates;
+
+    if (have_exomizer()) {
+        my $cdata = exomize_chunk($chunk);
+        push @candidates, [ "exo", length($cdata) | $largeflag, $cdata, EXO_CYCLES, $size ];
+    }
+
+    if ($opts->{lz}) {
+        my $cdata = lz4_compress($opts->{dict}, $chunk);
+        push @candidates, [ "lz", length($cdata) | CHUNK_FLAG_LZ | $largeflag, $cdata, LZ_CYCLES, $size ]
+          if length($cdata) < BLOCKSIZE;
+    }
+
+    if ($opts->{newformat} && !$largeflag) {
+        # flashers that understand the new format handle raw chunks correctly
+        push @candidates, [ "raw", BLOCKSIZE, $chunk, RAW_CYCLES, $size ];
+    }
+
+    if ($largeflag) {
+        # a large chunk must fit into a single line, including its header
+        @candidates = grep { length($_->[2]) + 4 <= LINE_BYTES } @candidates;
+    }
+
+    return @candidates;
+}
+
 sub compress_firmware {
     my $label = shift;
     my $indata = shift;
+    my $opts = shift;
 
     # pad to full kbyte
     $indata .= "\xff" x (BLOCKSIZE - 1);
     $indata = substr($indata, 0, int(length($indata) / BLOCKSIZE) * BLOCKSIZE);
 
     # return uncompressed if exo is not available
-    if (!have_exomizer()) {
+    if (!have_exomizer() && !$opts->{lz}) {
         my @result;
 
         for (my $i = 0; $i < length($indata) / BLOCKSIZE; $i++) {
@@ -132,83 +370,152 @@ sub compress_firmware {
         return @result;
     }
 
-    state $tempdir = File::Temp->newdir();
     my @result;
     my $totalsize = 0;
+    my %codeccount = (raw => 0, exo => 0, lz => 0);
+    my $largecount = 0;
+    my $blocks = length($indata) / BLOCKSIZE;
 
-    for (my $i = 0; $i < length($indata) / BLOCKSIZE; $i++) {
-        print "$label: compressing chunk ", $i +  1, "/", length($indata) / BLOCKSIZE, "\r";
-        open my $uncomp, ">", $tempdir . "/input.bin" or die "Can't open temporary file: $!";
-        binmode $uncomp;
-        print $uncomp substr($indata, $i * BLOCKSIZE, BLOCKSIZE);
-        close $uncomp;
-
-        system("exomizer", "raw", "-q", "-b", "-o", $tempdir . "/output.bin", $tempdir . "/input.bin") == 0
-          or do {
-              unlink $tempdir . "/input.bin";
-              die "Failed to run exomizer";
-          };
-
-        open my $compr, "<", $tempdir . "/output.bin" or die "Can't open compressed file: $!";
-        binmode $compr;
-        my $cdata;
-        my $len = sysread $compr, $cdata, 2 * BLOCKSIZE;
-        if ($len <= 0) {
-            unlink $tempdir . "/input.bin";
-            unlink $tempdir . "/output.bin";
-            die "Failed to read compressed data: $!";
-        }
-        close $compr;
-
-        # Workaround for a stupid flasher bug in 3.0-3.0c
-        #if ($len >= BLOCKSIZE) {
-        #    # compression did not gain anything, replace with original
-        #    $cdata = substr($indata, $i * BLOCKSIZE, BLOCKSIZE);
-        #}
-        if ($len == BLOCKSIZE) {
-            # append a dummy byte in front (ignored by decruncher) to
-            # make sure the flasher does not think this chunk is uncompressed
-            printf "%02x %02x %02x\n\n", ord(substr($cdata, 0, 1)), ord(substr($cdata, 1,1)), ord(substr($cdata, 2, 1));
-            $cdata = pack("Ca*", 0, $cdata);
-
-            say "\nnew cdata len: ", length($cdata);
-            printf "%02x %02x %02x\n\n", ord(substr($cdata, 0, 1)), ord(substr($cdata, 1,1)), ord(substr($cdata, 2, 1));
+    for (my $i = 0; $i < $blocks; $i++) {
+        print "$label: compressing chunk ", $i +  1, "/", $blocks, "\r";
+
+        # pick the candidate that is expected to finish first
+        my @chosen = ($i, encode_chunk(substr($indata, $i * BLOCKSIZE, BLOCKSIZE), $opts));
+
+        if ($opts->{large} && $i % LARGE_BLOCKS == 0 && $i + LARGE_BLOCKS <= $blocks) {
+            my $large = encode_chunk(substr($indata, $i * BLOCKSIZE, LARGE_BLOCKS * BLOCKSIZE), $opts);
+
+            if (defined($large)) {
+                my @small = ($chosen[1]);
+                my $smallscore = chunk_score($chosen[1], $opts);
+
+                for (my $j = 1; $j < LARGE_BLOCKS; $j++) {
+                    push @small, encode_chunk(substr($indata, ($i + $j) * BLOCKSIZE, BLOCKSIZE), $opts);
+                    $smallscore += chunk_score($small[-1], $opts);
+                }
+
+                if (chunk_score($large, $opts) < $smallscore) {
+                    @chosen = ($i, $large);
+                    $largecount++;
+                } else {
+                    @chosen = map { ($i + $_, $small[$_]) } 0 .. LARGE_BLOCKS - 1;
+                }
+
+                $i += LARGE_BLOCKS - 1;
+            }
         }
 
-        unlink $tempdir . "/input.bin";
-        unlink $tempdir . "/output.bin";
+        while (scalar(@chosen) > 0) {
+            my $chunknum = shift @chosen;
+            my ($codec, $lenfield, $cdata) = @{shift @chosen};
 
-        my $outchunk = pack("Cna*", $i, length($cdata), $cdata);
-        push @result, $outchunk;
-        $totalsize += length($outchunk);
+            my $outchunk = pack("Cna*", $chunknum, $lenfield, $cdata);
+            push @result, $outchunk;
+            $totalsize += length($outchunk);
+            $codeccount{$codec}++;
+        }
     }
     printf "\n%s: %d chunks, %d/%d bytes (%.2f%%)\n", $label, scalar(@result), $totalsize, length($indata),
       $totalsize * 100.0 / length($indata);
 
+    if ($opts->{newformat}) {
+        printf "%s: %d exomizer, %d LZ, %d uncompressed chunks, %d of them 4 KByte\n", $label,
+          $codeccount{exo}, $codeccount{lz}, $codeccount{raw}, $largecount;
+    }
+
     return @result;
 }
 
+# build a preset dictionary from the byte sequences that occur in the
+# most chunks, a simplified version of the "cover" algorithm used by zstd
+sub build_dictionary {
+    my @images = @_;
+    my %chunkfreq;
+
+    foreach my $image (@images) {
+        for (my $offset = 0; $offset < length($image); $offset += BLOCKSIZE) {
+            my $chunk = substr($image, $offset, BLOCKSIZE);
+            my %seen;
+
+            for (my $i = 0; $i + DICT_KMER <= length($chunk); $i++) {
+                $seen{substr($chunk, $i, DICT_KMER)} = 1;
+            }
+
+            $chunkfreq{$_}++ foreach keys %seen;
+        }
+    }
+
+    # score half-overlapping segments by the number of other chunks that share their contents
+    my @segments;
+
+    foreach my $image (@images) {
+        for (my $pos = 0; $pos + DICT_SEGMENT <= length($image); $pos += DICT_SEGMENT / 2) {
+            my $segment = substr($image, $pos, DICT_SEGMENT);
+            my $score = 0;
+
+            for (my $i = 0; $i + DICT_KMER <= DICT_SEGMENT; $i++) {
+                $score += ($chunkfreq{substr($segment, $i, DICT_KMER)} // 1) - 1;
+            }
+
+            push @segments, [ $score, $segment ] if $score > 0;
+        }
+    }
+
+    # greedily take the best segments, skipping contents that are already covered
+    my %covered;
+    my $dict = "";
+
+    foreach my $candidate (sort { $b->[0] <=> $a->[0] } @segments) {
+        last if length($dict) + DICT_SEGMENT > DICT_SIZE;
+
+        my $segment = $candidate->[1];
+        my $score = 0;
+
+        for (my $i = 0; $i + DICT_KMER <= DICT_SEGMENT; $i++) {
+            my $kmer = substr($segment, $i, DICT_KMER);
+            $score += ($chunkfreq{$kmer} // 1) - 1 unless $covered{$kmer};
+        }
+
+        next if $score * 2 < $candidate->[0];
+
+        for (my $i = 0; $i + DICT_KMER <= DICT_SEGMENT; $i++) {
+            $covered{substr($segment, $i, DICT_KMER)} = 1;
+        }
+
+        # most valuable contents end up closest to the chunk data
+        $dict = $segment . $dict;
+    }
+
+    return $dict;
+}
+
 sub binpack {
     # simple first fit descending implementation, usually good enough
+    # optionally best fit descending, which the optimizer also tries
     # first byte of output bin is the number of data segments in it
     my $maxbytes = shift;
+    my $bestfit = shift;
     my @data = sort { length($a) <=> length($b) } @_;
     my @bins;
 
     while (scalar(@data) > 0) {
         my $curdata = pop @data;
-        my $found = 0;
+        my $target;
 
         foreach my $bin (@bins) {
             if (length($bin) + length($curdata) <= $maxbytes) {
-                $bin .= $curdata;
-                $found = 1;
-                substr($bin, 0, 1) = chr(ord(substr($bin, 0, 1)) + 1);
-                last;
+                if (!defined($target) || length($bin) > length($$target)) {
+                    $target = \$bin;
+                }
+
+                last if !$bestfit;
             }
         }
 
-        if (!$found) {
+        if (defined($target)) {
+            $$target .= $curdata;
+            substr($$target, 0, 1) = chr(ord(substr($$target, 0, 1)) + 1);
+        } else {
             push @bins, "\x01" . $curdata;
         }
     }
@@ -361,15 +668,329 @@ sub parse_updater {
     return ($data, $targetsection);
 }
 
+# --- transport optimizer
+
+# decode the chunk headers of a packed line for the timing model
+sub line_chunks {
+    my $linedata = shift;
+    my $count = ord(substr($linedata, 0, 1));
+    my $pos = 1;
+    my @chunks;
+
+    for (my $i = 0; $i < $count; $i++) {
+        my ($chunknum, $lenfield) = unpack("Cn", substr($linedata, $pos, 3));
+        my $size = $lenfield & CHUNK_FLAG_LARGE ? LARGE_BLOCKS * BLOCKSIZE : BLOCKSIZE;
+        my $cycles = EXO_CYCLES;
+
+        if ($lenfield & CHUNK_FLAG_LZ) {
+            $cycles = LZ_CYCLES;
+        } elsif ($lenfield == BLOCKSIZE) {
+            $cycles = RAW_CYCLES;
+        }
+
+        push @chunks, [ $chunknum * BLOCKSIZE, $size, $cycles ];
+        $pos += 3 + ($lenfield & ~(CHUNK_FLAG_LZ | CHUNK_FLAG_LARGE));
+    }
+
+    return \@chunks;
+}
+
+# time the flasher is busy with a line, erasing blocks it touches first
+sub line_busy_time {
+    my $chunks = shift;
+    my $erased = shift;
+    my $time = LINE_TIME;
+
+    foreach my $chunk (@$chunks) {
+        my ($address, $size, $cycles) = @$chunk;
+
+        if (!$erased->{int($address / ERASE_BLOCKSIZE)}++) {
+            $time += SECTOR_ERASE_TIME;
+        }
+
+        $time += $size * $cycles / CPU_CLOCK + $size / 256 * PAGE_PROGRAM_TIME;
+    }
+
+    return $time;
+}
+
+# display time of a data row relative to the start of its screen,
+# even rows are shown in the first field and odd rows in the second
+sub row_time {
+    my $row = shift(@_) + 2; # skip the info lines
+
+    return ($row & 1) * FIELD_TIME + ($row >> 1) * ROW_TIME;
+}
+
+# data rows of a screen in the order they are displayed
+sub rows_by_time {
+    my $rows = shift;
+
+    return sort { row_time($a) <=> row_time($b) } 0 .. $rows - 1;
+}
+
+# A layout is a list of screens, each screen is [rows, [[row, hwid, line], ...]]
+# where a hwid of undef stands for the dictionary line.
+# "interleave" stores the lines round-robin in as few screens as possible,
+# "spread" distributes every firmware evenly over all screens with no more
+# lines per screen than the flasher can process while it is shown.
+sub build_layout {
+    my $strategy = shift;
+    my $linecounts = shift;
+    my $rates = shift;
+    my $have_dict = shift;
+    my $dict_everywhere = shift;
+    my @hwids = sort keys %$linecounts;
+    my $total = 0;
+    $total += $_ foreach values %$linecounts;
+
+    my $datarows = DATA_ROWS - ($have_dict && $dict_everywhere ? 1 : 0);
+    my $extra = $have_dict && !$dict_everywhere ? 1 : 0;
+    my $screencount = ceil(($total + $extra) / $datarows) || 1;
+    my @screenitems;
+
+    if ($strategy eq "interleave") {
+        my @sequence;
+        push @sequence, [ undef, 0 ] if $extra;
+
+        for (my $line = 0; scalar(@sequence) < $total + $extra; $line++) {
+            foreach my $hwid (@hwids) {
+                push @sequence, [ $hwid, $line ] if $line < $linecounts->{$hwid};
+            }
+        }
+
+        my $per_screen = ceil(scalar(@sequence) / $screencount);
+        for (my $i = 0; $i < $screencount; $i++) {
+            my @items = grep { defined } @sequence[$i * $per_screen .. ($i + 1) * $per_screen - 1];
+            unshift @items, [ undef, 0 ] if $have_dict && $dict_everywhere;
+            push @screenitems, \@items;
+        }
+
+        # rows in storage order, screen only as large as needed
+        my @layout;
+        my $rows = $per_screen + ($have_dict && $dict_everywhere ? 1 : 0);
+        foreach my $items (@screenitems) {
+            my $row = 0;
+            push @layout, [ $rows, [ map { [ $row++, @$_ ] } @$items ] ];
+        }
+
+        return \@layout;
+    }
+
+    foreach my $hwid (@hwids) {
+        my $needed = ceil($linecounts->{$hwid} / $rates->{$hwid});
+        $screencount = $needed if $needed > $screencount;
+    }
+
+    # rounding can overfill single screens, add more until everything fits
+    while (1) {
+        @screenitems = ();
+
+        for (my $i = 0; $i < $screencount; $i++) {
+            my @perhwid;
+
+            foreach my $hwid (@hwids) {
+                my $first = int($i * $linecounts->{$hwid} / $screencount);
+                my $last  = int(($i + 1) * $linecounts->{$hwid} / $screencount);
+                push @perhwid, [ map { [ $hwid, $_ ] } $first .. $last - 1 ];
+            }
+
+            # round-robin, so lines of the same firmware are far apart
+            my @items;
+            push @items, [ undef, 0 ] if $have_dict && ($dict_everywhere || $i == 0);
+
+            while (grep { scalar(@$_) > 0 } @perhwid) {
+                push @items, shift(@$_) foreach grep { scalar(@$_) > 0 } @perhwid;
+            }
+
+            push @screenitems, \@items;
+        }
+
+        last if !grep { scalar(@$_) > DATA_ROWS } @screenitems;
+        $screencount++;
+    }
+
+    # place the items evenly over the display time of the screen
+    my @slots = rows_by_time(DATA_ROWS);
+    my @layout;
+
+    foreach my $items (@screenitems) {
+        my $count = scalar(@$items);
+        push @layout, [ DATA_ROWS,
+                        [ map { [ $slots[int($_ * DATA_ROWS / $count)], @{$items->[$_]} ] } 0 .. $count - 1 ] ];
+    }
+
+    return \@layout;
+}
+
+# expected time until one flasher has written all of its lines,
+# averaged over several starting points in the carousel
+sub simulate_update {
+    my $layout = shift;
+    my $hwid = shift;
+    my $lines = shift;      # line_chunks result for every line
+    my $have_dict = shift;
+    my $period = scalar(@$layout) * SCREEN_TIME;
+    my @occurrences;
+
+    for (my $screen = 0; $screen < scalar(@$layout); $screen++) {
+        foreach my $item (@{$layout->[$screen]->[1]}) {
+            my ($row, $itemhwid, $line) = @$item;
+
+            if (!defined($itemhwid)) {
+                push @occurrences, [ $screen * SCREEN_TIME + row_time($row), -1 ];
+            } elsif ($itemhwid eq $hwid) {
+                push @occurrences, [ $screen * SCREEN_TIME + row_time($row), $line ];
+            }
+        }
+    }
+
+    @occurrences = sort { $a->[0] <=> $b->[0] } @occurrences;
+
+    my $totaltime = 0;
+
+    for (my $start = 0; $start < SIM_STARTS; $start++) {
+        my $now = $start * $period / SIM_STARTS;
+        my %needed = map { $_ => 1 } 0 .. scalar(@$lines) - 1;
+        my $want_dict = $have_dict;
+        my %erased;
+        my $cycle = 0;
+        my $index = 0;
+
+        # skip to the first line after the starting point
+        $index++ while $index < scalar(@occurrences) && $occurrences[$index]->[0] < $now;
+
+        while ($want_dict || %needed) {
+            if ($index >= scalar(@occurrences)) {
+                $index = 0;
+                $cycle++;
+            }
+
+            my ($time, $line) = @{$occurrences[$index++]};
+            $time += $cycle * $period;
+
+            # missed while busy or not in the capture range yet
+            next if $time < $now;
+            next if $want_dict ? $line != -1 : ($line == -1 || !$needed{$line});
+
+            if ($want_dict) {
+                $want_dict = 0;
+                $now = $time + LINE_TIME;
+            } else {
+                delete $needed{$line};
+                $now = $time + line_busy_time($lines->[$line], \%erased);
+            }
+        }
+
+        $totaltime += $now - $start * $period / SIM_STARTS;
+    }
+
+    return $totaltime / SIM_STARTS;
+}
+
+# lines of the flasher that are processed while one screen is shown
+sub flasher_rate {
+    my $lines = shift;
+    my $busy = 0;
+    my %erased = map { $_ => 1 } 0 .. 255; # erasing is a one-time cost
+
+    $busy += line_busy_time($_, \%erased) foreach @$lines;
+
+    my $rate = int(SCREEN_TIME * scalar(@$lines) / $busy);
+    return $rate < 1 ? 1 : $rate;
+}
+
+# choose compression variant, layout strategy and dictionary placement
+# to minimize the worst-case (and then the total) expected update time
+sub optimize_transport {
+    my $variants = shift;   # hwid => [ [ packed lines ], ... ]
+    my $have_dict = shift;
+    my @hwids = sort keys %$variants;
+    my %chunkinfo;
+
+    foreach my $hwid (@hwids) {
+        $chunkinfo{$hwid} = [ map { [ map { line_chunks($_) } @$_ ] } @{$variants->{$hwid}} ];
+    }
+
+    my $evaluate = sub {
+        my ($strategy, $dict_everywhere, $choice) = @_;
+        my %linecounts = map { $_ => scalar(@{$chunkinfo{$_}->[$choice->{$_}]}) } @hwids;
+        my %rates = map { $_ => flasher_rate($chunkinfo{$_}->[$choice->{$_}]) } @hwids;
+        my $layout = build_layout($strategy, \%linecounts, \%rates, $have_dict, $dict_everywhere);
+        my %expected;
+
+        foreach my $hwid (@hwids) {
+            $expected{$hwid} = simulate_update($layout, $hwid, $chunkinfo{$hwid}->[$choice->{$hwid}], $have_dict);
+        }
+
+        my ($worst, $sum) = (0, 0);
+        foreach (values %expected) {
+            $worst = $_ if $_ > $worst;
+            $sum += $_;
+        }
+
+        my $rows = 0;
+        $rows += $_->[0] + 2 foreach @$layout;
+
+        return { strategy => $strategy, dict_everywhere => $dict_everywhere,
+                 choice => { %$choice }, layout => $layout, expected => \%expected,
+                 worst => $worst, sum => $sum, oversize => $rows * 1440 > MAX_DATA_BYTES };
+    };
+
+    my $better = sub {
+        my ($new, $old) = @_;
+        return !$new->{oversize} if $new->{oversize} != $old->{oversize};
+        return $new->{worst} < $old->{worst} - 1e-9 ||
+          (abs($new->{worst} - $old->{worst}) <= 1e-9 && $new->{sum} < $old->{sum});
+    };
+
+    my %firstchoice = map { $_ => 0 } @hwids;
+    my $baseline = $evaluate->("interleave", 0, \%firstchoice);
+    my $best = $baseline;
+
+    foreach my $strategy ("interleave", "spread") {
+        foreach my $dict_everywhere ($have_dict ? (0, 1) : (0)) {
+            my $current = $evaluate->($strategy, $dict_everywhere, \%firstchoice);
+
+            # coordinate descent over the compression variants of each firmware
+            for (my $sweep = 0; $sweep < 2; $sweep++) {
+                foreach my $hwid (@hwids) {
+                    for (my $v = 0; $v < scalar(@{$chunkinfo{$hwid}}); $v++) {
+                        next if $v == $current->{choice}->{$hwid};
+
+                        my $candidate = $evaluate->($strategy, $dict_everywhere,
+                                                    { %{$current->{choice}}, $hwid => $v });
+                        $current = $candidate if $better->($candidate, $current);
+                    }
+                }
+            }
+
+            $best = $current if $better->($current, $best);
+        }
+    }
+
+    return ($best, $baseline);
+}
+
 # ---
 
+# stop here when loaded by another script (Firmware/updatesim/mkcorpus.pl)
+return 1 if caller;
+
+# LZ chunks, 4 KByte chunks and the preset dictionary need a new info
+# line format that older flashers cannot parse, so they must be requested
+# explicitly
+my %opts = (lz => 0, large => 0, dict => 0);
+GetOptions(\%opts, "lz", "large", "dict") or exit 1;
+$opts{newformat} = $opts{lz} || $opts{large} || $opts{dict};
+
 if (scalar(@ARGV) < 2) {
-    say "Usage: $0 updater.dol output.dol firmware.bin [firmware2.bin ...]";
+    say "Usage: $0 [--lz] [--large] [--dict] updater.dol output.dol firmware.bin [firmware2.bin ...]";
     exit 1;
 }
 
 
-if (!have_exomizer()) {
+if (!have_exomizer() && !$opts{lz}) {
     # due to a bug in flashers from 3.0-3.0c, chunks must always be compressed
     say STDERR "exomizer not available, cannot proceed";
     exit 2;
@@ -429,28 +1050,80 @@ while (scalar(@ARGV) > 0) {
         $commonversion = $version;
     }
 
-    my @blocks = compress_firmware($inname, $data);
-    my @lines = binpack(LINE_BYTES, @blocks);
-    my $page = scalar(keys %firmwares) + INFO_PAGE + 1;
+    $firmwares{$hwid} = {
+        name    => $inname,
+        version => $version,
+        data    => $data,
+        page    => scalar(keys %firmwares) + INFO_PAGE + 1
+    };
+}
+
+# the dictionary is shared by all firmwares, so it must be known before compressing
+my $dictline;
+
+if ($opts{dict}) {
+    $opts{dict} = build_dictionary(map { $_->{data} } values %firmwares);
+    say "Preset dictionary: ", length($opts{dict}), " bytes";
+    $dictline = encode_line($opts{dict}, DICT_LINE, INFO_PAGE);
+} else {
+    $opts{dict} = "";
+}
+
+# compression and packing variants for the transport optimizer
+my %variants;
+my @policies = $opts{newformat} ? ("time", "size") : ("time");
+
+foreach my $hwid (sort { $firmwares{$a}->{page} <=> $firmwares{$b}->{page} } keys %firmwares) {
+    my $inname = $firmwares{$hwid}->{name};
+    my %seen;
 
-    say "$inname: fitted into ", scalar(@lines), " lines";
+    foreach my $policy (@policies) {
+        my @blocks = compress_firmware("$inname ($policy)", $firmwares{$hwid}->{data},
+                                       { %opts, policy => $policy });
+
+        foreach my $bestfit (0, 1) {
+            my @lines = binpack(LINE_BYTES, $bestfit, @blocks);
+            my $key = join("", @lines);
+
+            next if $seen{$key}++;
+            push @{$variants{$hwid}}, \@lines;
+        }
+    }
+}
+
+my ($transport, $baseline) = optimize_transport(\%variants, defined($dictline));
+
+printf "Transport: %s layout, %d screens, carousel period %.2f s%s\n",
+  $transport->{strategy}, scalar(@{$transport->{layout}}),
+  scalar(@{$transport->{layout}}) * SCREEN_TIME,
+  defined($dictline) ? ($transport->{dict_everywhere} ? ", dictionary in every screen" : ", dictionary once") : "";
+
+foreach my $hwid (sort { $firmwares{$a}->{page} <=> $firmwares{$b}->{page} } keys %firmwares) {
+    my @lines = @{$variants{$hwid}->[$transport->{choice}->{$hwid}]};
+    my $page = $firmwares{$hwid}->{page};
+    my $screens = grep { grep { defined($_->[1]) && $_->[1] eq $hwid } @{$_->[1]} } @{$transport->{layout}};
+
+    printf "%s: 0x%08x, %d lines in %d screens, carousel period %.2f s, expected update time %.2f s (was %.2f s)\n",
+      $firmwares{$hwid}->{name}, $hwid, scalar(@lines), $screens,
+      scalar(@{$transport->{layout}}) * SCREEN_TIME,
+      $transport->{expected}->{$hwid}, $baseline->{expected}->{$hwid};
 
     for (my $i = 0; $i < scalar(@lines); $i++) {
         $lines[$i] = encode_line($lines[$i], $i, $page);
     }
 
-    $firmwares{$hwid} = {
-        version => $version,
-        data    => $data,
-        lines   => \@lines,
-        page    => $page
-    };
+    $firmwares{$hwid}->{lines} = \@lines;
 }
 
 # construct infoline
-my $infoline = pack("n", scalar(keys %firmwares));
-my $totallines = 0;
-
+# (with the new format, old flashers see an empty list and refuse the update)
+my $infoline = "";
+if (defined($dictline)) {
+    $infoline .= pack("nn", 0, INFO_FORMAT_LZDICT);
+} elsif ($opts{newformat}) {
+    $infoline .= pack("nn", 0, INFO_FORMAT_LZ);
+}
+$infoline .= pack("n", scalar(keys %firmwares));
 foreach my $hwid (sort keys %firmwares) {
     $infoline .= pack("Nnna8",
                       $hwid,
@@ -458,8 +1131,6 @@ foreach my $hwid (sort keys %firmwares) {
                       $firmwares{$hwid}->{page},
                       $firmwares{$hwid}->{version});
 
-    $totallines += scalar(@{$firmwares{$hwid}->{lines}});
-
     if (length($infoline) > LINE_BYTES) {
         # 76 firmwares in one package should be enough for anyone
         say STDERR "Maximum info line size exceeded, add less firmware variants!";
@@ -467,38 +1138,30 @@ foreach my $hwid (sort keys %firmwares) {
     }
 }
 
-if ($totallines * 1440 > 8 * 1024 * 1024) {
-    printf STDERR "WARNING: Output data block will be excessively large (%.1f MiB)\n",
-      $totallines * 1440.0 / 1024.0 / 1024.0;
-}
+# build final screens from the chosen layout
+my @screens;
+my $totalrows = 0;
 
-# interleave data from all firmwares
-my @lines;
-while ($totallines > 0) {
-    foreach my $hwid (keys %firmwares) {
-        if (scalar(@{$firmwares{$hwid}->{lines}}) > 0) {
-            push @lines, shift(@{$firmwares{$hwid}->{lines}});
-            $totallines--;
-        }
-    }
-}
+foreach my $screenlayout (@{$transport->{layout}}) {
+    my ($rows, $items) = @$screenlayout;
+    my @rowdata = ("\x80" x 1440) x $rows;
 
-# build final screens
-my $screencount = ceil(scalar(@lines) / (SCREEN_LINES - 2));
-my $lines_per_screen = ceil(scalar(@lines) / $screencount);
+    foreach my $item (@$items) {
+        my ($row, $hwid, $line) = @$item;
+        $rowdata[$row] = defined($hwid) ? $firmwares{$hwid}->{lines}->[$line] : $dictline;
+    }
 
-my @screens;
-for (my $i = 0; $i < $screencount; $i++) {
     my $screen = encode_line($infoline, 0, 0x10);
     $screen .= $screen; # replicate infoline so it appears in both fields
-
-    for (my $j = 0; $j < $lines_per_screen; $j++) {
-        my $line = $lines[$i * $lines_per_screen + $j];
-        $line = "\x80" x 1440 if !defined($line);
-        $screen .= $line;
-    }
+    $screen .= join("", @rowdata);
 
     push @screens, $screen;
+    $totalrows += $rows;
+}
+
+if ($totalrows * 1440 > MAX_DATA_BYTES) {
+    printf STDERR "WARNING: Output data block will be excessively large (%.1f MiB)\n",
+      $totalrows * 1440.0 / 1024.0 / 1024.0;
 }
 
 # build data header
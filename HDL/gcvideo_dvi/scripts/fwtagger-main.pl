@@ -80,10 +80,66 @@ sub crc_update {
     return $crc;
 }
 
+# flash layout, must match MAIN_APP_ADDRESS in flasher.c,
+# OVERLAY_FLASH_ADDRESS/OVERLAY_FLASH_SIZE in overlay.c and
+# XIP_ADDRESS_main/XIP_SIZE in the firmware Makefile.
+# The last page of the XIP area holds the install marker
+# (MARKER_ADDRESS in flasher.c) and must stay outside the image.
+my $MAIN_APP_ADDRESS = 0x30000;
+my $OVERLAY_ADDRESS  = 0x60000;
+my $OVERLAY_SIZE     = 0x8000;
+my $XIP_ADDRESS      = 0x68000;
+my $XIP_SIZE         = 0x7f00;
+my $HEADER_SIZE      = 20;
+
+sub read_file {
+    my $filename = shift;
+    my $data;
+
+    open IN, "<", $filename or do {
+        say STDERR "ERROR: Unable to open $filename: $!";
+        exit 2;
+    };
+
+    binmode IN;
+    my $readlen = sysread(IN, $data, -s $filename);
+    close IN;
+
+    if (!defined($readlen) || $readlen < 0) {
+        say STDERR "ERROR: Unable to read $filename: $!";
+        exit 2;
+    }
+
+    return $data;
+}
+
+# append data at a fixed flash address behind the current image
+sub append_at {
+    my $image   = shift;
+    my $data    = shift;
+    my $address = shift;
+    my $maxsize = shift;
+    my $name    = shift;
+
+    my $padded_length = $address - $MAIN_APP_ADDRESS - $HEADER_SIZE;
+
+    if (length($image) > $padded_length) {
+        say STDERR "ERROR: Image overlaps $name area";
+        exit 2;
+    }
+
+    if (length($data) > $maxsize) {
+        say STDERR "ERROR: $name data is too large";
+        exit 2;
+    }
+
+    return $image . chr(0xff) x ($padded_length - length($image)) . $data;
+}
+
 # ---
 
-if (scalar(@ARGV) != 4) {
-    say "Usage: $0 hardwareid version main.bin output.bin";
+if (scalar(@ARGV) < 4 || scalar(@ARGV) > 6) {
+    say "Usage: $0 hardwareid version main.bin output.bin [overlays.bin [xip.bin]]";
     exit 1;
 }
 
@@ -91,22 +147,21 @@ my $hwid       = $ARGV[0];
 my $version    = $ARGV[1];
 my $binfile    = $ARGV[2];
 my $outputfile = $ARGV[3];
+my $overlayfile = $ARGV[4];
+my $xipfile    = $ARGV[5];
 
 $hwid = oct($hwid) if $hwid =~ /^0/;
 
-open IN, "<", $binfile or do {
-    say STDERR "ERROR: Unable to open $binfile: $!";
-    exit 2;
-};
+my $bitstream = read_file($binfile);
 
-binmode IN;
-my $bitstream;
-my $readlen = sysread(IN, $bitstream, -s $binfile);
-close IN;
+if (defined($overlayfile)) {
+    $bitstream = append_at($bitstream, read_file($overlayfile),
+                           $OVERLAY_ADDRESS, $OVERLAY_SIZE, "overlay");
+}
 
-if (!defined($readlen) || $readlen < 0) {
-    say STDERR "ERROR: Unable to read $binfile: $!";
-    exit 2;
+if (defined($xipfile)) {
+    $bitstream = append_at($bitstream, read_file($xipfile),
+                           $XIP_ADDRESS, $XIP_SIZE, "XIP");
 }
 
 my $crc = crc_update(0xffffffff, $bitstream);
@@ -55,13 +55,14 @@ entity CPUSubsystem is
     I2S_BClock       : in  std_logic;
     I2S_LRClock      : in  std_logic;
     I2S_Data         : in  std_logic;
+    AudioRaw         : in  AudioData;
     SPI_COPI         : out std_logic;
     SPI_CIPO         : in  std_logic;
     SPI_SCK          : out std_logic;
     SPI_SEL          : out std_logic;
     ScanlineRamAddr  : in  std_logic_vector(7 downto 0);
     ScanlineRamData  : out std_logic_vector(8 downto 0);
-    InfoFrameRAMAddr : in  std_logic_vector(8 downto 0);
+    InfoFrameRAMAddr : in  std_logic_vector(10 downto 0);
     InfoFrameRAMData : out std_logic_vector(8 downto 0);
     OSDRamAddr       : in  std_logic_vector(10 downto 0);
     OSDRamData       : out std_logic_vector(8 downto 0);
@@ -75,11 +76,14 @@ architecture Behavioral of CPUSubsystem is
 
   constant ZPUBRAMSize: natural := 13;
 
+  -- flash is mapped for execution at 2**FlashWindowBit
+  constant FlashWindowBit: natural := 23;
+
   -- number of devices on the I/O bus
-  constant DeviceCount: Natural := 8;
+  constant DeviceCount: Natural := 12;
 
   -- number of interrupt-generating devices
-  constant IRQDeviceCount: Natural := 3;
+  constant IRQDeviceCount: Natural := 5;
 
   -- ZPU signals
   signal cpu_reset          : std_logic;
@@ -106,6 +110,10 @@ architecture Behavioral of CPUSubsystem is
   signal SPISel          : std_logic;
   signal IRRxSel         : std_logic;
   signal IFRSel          : std_logic;
+  signal FlashCacheSel   : std_logic;
+  signal OSDBlitSel      : std_logic;
+  signal SPIBufSel       : std_logic;
+  signal AudioDiagSel    : std_logic;
 
   signal ZPUIn           : ZPUDeviceIn;
   signal IRQControllerOut: ZPUDeviceOut;
@@ -116,15 +124,28 @@ architecture Behavioral of CPUSubsystem is
   signal SPIOut          : ZPUDeviceOut;
   signal IRRxOut         : ZPUDeviceOut;
   signal IFROut          : ZPUDeviceOut;
+  signal FlashCacheOut   : ZPUDeviceOut;
+  signal AudioDiagOut    : ZPUDeviceOut;
 
   signal VSyncIRQ        : std_logic;
   signal PadIRQ          : std_logic;
   signal IRRxIRQ         : std_logic;
+  signal VideoModeIRQ    : std_logic;
+  signal SPIDMAIRQ       : std_logic;
   signal IRQSignals      : ZPUIRQSignals(0 to IRQDeviceCount-1);
 
   signal DeviceSels      : ZPUMuxSelects(0 to DeviceCount-1);
   signal DeviceOuts      : ZPUMuxDevOuts(0 to DeviceCount-1);
 
+  signal spi_copi_cpu         : std_logic;
+  signal spi_sck_cpu          : std_logic;
+  signal spi_sel_cpu          : std_logic;
+  signal spi_copi_cache       : std_logic;
+  signal spi_sck_cache        : std_logic;
+  signal spi_sel_cache        : std_logic;
+  signal spi_dma_active       : std_logic;
+  signal spi_flash_busy       : std_logic;
+
   signal scanline_ram_addr_ext: std_logic_vector(9 downto 0);
   signal vid_settings         : VideoSettings_t;
 
@@ -132,17 +153,20 @@ begin
 
   Inst_ZPU: zpu_core_flex GENERIC MAP (
     IMPL_MULTIPLY       => true,  -- Self explanatory  [needs 3 mults]
+    IMPL_DIVIDE         => true,  -- Include div and mod  [34 cycles]
     IMPL_COMPARISON_SUB => true,  -- Include sub and (U)lessthan(orequal)
     IMPL_EQBRANCH       => true,  -- Include eqbranch and neqbranch
     IMPL_STOREBH        => false, -- Include halfword and byte writes [external RAM only!]
     IMPL_LOADBH         => false, -- Include halfword and byte reads  [external RAM only!]
+    IMPL_BRAM_BH        => true,  -- Include halfword and byte reads/writes to BRAM
     IMPL_CALL           => true,  -- Include call
     IMPL_SHIFT          => true,  -- Include lshiftright, ashiftright and ashiftleft
     IMPL_XOR            => true,  -- include xor instruction
-    EXECUTE_RAM         => false, -- Map the stack / Boot ROM to 0x40000000, to allow pushsp, store to work.
-    REMAP_STACK         => false, -- include support for executing code from outside the Boot ROM
+    EXECUTE_RAM         => true,  -- include support for executing code from outside the Boot ROM
+    REMAP_STACK         => false, -- Map the stack / Boot ROM to 0x40000000, to allow pushsp, store to work.
     stackbit            => 30,
     maxAddrBit          => 31,
+    maxAddrBitExternalRAM => FlashWindowBit,
     maxAddrBitBRAM      => ZPUBRAMSize
   ) PORT MAP (
     clk                 => Clock,
@@ -185,7 +209,7 @@ begin
 
   ---- devices
   -- interrupt controller
-  IRQSignals <= (0 => VSyncIRQ, 1 => PadIRQ, 2 => IRRxIRQ);
+  IRQSignals <= (0 => VSyncIRQ, 1 => PadIRQ, 2 => IRRxIRQ, 3 => VideoModeIRQ, 4 => SPIDMAIRQ);
   Inst_IRQController: ZPUIRQController GENERIC MAP (
     Devices => IRQDeviceCount
   ) PORT MAP (
@@ -219,6 +243,7 @@ begin
     ZPUBusIn         => ZPUIn,
     ZPUBusOut        => VideoIFOut,
     IRQ              => VSyncIRQ,
+    ModeIRQ          => VideoModeIRQ,
     VSettings        => vid_settings,
     VMeasure         => VMeasure,
     OSDSettings      => OSDSettings
@@ -255,13 +280,11 @@ begin
     );
   end generate;
 
-  -- OSD RAM
-  Inst_OSDRAM: ZPU_DPRAM GENERIC MAP (
-    AddressBits => 11,
-    DataBits    => 9
-  ) PORT MAP (
+  -- OSD RAM with blitter
+  Inst_OSDRAM: ZPUOSDRAM PORT MAP (
     Clock       => Clock,
-    ZSelect     => OSDRAMSel,
+    RAMSelect   => OSDRAMSel,
+    BlitSelect  => OSDBlitSel,
     ZPUBusIn    => ZPUIn,
     ZPUBusOut   => OSDRAMOut,
     RAMAddr     => OSDRamAddr,
@@ -274,14 +297,42 @@ begin
   ) PORT MAP (
     Clock     => Clock,
     ZSelect   => SPISel,
+    BufSelect => SPIBufSel,
     ZPUBusIn  => ZPUIn,
     ZPUBusOut => SPIOut,
-    SCOPI     => SPI_COPI,
+    IRQ       => SPIDMAIRQ,
+    DMAActive => spi_dma_active,
+    FlashBusy => spi_flash_busy,
+    SCOPI     => spi_copi_cpu,
+    SCIPO     => SPI_CIPO,
+    SClock    => spi_sck_cpu,
+    SSelect   => spi_sel_cpu
+  );
+
+  -- cached flash window for code execution
+  Inst_FlashCache: ZPUFlashCache GENERIC MAP (
+    SPIClockDiv   => 2,
+    FlashAddrBits => FlashWindowBit
+  ) PORT MAP (
+    Clock     => Clock,
+    ZSelect   => FlashCacheSel,
+    ZPUBusIn  => ZPUIn,
+    ZPUBusOut => FlashCacheOut,
+    Hold      => spi_dma_active,
+    FlashBusy => spi_flash_busy,
+    SCOPI     => spi_copi_cache,
     SCIPO     => SPI_CIPO,
-    SClock    => SPI_SCK,
-    SSelect   => SPI_SEL
+    SClock    => spi_sck_cache,
+    SSelect   => spi_sel_cache
   );
 
+  -- both SPI controllers idle high, the CPU never uses them concurrently
+  -- and the cache waits while the DMA engine is active or the
+  -- flash is busy with an erase/program operation
+  SPI_COPI <= spi_copi_cpu and spi_copi_cache;
+  SPI_SCK  <= spi_sck_cpu  and spi_sck_cache;
+  SPI_SEL  <= spi_sel_cpu  and spi_sel_cache;
+
   -- IR Receiver
   Inst_IRRx: ZPUIRReceiver generic map (
     ClockScale => 4096
@@ -298,7 +349,7 @@ begin
   -- Infoframe-RAM
   InfoFrameRAM: if Module = "main" generate
     Inst_IFRam: ZPU_DPRAM generic map (
-      AddressBits => 9,
+      AddressBits => 11,
       DataBits    => 9,
       DataFile    => "infoframe_rom.mif"
       ) port map (
@@ -327,6 +378,26 @@ begin
     );
   end generate;
 
+  -- audio statistics
+  AudioDiag: if Module = "main" generate
+    Inst_AudioDiag: ZPUAudioDiag port map (
+      Clock       => Clock,
+      ZSelect     => AudioDiagSel,
+      ZPUBusIn    => ZPUIn,
+      ZPUBusOut   => AudioDiagOut,
+      I2S_BClock  => I2S_BClock,
+      I2S_LRClock => I2S_LRClock,
+      I2S_Data    => I2S_Data,
+      AudioRaw    => AudioRaw
+    );
+  end generate;
+
+  NoAudioDiag: if Module = "flasher" generate
+    -- the flasher has no audio path, see SignalDiag instead
+    AudioDiagOut.mem_busy <= '0';
+    AudioDiagOut.mem_read <= (others => '0');
+  end generate;
+
   -- CPU-to-device signals
   ZPUIn.Reset           <= cpu_reset;
   ZPUIn.mem_write       <= cpu_mem_write;
@@ -347,10 +418,20 @@ begin
     SPISel           <= '0';
     IRRxSel          <= '0';
     IFRSel           <= '0';
+    FlashCacheSel    <= '0';
+    OSDBlitSel       <= '0';
+    SPIBufSel        <= '0';
+    AudioDiagSel     <= '0';
 
     if cpu_mem_writeEnable = '1' or
        cpu_mem_readEnable  = '1' then
       case cpu_mem_addr(31 downto 28) is
+        when x"0" =>
+          if cpu_mem_addr(FlashWindowBit) = '1' then
+            -- 0x00800000-0x00ffffff, cached flash
+            FlashCacheSel <= '1';
+          end if;
+
         when x"f" => -- peripheral space
           if cpu_mem_addr(15 downto 13) = "100" then
             -- 0xffff8000-9fff, reused for signal diag in flasher
@@ -368,6 +449,10 @@ begin
               when x"2"   => PadSel           <= '1';
               when x"3"   => SPISel           <= '1';
               when x"4"   => IRRxSel          <= '1';
+              when x"5"   => FlashCacheSel    <= '1';
+              when x"6"   => OSDBlitSel       <= '1';
+              when x"7"   => SPIBufSel        <= '1';
+              when x"8"   => AudioDiagSel     <= '1';
               when others => null;
             end case;
           end if;
@@ -386,7 +471,11 @@ begin
     4 => OSDRAMSel,
     5 => SPISel,
     6 => IRRxSel,
-    7 => IFRSel
+    7 => IFRSel,
+    8 => FlashCacheSel,
+    9 => OSDBlitSel,
+    10 => SPIBufSel,
+    11 => AudioDiagSel
   );
 
   DeviceOuts <= (
@@ -397,7 +486,11 @@ begin
     4 => OSDRAMOut,
     5 => SPIOut,
     6 => IRRxOut,
-    7 => IFROut
+    7 => IFROut,
+    8 => FlashCacheOut,
+    9 => OSDRAMOut,  -- blitter shares the OSD RAM output
+    10 => SPIOut,    -- DMA buffer shares the SPI output
+    11 => AudioDiagOut
   );
 
   MainZPUBusMux: ZPUBusMux
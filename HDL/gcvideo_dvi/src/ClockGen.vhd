@@ -38,11 +38,13 @@ use work.component_defs.all;
 
 entity ClockGen is
   generic (
-    TargetConsole: string  -- "GC" or "WII"
+    TargetConsole: string; -- "GC" or "WII"
+    FullRateModes: boolean -- adds the 270MHz serializer clock
   );
   port (
     ClockIn   : in  std_logic;
     BClock    : in  std_logic;
+    FullRate  : in  boolean;
     Clock54M  : out std_logic;
     ClockAudio: out std_logic;
     DVIClockP : out std_logic;
@@ -82,6 +84,14 @@ architecture Behavioral of ClockGen is
   signal adcm_reset_count    : natural range 0 to 7 := 0;
   signal clock_audio_internal: std_logic;
 
+  signal fdcm_clkfb          : std_logic;
+  signal fdcm_clk0           : std_logic;
+  signal fdcm_clkfx          : std_logic;
+  signal fdcm_clkfx180       : std_logic;
+  signal fdcm_locked         : std_logic;
+  signal fdcm_status         : std_logic_vector(7 downto 0);
+  signal dvi_select          : std_logic := '0';
+
   -- clock reset logic
   type reset_state_t is (WAIT_FOR_BCLOCK, RESET_RELEASE, RUNNING);
 
@@ -320,6 +330,90 @@ begin
     end if;
   end process;
 
+  -- Clocking primitive 3 - Full rate DVI
+  --   serializer clock for 54MHz pixels, only used
+  --   for the 3x/4x modes (5 * 54MHz)
+  --------------------------------------
+  fullrate_clocks: if FullRateModes generate
+    fullrate_dcm_sp_inst: DCM_SP
+    generic map
+     (CLKDV_DIVIDE          => 2.0,
+      CLKFX_DIVIDE          => 1,
+      CLKFX_MULTIPLY        => 5,
+      CLKIN_DIVIDE_BY_2     => false,
+      CLKOUT_PHASE_SHIFT    => "NONE",
+      CLK_FEEDBACK          => "1X",
+      DESKEW_ADJUST         => "SYSTEM_SYNCHRONOUS",
+      PHASE_SHIFT           => 0,
+      STARTUP_WAIT          => FALSE)
+    port map
+     -- Input clock
+     (CLKIN                 => ClockIn_internal,
+      CLKFB                 => fdcm_clkfb,
+      -- Output clocks
+      CLK0                  => fdcm_clk0,
+      CLK90                 => open,
+      CLK180                => open,
+      CLK270                => open,
+      CLK2X                 => open,
+      CLK2X180              => open,
+      CLKFX                 => fdcm_clkfx,
+      CLKFX180              => fdcm_clkfx180,
+      CLKDV                 => open,
+     -- Ports for dynamic phase shift
+      PSCLK                 => '0',
+      PSEN                  => '0',
+      PSINCDEC              => '0',
+      PSDONE                => open,
+     -- Other control and status signals
+      LOCKED                => fdcm_locked,
+      STATUS                => fdcm_status,
+      RST                   => vdcm_reset,
+     -- Unused pin, tie low
+      DSSEN                 => '0');
+
+    -- feedback
+    fdcm_clkfb <= fdcm_clk0;
+
+    -- switch the serializer to the fast clock only while it is needed
+    process(clock_54_internal)
+    begin
+      if rising_edge(clock_54_internal) then
+        if FullRate and fdcm_locked = '1' then
+          dvi_select <= '1';
+        else
+          dvi_select <= '0';
+        end if;
+      end if;
+    end process;
+
+    dviclkp_buf: BUFGMUX PORT MAP (
+      I0 => vdcm_clkfx,
+      I1 => fdcm_clkfx,
+      S  => dvi_select,
+      O  => dvip_internal
+    );
+
+    dviclkn_buf: BUFGMUX PORT MAP (
+      I0 => vdcm_clkfx180,
+      I1 => fdcm_clkfx180,
+      S  => dvi_select,
+      O  => dvin_internal
+    );
+  end generate;
+
+  halfrate_clocks: if not FullRateModes generate
+    dviclkp_buf: BUFG PORT MAP (
+      I => vdcm_clkfx,
+      O => dvip_internal
+    );
+
+    dviclkn_buf: BUFG PORT MAP (
+      I => vdcm_clkfx180,
+      O => dvin_internal
+    );
+  end generate;
+
   -- Output buffering
   -------------------------------------
 
@@ -329,16 +423,6 @@ begin
   );
   Clock54M <= clock_54_internal;
 
-  dviclkp_buf: BUFG PORT MAP (
-    I => vdcm_clkfx,
-    O => dvip_internal
-  );
-
-  dviclkn_buf: BUFG PORT MAP (
-    I => vdcm_clkfx180,
-    O => dvin_internal
-  );
-
   DVIClockP  <= dvip_internal;
   DVIClockN  <= dvin_internal;
 
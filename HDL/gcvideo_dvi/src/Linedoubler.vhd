@@ -24,7 +24,13 @@
 -- ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
 -- THE POSSIBILITY OF SUCH DAMAGE.
 --
--- Linedoubler: Simple line-doubler to convert 15kHz modes to 30kHz
+-- Linedoubler: Simple line multiplier to convert 15kHz modes to 30kHz or more
+--
+-- Every input line is read Factor times from a line buffer. 2x uses the
+-- doubled pixel clock from the decoder, 3x enables three of every four
+-- clocks and 4x runs at the full clock, so the number of pixels per
+-- line stays the same. FullRate signals that the output needs a 54MHz
+-- DVI pixel clock instead of the usual 27MHz one.
 --
 ----------------------------------------------------------------------------------
 
@@ -41,13 +47,15 @@ entity Linedoubler is
 
     -- input video
     Enable            : in  boolean;
+    Factor            : in  natural range 2 to 4;
     VideoIn           : in  VideoY422;
     PixelClockEnable  : in  boolean;
     PixelClockEnable2x: in  boolean;
 
     -- output video
     VideoOut          : out VideoY422;
-    PixelOutEnable    : out boolean
+    PixelOutEnable    : out boolean;
+    FullRate          : out boolean
   );
 end Linedoubler;
 
@@ -58,7 +66,14 @@ architecture Behavioral of Linedoubler is
   -- linedoubled video signal
   signal video_ld: VideoY422;
 
+  -- output pixel clock enable for the selected factor
+  signal out_enable: boolean;
+  signal in_phase  : natural range 0 to 3 := 0;
+  signal rep_count : natural range 0 to 3 := 0;
+
   -- line buffers
+  -- Each one is a separate RAMB16 on purpose: two lines of 901 x 18 bits
+  -- need 32 Kbit, so a single ping-pong RAM would also take two of them.
   constant linedata_size: natural := 8+8+2;
   type linebuffer_t is array(0 to 900) of unsigned(linedata_size-1 downto 0);
 
@@ -95,6 +110,24 @@ architecture Behavioral of Linedoubler is
 
 begin
 
+  -- position within an input pixel, 15kHz input pixels are four clocks long
+  process(PixelClock)
+  begin
+    if rising_edge(PixelClock) then
+      if PixelClockEnable then
+        in_phase <= 1;
+      elsif in_phase /= 3 then
+        in_phase <= in_phase + 1;
+      else
+        in_phase <= 0;
+      end if;
+    end if;
+  end process;
+
+  out_enable <= PixelClockEnable2x when Factor = 2 else
+                in_phase /= 0      when Factor = 3 else
+                true;
+
   -- pass signals to output
   process(PixelClock)
   begin
@@ -103,9 +136,11 @@ begin
       if VideoIn.Is30kHz or not Enable then
         VideoOut       <= VideoIn;
         PixelOutEnable <= PixelClockEnable;
+        FullRate       <= false;
       else
         VideoOut       <= video_ld;
-        PixelOutEnable <= PixelClockEnable2x;
+        PixelOutEnable <= out_enable;
+        FullRate       <= Factor > 2;
       end if;
     end if;
   end process;
@@ -170,10 +205,10 @@ begin
   end process;
 
   -- linedoubling, output process
-  process(PixelClock, PixelClockEnable2x)
+  process(PixelClock, out_enable)
     variable output_idx: natural range 0 to linebuffer_t'high;
   begin
-    if rising_edge(PixelClock) and PixelClockEnable2x then
+    if rising_edge(PixelClock) and out_enable then
       prev_hsync_output  <= VideoIn.HSync;
       output_idx         := buf_output_idx;
       output_use1_delay  <= output_use_buf1;
@@ -181,6 +216,7 @@ begin
       -- swap buffers at HSync (input) start
       if prev_hsync_output /= VideoIn.HSync and VideoIn.HSync then
         output_idx         := 0;
+        rep_count          <= 0;
         output_use1_delay  <= not output_use_buf1;
         output_use_buf1    <= not output_use_buf1;
         vsync_seen_delay   <= vsync_seen;
@@ -217,7 +253,14 @@ begin
         buf_output_idx <= 0;
         hsync_on_next  <= true;
 
-        if vsync_seen_delay and not vsync_pos_delay then -- check saved values if vsync is in the middle
+        if rep_count /= 3 then
+          rep_count <= rep_count + 1;
+        end if;
+
+        -- check saved values if vsync is in the middle
+        -- (rounded down to a whole line for odd factors)
+        if vsync_seen_delay and not vsync_pos_delay and
+           rep_count = Factor / 2 - 1 then
           vsync_on_next <= true;
         end if;
       end if;
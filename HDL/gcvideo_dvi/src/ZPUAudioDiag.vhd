@@ -0,0 +1,220 @@
+----------------------------------------------------------------------------------
+-- GCVideo DVI HDL
+-- Copyright (C) 2014-2021, Ingo Korb <ingo@akana.de>
+-- All rights reserved.
+--
+-- Redistribution and use in source and binary forms, with or without
+-- modification, are permitted provided that the following conditions are met:
+--
+-- 1. Redistributions of source code must retain the above copyright notice,
+--    this list of conditions and the following disclaimer.
+-- 2. Redistributions in binary form must reproduce the above copyright notice,
+--    this list of conditions and the following disclaimer in the documentation
+--    and/or other materials provided with the distribution.
+--
+-- THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+-- AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+-- IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+-- ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+-- LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+-- CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+-- SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+-- INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+-- CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+-- ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+-- THE POSSIBILITY OF SUCH DAMAGE.
+--
+-- ZPUAudioDiag.vhd: audio path statistics for the main firmware
+--
+-- All values are measured over one-second windows and latched at the
+-- end of each window, the sequence register counts the windows. Peak
+-- and clip statistics use the decoded samples before volume scaling.
+--
+----------------------------------------------------------------------------------
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use IEEE.NUMERIC_STD.ALL;
+
+use work.ZPUDevices.all;
+use work.video_defs.all;
+
+entity ZPUAudioDiag is
+  generic (
+    ClockFrequency: natural := 54000000
+  );
+  port (
+    Clock      : in  std_logic;
+    ZSelect    : in  std_logic;
+    ZPUBusIn   : in  ZPUDeviceIn;
+    ZPUBusOut  : out ZPUDeviceOut;
+
+    -- diagnosed signals
+    I2S_BClock : in  std_logic;
+    I2S_LRClock: in  std_logic;
+    I2S_Data   : in  std_logic;
+    AudioRaw   : in  AudioData
+  );
+end ZPUAudioDiag;
+
+architecture Behavioral of ZPUAudioDiag is
+
+  subtype counter_t is unsigned(23 downto 0);
+  subtype level_t   is unsigned(15 downto 0);
+
+  signal window_timer: natural range 0 to ClockFrequency-1 := 0;
+  signal sequence    : unsigned(31 downto 0) := (others => '0');
+
+  -- two synchronizer stages plus three samples for glitch detection
+  signal sync_bclock : std_logic_vector(4 downto 0);
+  signal sync_lrclock: std_logic_vector(4 downto 0);
+  signal sync_adata  : std_logic_vector(4 downto 0);
+
+  signal bclock_glitches_cur  : counter_t := (others => '0');
+  signal lrclock_glitches_cur : counter_t := (others => '0');
+  signal adata_glitches_cur   : counter_t := (others => '0');
+  signal samplerate_cur       : counter_t := (others => '0');
+  signal clipped_cur          : counter_t := (others => '0');
+  signal peak_left_cur        : level_t   := (others => '0');
+  signal peak_right_cur       : level_t   := (others => '0');
+
+  signal bclock_glitches_prev : counter_t := (others => '0');
+  signal lrclock_glitches_prev: counter_t := (others => '0');
+  signal adata_glitches_prev  : counter_t := (others => '0');
+  signal samplerate_prev      : counter_t := (others => '0');
+  signal clipped_prev         : counter_t := (others => '0');
+  signal peak_left_prev       : level_t   := (others => '0');
+  signal peak_right_prev      : level_t   := (others => '0');
+
+  function is_glitch(v: std_logic_vector(4 downto 0))
+    return boolean is
+  begin
+    return v(4 downto 2) = "010" or v(4 downto 2) = "101";
+  end function;
+
+  function magnitude(sample: signed(15 downto 0))
+    return level_t is
+    variable tmp: signed(16 downto 0);
+  begin
+    tmp := abs(resize(sample, 17));
+    return unsigned(tmp(15 downto 0));
+  end function;
+
+  function is_clipped(sample: signed(15 downto 0))
+    return boolean is
+  begin
+    return sample = x"7fff" or sample = x"8000";
+  end function;
+
+begin
+
+  ZPUBusOut.mem_busy <= '0';
+
+  -- ZPU interface
+  process(Clock)
+  begin
+    if rising_edge(Clock) then
+      ZPUBusOut.mem_read <= (others => '0');
+
+      if ZSelect = '1' and ZPUBusIn.mem_readEnable = '1' then
+        case ZPUBusIn.mem_addr(4 downto 2) is
+          when "000" =>
+            ZPUBusOut.mem_read <= std_logic_vector(sequence);
+
+          when "001" =>
+            ZPUBusOut.mem_read(23 downto 0) <= std_logic_vector(bclock_glitches_prev);
+
+          when "010" =>
+            ZPUBusOut.mem_read(23 downto 0) <= std_logic_vector(lrclock_glitches_prev);
+
+          when "011" =>
+            ZPUBusOut.mem_read(23 downto 0) <= std_logic_vector(adata_glitches_prev);
+
+          when "100" =>
+            ZPUBusOut.mem_read(23 downto 0) <= std_logic_vector(samplerate_prev);
+
+          when "101" =>
+            ZPUBusOut.mem_read(31 downto 16) <= std_logic_vector(peak_left_prev);
+            ZPUBusOut.mem_read(15 downto  0) <= std_logic_vector(peak_right_prev);
+
+          when "110" =>
+            ZPUBusOut.mem_read(23 downto 0) <= std_logic_vector(clipped_prev);
+
+          when others => null;
+
+        end case;
+      end if;
+    end if;
+  end process;
+
+  -- signal analysis
+  process(Clock)
+    variable clipped: natural range 0 to 2;
+  begin
+    if rising_edge(Clock) then
+      sync_bclock  <= sync_bclock(3 downto 0)  & I2S_BClock;
+      sync_lrclock <= sync_lrclock(3 downto 0) & I2S_LRClock;
+      sync_adata   <= sync_adata(3 downto 0)   & I2S_Data;
+
+      if window_timer /= ClockFrequency-1 then
+        window_timer <= window_timer + 1;
+
+        if is_glitch(sync_bclock) then
+          bclock_glitches_cur <= bclock_glitches_cur + 1;
+        end if;
+
+        if is_glitch(sync_lrclock) then
+          lrclock_glitches_cur <= lrclock_glitches_cur + 1;
+        end if;
+
+        if is_glitch(sync_adata) then
+          adata_glitches_cur <= adata_glitches_cur + 1;
+        end if;
+
+        -- samples are counted per stereo pair
+        if AudioRaw.LeftEnable then
+          samplerate_cur <= samplerate_cur + 1;
+
+          if magnitude(AudioRaw.Left) > peak_left_cur then
+            peak_left_cur <= magnitude(AudioRaw.Left);
+          end if;
+        end if;
+
+        if AudioRaw.RightEnable and magnitude(AudioRaw.Right) > peak_right_cur then
+          peak_right_cur <= magnitude(AudioRaw.Right);
+        end if;
+
+        clipped := 0;
+        if AudioRaw.LeftEnable and is_clipped(AudioRaw.Left) then
+          clipped := clipped + 1;
+        end if;
+        if AudioRaw.RightEnable and is_clipped(AudioRaw.Right) then
+          clipped := clipped + 1;
+        end if;
+        clipped_cur <= clipped_cur + clipped;
+
+      else
+        -- end of window, the events of this cycle are dropped
+        window_timer <= 0;
+        sequence     <= sequence + 1;
+
+        bclock_glitches_prev  <= bclock_glitches_cur;
+        lrclock_glitches_prev <= lrclock_glitches_cur;
+        adata_glitches_prev   <= adata_glitches_cur;
+        samplerate_prev       <= samplerate_cur;
+        clipped_prev          <= clipped_cur;
+        peak_left_prev        <= peak_left_cur;
+        peak_right_prev       <= peak_right_cur;
+
+        bclock_glitches_cur   <= (others => '0');
+        lrclock_glitches_cur  <= (others => '0');
+        adata_glitches_cur    <= (others => '0');
+        samplerate_cur        <= (others => '0');
+        clipped_cur           <= (others => '0');
+        peak_left_cur         <= (others => '0');
+        peak_right_cur        <= (others => '0');
+      end if;
+    end if;
+  end process;
+
+end Behavioral;
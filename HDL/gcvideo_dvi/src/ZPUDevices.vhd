@@ -137,6 +137,7 @@ package ZPUDevices is
       ZPUBusIn        : in  ZPUDeviceIn;
       ZPUBusOut       : out ZPUDeviceOut;
       IRQ             : out std_logic;
+      ModeIRQ         : out std_logic;
       VSettings       : out VideoSettings_t;
       VMeasure        : in  VideoMeasurements_t;
       OSDSettings     : out OSDSettings_t
@@ -167,8 +168,12 @@ package ZPUDevices is
     port (
       Clock    : in  std_logic;
       ZSelect  : in  std_logic; -- ZPU peripheral select
+      BufSelect: in  std_logic; -- DMA buffer select
       ZPUBusIn : in  ZPUDeviceIn;
       ZPUBusOut: out ZPUDeviceOut;
+      IRQ      : out std_logic; -- DMA transfer finished
+      DMAActive: out std_logic; -- DMA engine owns the SPI bus
+      FlashBusy: out std_logic; -- flash may be erasing or programming
       SCOPI    : out std_logic; -- SPI controller out, peripheral in
       SCIPO    : in  std_logic; -- SPI controller in, peripheral out
       SClock   : out std_logic; -- SPI clock
@@ -176,6 +181,42 @@ package ZPUDevices is
     );
   end component;
 
+  component ZPUOSDRAM is
+    generic (
+      LineLength: natural := 45
+    );
+    port (
+      Clock     : in  std_logic;
+      RAMSelect : in  std_logic;
+      BlitSelect: in  std_logic;
+      ZPUBusIn  : in  ZPUDeviceIn;
+      ZPUBusOut : out ZPUDeviceOut;
+      RAMAddr   : in  std_logic_vector(10 downto 0);
+      RAMData   : out std_logic_vector(8 downto 0)
+    );
+  end component;
+
+  component ZPUFlashCache is
+    generic (
+      SPIClockDiv  : natural range 1 to 255;
+      IndexBits    : natural range 1 to 9  := 6;
+      LineBits     : natural range 1 to 5  := 3;
+      FlashAddrBits: natural range 16 to 24 := 23
+    );
+    port (
+      Clock    : in  std_logic;
+      ZSelect  : in  std_logic;
+      ZPUBusIn : in  ZPUDeviceIn;
+      ZPUBusOut: out ZPUDeviceOut;
+      Hold     : in  std_logic;
+      FlashBusy: in  std_logic;
+      SCOPI    : out std_logic;
+      SCIPO    : in  std_logic;
+      SClock   : out std_logic;
+      SSelect  : out std_logic
+    );
+  end component;
+
   component ZPUWatchdog is
     generic (
       TriggerLimit: natural range 1 to 1000
@@ -230,6 +271,24 @@ package ZPUDevices is
     );
   end component;
 
+  component ZPUAudioDiag is
+    generic (
+      ClockFrequency: natural := 54000000
+    );
+    port (
+      Clock      : in  std_logic;
+      ZSelect    : in  std_logic;
+      ZPUBusIn   : in  ZPUDeviceIn;
+      ZPUBusOut  : out ZPUDeviceOut;
+
+      -- diagnosed signals
+      I2S_BClock : in  std_logic;
+      I2S_LRClock: in  std_logic;
+      I2S_Data   : in  std_logic;
+      AudioRaw   : in  AudioData
+    );
+  end component;
+
 end ZPUDevices;
 
 package body ZPUDevices is
@@ -0,0 +1,314 @@
+----------------------------------------------------------------------------------
+-- GCVideo DVI HDL
+-- Copyright (C) 2014-2021, Ingo Korb <ingo@akana.de>
+-- All rights reserved.
+--
+-- Redistribution and use in source and binary forms, with or without
+-- modification, are permitted provided that the following conditions are met:
+--
+-- 1. Redistributions of source code must retain the above copyright notice,
+--    this list of conditions and the following disclaimer.
+-- 2. Redistributions in binary form must reproduce the above copyright notice,
+--    this list of conditions and the following disclaimer in the documentation
+--    and/or other materials provided with the distribution.
+--
+-- THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+-- AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+-- IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+-- ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+-- LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+-- CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+-- SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+-- INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+-- CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+-- ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+-- THE POSSIBILITY OF SUCH DAMAGE.
+--
+-- ZPUFlashCache.vhd: Read-only direct-mapped cache for a SPI flash window
+--
+-- The select covers two address ranges: Accesses with mem_addr(31) = '0'
+-- go to the flash window (the decoder must ensure that only the window
+-- selects the device there), everything else is the register interface.
+-- The cache drives its own set of SPI signals which idle high, so they
+-- can be ANDed with those of the software-controlled SPI port. Software
+-- must not hold the flash selected while it runs code from the window,
+-- misses are delayed while Hold is active. While FlashBusy is set, a miss
+-- first polls the status register until an erase or program operation
+-- started by software has finished.
+--
+----------------------------------------------------------------------------------
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use IEEE.NUMERIC_STD.ALL;
+
+use work.ZPUDevices.all;
+
+entity ZPUFlashCache is
+  generic (
+    SPIClockDiv  : natural range 1 to 255;
+    IndexBits    : natural range 1 to 9  := 6;  -- log2 of the number of lines
+    LineBits     : natural range 1 to 5  := 3;  -- log2 of the words per line
+    FlashAddrBits: natural range 16 to 24 := 23 -- size of the flash window
+  );
+  port (
+    Clock    : in  std_logic;
+    ZSelect  : in  std_logic;
+    ZPUBusIn : in  ZPUDeviceIn;
+    ZPUBusOut: out ZPUDeviceOut;
+    Hold     : in  std_logic; -- delays line fills while another master uses SPI
+    FlashBusy: in  std_logic; -- flash may be erasing/programming, wait for WIP
+    SCOPI    : out std_logic; -- SPI controller out, peripheral in
+    SCIPO    : in  std_logic; -- SPI controller in, peripheral out
+    SClock   : out std_logic; -- SPI clock
+    SSelect  : out std_logic  -- SPI select
+  );
+end ZPUFlashCache;
+
+architecture Behavioral of ZPUFlashCache is
+  constant OffsetBits: natural := LineBits + 2;
+  constant TagBits   : natural := FlashAddrBits - IndexBits - OffsetBits;
+
+  subtype index_t  is unsigned(IndexBits-1 downto 0);
+  subtype word_t   is unsigned(LineBits-1 downto 0);
+  subtype tag_t    is unsigned(TagBits-1 downto 0);
+
+  type data_ram_t  is array(0 to 2**(IndexBits + LineBits) - 1) of std_logic_vector(31 downto 0);
+  type tag_ram_t   is array(0 to 2**IndexBits - 1) of tag_t;
+
+  type cache_state_t is (STATE_IDLE, STATE_LOOKUP, STATE_STATUS, STATE_STATUS_END,
+                         STATE_FILL, STATE_DESELECT, STATE_REPLAY);
+
+  signal data_ram   : data_ram_t;
+  signal tag_ram    : tag_ram_t;
+  signal line_valid : std_logic_vector(2**IndexBits - 1 downto 0) := (others => '0');
+
+  signal state      : cache_state_t := STATE_IDLE;
+  signal req_tag    : tag_t;
+  signal req_index  : index_t;
+  signal req_word   : word_t;
+  signal ram_q      : std_logic_vector(31 downto 0);
+  signal reg_q      : std_logic_vector(31 downto 0) := (others => '0');
+  signal read_ram   : boolean := false;
+
+  signal hit_count  : unsigned(31 downto 0) := (others => '0');
+  signal miss_count : unsigned(31 downto 0) := (others => '0');
+
+  signal spi_clockcounter: natural range 0 to SPIClockDiv-1 := 0;
+  signal spi_clock       : std_logic                        := '1';
+  signal spi_sel         : std_logic                        := '1';
+  signal spi_out         : std_logic                        := '1';
+  signal spi_data        : std_logic_vector(31 downto 0)    := (others => '0');
+  signal spi_bit         : natural range 0 to 31            := 0;
+  signal spi_command     : boolean                          := false;
+  signal fill_word       : word_t;
+
+begin
+
+  SSelect <= spi_sel;
+  SClock  <= spi_clock;
+  SCOPI   <= spi_out;
+
+  ZPUBusOut.mem_read <= ram_q when read_ram else reg_q;
+
+  process(Clock)
+    -- select the flash and start shifting out a command word
+    procedure start_command(data: std_logic_vector(31 downto 0)) is
+    begin
+      spi_data         <= data;
+      spi_command      <= true;
+      spi_bit          <= 0;
+      spi_sel          <= '0';
+      spi_clockcounter <= SPIClockDiv - 1;
+    end procedure;
+
+    -- read the whole requested line from flash
+    procedure start_fill is
+      variable command: std_logic_vector(31 downto 0);
+    begin
+      command := (others => '0');
+      command(31 downto 24) := x"03"; -- read data bytes
+      command(FlashAddrBits-1 downto OffsetBits) :=
+        std_logic_vector(req_tag & req_index);
+      start_command(command);
+      fill_word <= (others => '0');
+      state     <= STATE_FILL;
+    end procedure;
+
+  begin
+    if rising_edge(Clock) then
+      -- cache data RAM, always reads the requested word
+      ram_q <= data_ram(to_integer(req_index & req_word));
+
+      if ZPUBusIn.Reset = '1' then
+        state              <= STATE_IDLE;
+        line_valid         <= (others => '0');
+        hit_count          <= (others => '0');
+        miss_count         <= (others => '0');
+        spi_sel            <= '1';
+        spi_clock          <= '1';
+        spi_out            <= '1';
+        spi_command        <= false;
+        read_ram           <= false;
+        ZPUBusOut.mem_busy <= '0';
+      else
+        case state is
+          when STATE_IDLE =>
+            if ZSelect = '1' and ZPUBusIn.mem_addr(31) = '0' then
+              -- flash window, writes are ignored
+              if ZPUBusIn.mem_readEnable = '1' then
+                req_tag   <= unsigned(ZPUBusIn.mem_addr(FlashAddrBits-1 downto IndexBits + OffsetBits));
+                req_index <= unsigned(ZPUBusIn.mem_addr(IndexBits + OffsetBits - 1 downto OffsetBits));
+                req_word  <= unsigned(ZPUBusIn.mem_addr(OffsetBits - 1 downto 2));
+                read_ram  <= true;
+                state     <= STATE_LOOKUP;
+                ZPUBusOut.mem_busy <= '1';
+              end if;
+
+            elsif ZSelect = '1' then
+              -- register interface
+              if ZPUBusIn.mem_writeEnable = '1' then
+                case ZPUBusIn.mem_addr(3 downto 2) is
+                  when "00" =>
+                    hit_count  <= (others => '0');
+                    miss_count <= (others => '0');
+
+                  when "10" =>
+                    line_valid <= (others => '0');
+
+                  when others => null;
+                end case;
+
+              elsif ZPUBusIn.mem_readEnable = '1' then
+                read_ram <= false;
+
+                case ZPUBusIn.mem_addr(3 downto 2) is
+                  when "00"   => reg_q <= std_logic_vector(hit_count);
+                  when "01"   => reg_q <= std_logic_vector(miss_count);
+                  when others => reg_q <= (others => '0');
+                end case;
+              end if;
+            end if;
+
+          when STATE_LOOKUP =>
+            -- ram_q is valid at the end of this cycle
+            if line_valid(to_integer(req_index)) = '1' and
+               tag_ram(to_integer(req_index)) = req_tag then
+              hit_count          <= hit_count + 1;
+              state              <= STATE_IDLE;
+              ZPUBusOut.mem_busy <= '0';
+            elsif Hold = '0' then
+              miss_count <= miss_count + 1;
+              line_valid(to_integer(req_index)) <= '0';
+
+              if FlashBusy = '1' then
+                -- read status register, the flash repeats it until deselected
+                start_command(x"05000000");
+                state <= STATE_STATUS;
+              else
+                start_fill;
+              end if;
+            end if;
+
+          when STATE_STATUS =>
+            if spi_clockcounter /= 0 then
+              spi_clockcounter <= spi_clockcounter - 1;
+            else
+              spi_clockcounter <= SPIClockDiv - 1;
+
+              if spi_clock = '1' then
+                spi_clock <= '0';
+                spi_out   <= spi_data(31);
+              else
+                spi_clock <= '1';
+                spi_data  <= spi_data(30 downto 0) & SCIPO;
+
+                if spi_bit /= 31 then
+                  spi_bit <= spi_bit + 1;
+                else
+                  -- last bit of a status byte is write-in-progress
+                  spi_bit <= 0;
+                  if SCIPO = '0' then
+                    state <= STATE_STATUS_END;
+                  end if;
+                end if;
+              end if;
+            end if;
+
+          when STATE_STATUS_END =>
+            -- deselect after half an SPI clock, then keep it
+            -- deselected for a few cycles before the read command
+            if spi_clockcounter /= 0 then
+              spi_clockcounter <= spi_clockcounter - 1;
+            elsif spi_sel = '0' then
+              spi_sel <= '1';
+              spi_out <= '1';
+              spi_bit <= 0;
+            elsif spi_bit /= 7 then
+              spi_bit <= spi_bit + 1;
+            else
+              start_fill;
+            end if;
+
+          when STATE_FILL =>
+            if spi_clockcounter /= 0 then
+              spi_clockcounter <= spi_clockcounter - 1;
+            else
+              spi_clockcounter <= SPIClockDiv - 1;
+
+              if spi_clock = '1' then
+                -- falling edge, output changes
+                spi_clock <= '0';
+                if spi_command then
+                  spi_out <= spi_data(31);
+                else
+                  spi_out <= '1';
+                end if;
+              else
+                -- rising edge, sample input
+                spi_clock <= '1';
+                spi_data  <= spi_data(30 downto 0) & SCIPO;
+
+                if spi_bit /= 31 then
+                  spi_bit <= spi_bit + 1;
+                else
+                  spi_bit <= 0;
+
+                  if spi_command then
+                    -- command and address sent
+                    spi_command <= false;
+                  else
+                    data_ram(to_integer(req_index & fill_word)) <=
+                      spi_data(30 downto 0) & SCIPO;
+                    fill_word <= fill_word + 1;
+
+                    if fill_word = 2**LineBits - 1 then
+                      state <= STATE_DESELECT;
+                    end if;
+                  end if;
+                end if;
+              end if;
+            end if;
+
+          when STATE_DESELECT =>
+            -- keep select active for half an SPI clock after the last edge
+            if spi_clockcounter /= 0 then
+              spi_clockcounter <= spi_clockcounter - 1;
+            else
+              spi_sel   <= '1';
+              tag_ram(to_integer(req_index))    <= req_tag;
+              line_valid(to_integer(req_index)) <= '1';
+              state     <= STATE_REPLAY;
+            end if;
+
+          when STATE_REPLAY =>
+            -- requested word is read from the data RAM in this cycle
+            state              <= STATE_IDLE;
+            ZPUBusOut.mem_busy <= '0';
+
+        end case;
+      end if;
+    end if;
+  end process;
+
+end Behavioral;
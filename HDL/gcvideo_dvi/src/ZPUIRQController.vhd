@@ -52,54 +52,79 @@ architecture Behavioral of ZPUIRQController is
   signal enable_bits  : std_logic_vector(Devices-1 downto 0) := (others => '0');
   signal global_enable: std_logic := '0';
   signal temp_disable : std_logic := '0';
+  signal wait_active  : std_logic := '0';
 begin
 
-  ZPUBusOut.mem_busy <= '0';
+  -- reading the wait register stalls the CPU until an interrupt is pending
+  ZPUBusOut.mem_busy <= wait_active;
 
   process(Clock)
     variable i      : natural range 0 to Devices-1;
     variable any_int: std_logic;
+    variable pending: std_logic;
   begin
     if rising_edge(Clock) then
+      -- check for pending interrupts, ignoring the (temp-)disable bits
+      pending := '0';
+      for i in 0 to Devices-1 loop
+        pending := pending or (DevIRQs(i) and enable_bits(i));
+      end loop;
+
       -- reset
       if ZPUBusIn.Reset = '1' then
         global_enable <= '0';
         temp_disable  <= '0';
+        wait_active   <= '0';
         IRQOut        <= '0';
       else
+        -- end of wait
+        if wait_active = '1' and pending = '1' then
+          wait_active <= '0';
+        end if;
+
         -- bus access
         if ZSelect = '1' then
           if ZPUBusIn.mem_writeEnable = '1' then
             -- ignore byte/halfword writes
             if ZPUBusIn.mem_bEnable = '0' and
                ZPUBusIn.mem_hEnable = '0' then
-              if ZPUBusIn.mem_addr(2) = '0' then
-                -- write interrupt enable bits
-                enable_bits   <= ZPUBusIn.mem_write(Devices-1 downto 0);
-                global_enable <= ZPUBusIn.mem_write(31);
-              else
-                -- write temp-disable bit
-                temp_disable  <= ZPUBusIn.mem_write(0);
-              end if;
+              case ZPUBusIn.mem_addr(3 downto 2) is
+                when "00" =>
+                  -- write interrupt enable bits
+                  enable_bits   <= ZPUBusIn.mem_write(Devices-1 downto 0);
+                  global_enable <= ZPUBusIn.mem_write(31);
+
+                when "01" =>
+                  -- write temp-disable bit
+                  temp_disable  <= ZPUBusIn.mem_write(0);
+
+                when others => null;
+              end case;
             end if;
 
           elsif ZPUBusIn.mem_readEnable = '1' then
             ZPUBusOut.mem_read <= (others => '0');
 
-            if ZPUBusIn.mem_addr(2) = '0' then
-              -- read currently active interrupts
+            case ZPUBusIn.mem_addr(3 downto 2) is
+              when "00" =>
+                -- read currently active interrupts
 
-              any_int := '0';
-              for i in 0 to Devices-1 loop
-                ZPUBusOut.mem_read(i) <= DevIRQs(i) and enable_bits(i);
-                any_int               := any_int or (DevIRQs(i) and enable_bits(i));
-              end loop;
+                any_int := '0';
+                for i in 0 to Devices-1 loop
+                  ZPUBusOut.mem_read(i) <= DevIRQs(i) and enable_bits(i);
+                  any_int               := any_int or (DevIRQs(i) and enable_bits(i));
+                end loop;
 
-              ZPUBusOut.mem_read(31) <= any_int;
-            else
-              -- read temp-disable bit
-              ZPUBusOut.mem_read(0) <= temp_disable;
-            end if;
+                ZPUBusOut.mem_read(31) <= any_int;
+
+              when "01" =>
+                -- read temp-disable bit
+                ZPUBusOut.mem_read(0) <= temp_disable;
+
+              when others =>
+                -- wait for interrupt, result always reads as zero
+                wait_active <= '1';
+            end case;
 
           end if;
         end if;
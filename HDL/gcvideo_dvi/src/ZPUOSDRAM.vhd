@@ -0,0 +1,282 @@
+----------------------------------------------------------------------------------
+-- GCVideo DVI HDL
+-- Copyright (C) 2014-2021, Ingo Korb <ingo@akana.de>
+-- All rights reserved.
+--
+-- Redistribution and use in source and binary forms, with or without
+-- modification, are permitted provided that the following conditions are met:
+--
+-- 1. Redistributions of source code must retain the above copyright notice,
+--    this list of conditions and the following disclaimer.
+-- 2. Redistributions in binary form must reproduce the above copyright notice,
+--    this list of conditions and the following disclaimer in the documentation
+--    and/or other materials provided with the distribution.
+--
+-- THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+-- AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+-- IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+-- ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+-- LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+-- CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+-- SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+-- INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+-- CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+-- ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+-- THE POSSIBILITY OF SUCH DAMAGE.
+--
+-- ZPUOSDRAM.vhd: OSD character RAM with a rectangle fill/copy blitter
+--
+-- The RAM and the blitter registers use separate selects, but share the
+-- bus output. While the blitter is running, any CPU access to either of
+-- them is held until it has finished, so software never needs to poll.
+-- Copies always run forward, overlapping areas only work if the source
+-- is behind the destination.
+--
+----------------------------------------------------------------------------------
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use IEEE.NUMERIC_STD.ALL;
+
+use work.ZPUDevices.all;
+
+entity ZPUOSDRAM is
+  generic (
+    LineLength: natural := 45
+  );
+  port (
+    Clock     : in  std_logic;
+    RAMSelect : in  std_logic;
+    BlitSelect: in  std_logic;
+    ZPUBusIn  : in  ZPUDeviceIn;
+    ZPUBusOut : out ZPUDeviceOut;
+    RAMAddr   : in  std_logic_vector(10 downto 0);
+    RAMData   : out std_logic_vector(8 downto 0)
+  );
+end ZPUOSDRAM;
+
+architecture Behavioral of ZPUOSDRAM is
+  constant OP_FILL: std_logic_vector(1 downto 0) := "00";
+  constant OP_COPY: std_logic_vector(1 downto 0) := "01";
+  constant OP_OR  : std_logic_vector(1 downto 0) := "10";
+  constant OP_AND : std_logic_vector(1 downto 0) := "11";
+
+  type ram_type   is array(0 to 2047) of std_logic_vector(8 downto 0);
+  type blit_state is (BLIT_IDLE, BLIT_READ, BLIT_WAIT, BLIT_WRITE);
+
+  signal ram        : ram_type := (others => (others => '0'));
+
+  -- RAM port A, shared between CPU and blitter
+  signal a_addr     : unsigned(10 downto 0) := (others => '0');
+  signal a_we       : std_logic := '0';
+  signal a_din      : std_logic_vector(8 downto 0);
+  signal a_q        : std_logic_vector(8 downto 0);
+
+  signal out_ram    : boolean := false;
+  signal read_wait  : boolean := false;
+
+  -- CPU access that arrived while the blitter was busy
+  signal pend_valid : boolean := false;
+  signal pend_ram   : boolean;
+  signal pend_write : boolean;
+  signal pend_addr  : unsigned(10 downto 0);
+  signal pend_data  : std_logic_vector(31 downto 0);
+
+  -- blitter registers
+  signal blit_dest  : unsigned(10 downto 0) := (others => '0');
+  signal blit_src   : unsigned(10 downto 0) := (others => '0');
+  signal blit_width : unsigned(5 downto 0)  := (others => '0');
+  signal blit_height: unsigned(5 downto 0)  := (others => '0');
+  signal blit_value : std_logic_vector(8 downto 0) := (others => '0');
+  signal blit_op    : std_logic_vector(1 downto 0) := OP_FILL;
+
+  -- blitter state
+  signal state      : blit_state := BLIT_IDLE;
+  signal cur_dest   : unsigned(10 downto 0);
+  signal cur_src    : unsigned(10 downto 0);
+  signal row_dest   : unsigned(10 downto 0);
+  signal row_src    : unsigned(10 downto 0);
+  signal x_left     : unsigned(5 downto 0);
+  signal y_left     : unsigned(5 downto 0);
+
+begin
+
+  ZPUBusOut.mem_read(31 downto 9) <= (others => '0');
+  ZPUBusOut.mem_read(8 downto 0)  <= a_q when out_ram else (others => '0');
+
+  -- dual-ported RAM
+  process(Clock)
+  begin
+    if rising_edge(Clock) then
+      if a_we = '1' then
+        ram(to_integer(a_addr)) <= a_din;
+      end if;
+
+      a_q     <= ram(to_integer(a_addr));
+      RAMData <= ram(to_integer(unsigned(RAMAddr)));
+    end if;
+  end process;
+
+  process(Clock)
+    variable acc_valid: boolean;
+    variable acc_ram  : boolean;
+    variable acc_write: boolean;
+    variable acc_addr : unsigned(10 downto 0);
+    variable acc_data : std_logic_vector(31 downto 0);
+    variable next_cell: blit_state;
+  begin
+    if rising_edge(Clock) then
+      a_we <= '0';
+
+      if ZPUBusIn.Reset = '1' then
+        state              <= BLIT_IDLE;
+        pend_valid         <= false;
+        read_wait          <= false;
+        ZPUBusOut.mem_busy <= '0';
+      else
+        ---- CPU interface
+        acc_valid := false;
+        acc_ram   := RAMSelect = '1';
+        acc_write := ZPUBusIn.mem_writeEnable = '1';
+        acc_addr  := unsigned(ZPUBusIn.mem_addr(12 downto 2));
+        acc_data  := ZPUBusIn.mem_write;
+
+        if (RAMSelect = '1' or BlitSelect = '1') and
+           (ZPUBusIn.mem_readEnable = '1' or ZPUBusIn.mem_writeEnable = '1') then
+          if state /= BLIT_IDLE then
+            -- hold the CPU until the blitter is done
+            pend_valid         <= true;
+            pend_ram           <= acc_ram;
+            pend_write         <= acc_write;
+            pend_addr          <= acc_addr;
+            pend_data          <= acc_data;
+            ZPUBusOut.mem_busy <= '1';
+          else
+            acc_valid := true;
+          end if;
+
+        elsif pend_valid and state = BLIT_IDLE then
+          acc_valid  := true;
+          acc_ram    := pend_ram;
+          acc_write  := pend_write;
+          acc_addr   := pend_addr;
+          acc_data   := pend_data;
+          pend_valid <= false;
+        end if;
+
+        if read_wait then
+          -- RAM read completes in this cycle
+          read_wait          <= false;
+          ZPUBusOut.mem_busy <= '0';
+        end if;
+
+        if acc_valid then
+          out_ram <= acc_ram;
+
+          if acc_ram then
+            a_addr <= acc_addr;
+            a_din  <= acc_data(8 downto 0);
+
+            if acc_write then
+              a_we               <= '1';
+              ZPUBusOut.mem_busy <= '0';
+            else
+              read_wait          <= true;
+              ZPUBusOut.mem_busy <= '1';
+            end if;
+
+          else
+            -- blitter registers, reads return 0
+            ZPUBusOut.mem_busy <= '0';
+
+            if acc_write then
+              case acc_addr(2 downto 0) is
+                when "000" => blit_dest  <= unsigned(acc_data(10 downto 0));
+                when "001" => blit_src   <= unsigned(acc_data(10 downto 0));
+
+                when "010" =>
+                  blit_width  <= unsigned(acc_data(5 downto 0));
+                  blit_height <= unsigned(acc_data(13 downto 8));
+
+                when "011" => blit_value <= acc_data(8 downto 0);
+
+                when "100" =>
+                  -- start an operation
+                  blit_op  <= acc_data(1 downto 0);
+                  cur_dest <= blit_dest;
+                  row_dest <= blit_dest;
+                  cur_src  <= blit_src;
+                  row_src  <= blit_src;
+                  x_left   <= blit_width;
+                  y_left   <= blit_height;
+
+                  if blit_width /= 0 and blit_height /= 0 then
+                    if acc_data(1 downto 0) = OP_FILL then
+                      state <= BLIT_WRITE;
+                    else
+                      state <= BLIT_READ;
+                    end if;
+                  end if;
+
+                when others => null;
+              end case;
+            end if;
+          end if;
+        end if;
+
+        ---- blitter
+        if blit_op = OP_FILL then
+          next_cell := BLIT_WRITE;
+        else
+          next_cell := BLIT_READ;
+        end if;
+
+        case state is
+          when BLIT_IDLE =>
+            null;
+
+          when BLIT_READ =>
+            if blit_op = OP_COPY then
+              a_addr <= cur_src;
+            else
+              a_addr <= cur_dest;
+            end if;
+            state <= BLIT_WAIT;
+
+          when BLIT_WAIT =>
+            -- a_q is valid after this cycle
+            state <= BLIT_WRITE;
+
+          when BLIT_WRITE =>
+            a_addr <= cur_dest;
+            a_we   <= '1';
+
+            case blit_op is
+              when OP_FILL => a_din <= blit_value;
+              when OP_COPY => a_din <= a_q;
+              when OP_OR   => a_din <= a_q or  blit_value;
+              when others  => a_din <= a_q and blit_value;
+            end case;
+
+            if x_left /= 1 then
+              x_left   <= x_left - 1;
+              cur_dest <= cur_dest + 1;
+              cur_src  <= cur_src + 1;
+              state    <= next_cell;
+            elsif y_left /= 1 then
+              x_left   <= blit_width;
+              y_left   <= y_left - 1;
+              row_dest <= row_dest + LineLength;
+              cur_dest <= row_dest + LineLength;
+              row_src  <= row_src  + LineLength;
+              cur_src  <= row_src  + LineLength;
+              state    <= next_cell;
+            else
+              state    <= BLIT_IDLE;
+            end if;
+        end case;
+      end if;
+    end if;
+  end process;
+
+end Behavioral;
@@ -47,6 +47,7 @@ entity ZPUVideoInterface is
     ZPUBusIn        : in  ZPUDeviceIn;
     ZPUBusOut       : out ZPUDeviceOut;
     IRQ             : out std_logic;
+    ModeIRQ         : out std_logic;
     VSettings       : out VideoSettings_t;
     VMeasure        : in  VideoMeasurements_t;
     OSDSettings     : out OSDSettings_t
@@ -54,9 +55,64 @@ entity ZPUVideoInterface is
 end ZPUVideoInterface;
 
 architecture Behavioral of ZPUVideoInterface is
-  -- no cable detect
-  --                                                765432109876543210
-  constant VidSettingsDefault: std_logic_vector := "000000000000000000";
+  -- video mode numbers, must match video_mode_t in the firmware
+  subtype VideoMode_t is std_logic_vector(2 downto 0);
+  constant VIDMODE_240p       : VideoMode_t := "000";
+  constant VIDMODE_288p       : VideoMode_t := "001";
+  constant VIDMODE_480i       : VideoMode_t := "010";
+  constant VIDMODE_576i       : VideoMode_t := "011";
+  constant VIDMODE_480p       : VideoMode_t := "100";
+  constant VIDMODE_576p       : VideoMode_t := "101";
+  constant VIDMODE_NONSTANDARD: VideoMode_t := "110";
+
+  -- classify a video mode from its flags (31kHz, PAL, progressive) and line count
+  function classify_mode(flags      : std_logic_vector(2 downto 0);
+                         lines      : natural;
+                         crop486    : boolean;
+                         linedoubled: boolean) return VideoMode_t is
+    variable yres     : natural;
+    variable max_lines: natural;
+  begin
+    yres := lines;
+
+    -- GBI 486i/p to 480i/p crop
+    if crop486 then
+      if yres = 486 then
+        yres := 480;
+      elsif yres = 243 then
+        yres := 240;
+      end if;
+    end if;
+
+    -- maximum number of lines based on mode flags
+    if flags(1) = '1' then
+      max_lines := 288;
+    else
+      max_lines := 240;
+    end if;
+
+    if flags(2) = '1' or linedoubled then
+      max_lines := max_lines * 2;
+    end if;
+
+    if yres > max_lines then
+      return VIDMODE_NONSTANDARD;
+    end if;
+
+    case flags is
+      when "000"  => return VIDMODE_480i;
+      when "001"  => return VIDMODE_240p;
+      when "010"  => return VIDMODE_576i;
+      when "011"  => return VIDMODE_288p;
+      when "100"  => return VIDMODE_480p; -- technically 960i
+      when "101"  => return VIDMODE_480p;
+      when others => return VIDMODE_576p; -- includes 1152i
+    end case;
+  end function;
+
+  -- no cable detect, 2x line multiplier
+  --                                                98765432109876543210
+  constant VidSettingsDefault: std_logic_vector := "00000000000000000000";
 
   -- output disabled, colors don't matter
   constant OSDBGSettingsDefault: std_logic_vector := "1------------------------";
@@ -71,13 +127,34 @@ architecture Behavioral of ZPUVideoInterface is
   signal active_line       : boolean;
   signal active_line_count : natural range 0 to 7;
   signal volume_setting    : std_logic_vector( 7 downto 0) := x"ff";
-  signal vid_settings      : std_logic_vector(17 downto 0) := VidSettingsDefault;
+  signal vid_settings      : std_logic_vector(19 downto 0) := VidSettingsDefault;
   signal osd_bgsettings    : std_logic_vector(24 downto 0) := OSDBGSettingsDefault;
   signal color_matrix      : ColorMatrix_t;
+  signal infoframe_set     : std_logic_vector(2 downto 0) := "001";
   signal reblanker_settings: ReblankerSettings_t;
 
+  -- shadow copies, transferred to the active registers at the next VSync
+  -- after a commit request to avoid showing partially-updated settings
+  signal shadow_matrix     : ColorMatrix_t;
+  signal shadow_reblanker  : ReblankerSettings_t;
+  signal commit_pending    : boolean := false;
+
+  -- video mode classifier
+  signal crop_486          : boolean := false;
+  signal classify_now      : boolean := false;
+  signal mode_in           : VideoMode_t := VIDMODE_NONSTANDARD;
+  signal mode_out          : VideoMode_t := VIDMODE_NONSTANDARD;
+
   signal stored_flags_in   : std_logic_vector(3 downto 0);
   signal stored_flags_ld   : std_logic_vector(2 downto 0);
+  signal max_vtotal        : VerticalPixels;
+
+  -- longest output field in pixels, 576i has 312.5 lines per field and
+  -- an odd line multiplier rounds the half line down in one field and
+  -- up in the other (checked by codegens/check-vtotal.pl)
+  constant MaxVTotal2x: natural :=  625 * 864;
+  constant MaxVTotal3x: natural :=  938 * 864;
+  constant MaxVTotal4x: natural := 1250 * 864;
   signal console_mode      : std_logic;
   signal force_ypbpr       : std_logic;
 begin
@@ -102,7 +179,11 @@ begin
   VSettings.InterpolateChroma  <= (vid_settings(13) = '1');
   -- bit 14 is the feature override bit set in non-standard modes
   VSettings.ColorMode          <= vid_settings(16 downto 15);
+  VSettings.InfoFrameSet       <= unsigned(infoframe_set);
   VSettings.RebuildCSync       <= (vid_settings(17) = '1' and vid_settings(14) = '0');
+  VSettings.LineMultiplier     <= 4 when vid_settings(19) = '1' else
+                                  3 when vid_settings(18) = '1' else
+                                  2;
   VSettings.Volume             <= unsigned(volume_setting);
   VSettings.Matrix             <= color_matrix;
   VSettings.RBSettings         <= reblanker_settings;
@@ -115,7 +196,14 @@ begin
   OSDSettings.BGTintCb <=   signed(osd_bgsettings(15 downto  8));
   OSDSettings.BGTintCr <=   signed(osd_bgsettings( 7 downto  0));
 
+  -- output frame size limit, scaled for 3x/4x line multiplied 15kHz modes
+  max_vtotal <= MaxVTotal4x when vid_settings(4) = '1' and vid_settings(19) = '1' and stored_flags_in(2) = '0' else
+                MaxVTotal3x when vid_settings(4) = '1' and vid_settings(18) = '1' and stored_flags_in(2) = '0' else
+                MaxVTotal2x;
+
   process(Clock)
+    variable new_mode_in : VideoMode_t;
+    variable new_mode_out: VideoMode_t;
   begin
     if rising_edge(Clock) then
       ---- ZPU bus interface
@@ -125,6 +213,10 @@ begin
         vid_settings    <= VidSettingsDefault;
         osd_bgsettings  <= OSDBGSettingsDefault;
         volume_setting  <= x"ff";
+        infoframe_set   <= "001";
+        commit_pending  <= false;
+        crop_486        <= false;
+        ModeIRQ         <= '0';
       end if;
 
       -- reset interrupt flag on any write
@@ -133,77 +225,120 @@ begin
       end if;
 
       -- read path
-      case ZPUBusIn.mem_addr(5 downto 2) is
-        when "0000" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(pixel_counter, 32));
-        when "0001" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(line_counter,  32));
-
-        when "0010" => ZPUBusOut.mem_read             <= (others => '0');
-                       ZPUBusOut.mem_read(8 downto 6) <= stored_flags_ld;
-                       ZPUBusOut.mem_read(5)          <= stored_flags_in(3);
-                       ZPUBusOut.mem_read(4)          <= force_ypbpr;
-                       ZPUBusOut.mem_read(3)          <= console_mode;
-                       ZPUBusOut.mem_read(2 downto 0) <= stored_flags_in(2 downto 0);
-
-        when "0011" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(VMeasure.HTotal, 32));
-        when "0100" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(VMeasure.HActiveStart, 32));
-        when "0101" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(VMeasure.VTotal, 32));
-
-        when "0110" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(VMeasure.VActiveStart0, 32));
-        when "0111" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(VMeasure.VHOffset0, 32));
-        when "1000" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(VMeasure.VActiveStart1, 32));
-        when "1001" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(VMeasure.VHOffset1, 32));
+      case ZPUBusIn.mem_addr(6 downto 2) is
+        when "00000" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(pixel_counter, 32));
+        when "00001" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(line_counter,  32));
+
+        when "00010" => ZPUBusOut.mem_read             <= (others => '0');
+                        if commit_pending then
+                          ZPUBusOut.mem_read(9)        <= '1';
+                        end if;
+                        ZPUBusOut.mem_read(8 downto 6) <= stored_flags_ld;
+                        ZPUBusOut.mem_read(5)          <= stored_flags_in(3);
+                        ZPUBusOut.mem_read(4)          <= force_ypbpr;
+                        ZPUBusOut.mem_read(3)          <= console_mode;
+                        ZPUBusOut.mem_read(2 downto 0) <= stored_flags_in(2 downto 0);
+
+        when "00011" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(VMeasure.HTotal, 32));
+        when "00100" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(VMeasure.HActiveStart, 32));
+        when "00101" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(VMeasure.VTotal, 32));
+
+        when "00110" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(VMeasure.VActiveStart0, 32));
+        when "00111" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(VMeasure.VHOffset0, 32));
+        when "01000" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(VMeasure.VActiveStart1, 32));
+        when "01001" => ZPUBusOut.mem_read <= std_logic_vector(to_unsigned(VMeasure.VHOffset1, 32));
+
+        when "01010" => ZPUBusOut.mem_read             <= (others => '0');
+                        ZPUBusOut.mem_read(6 downto 4) <= mode_out;
+                        ZPUBusOut.mem_read(2 downto 0) <= mode_in;
 
         when others => ZPUBusOut.mem_read <= (others => '-');  -- undefined
       end case;
 
       -- write path
       if ZSelect = '1' and ZPUBusIn.mem_writeEnable = '1' then
-        case ZPUBusIn.mem_addr(5 downto 2) is
-          when "0000" => vid_settings   <= ZPUBusIn.mem_write(17 downto 0);
-          when "0001" => osd_bgsettings <= ZPUBusIn.mem_write(24 downto 0);
-          when "0010" => volume_setting <= ZPUBusIn.mem_write( 7 downto 0);
-
-          when "0011" =>
-            color_matrix.YBias     <= signed(ZPUBusIn.mem_write( 9 downto  0));
-            color_matrix.YRFactor  <= signed(ZPUBusIn.mem_write(31 downto 16));
-          when "0100" =>
-            color_matrix.YGFactor  <= signed(ZPUBusIn.mem_write(15 downto  0));
-            color_matrix.YBFactor  <= signed(ZPUBusIn.mem_write(31 downto 16));
-          when "0101" =>
-            color_matrix.CbGFactor <= signed(ZPUBusIn.mem_write(15 downto  0));
-            color_matrix.CbBFactor <= signed(ZPUBusIn.mem_write(31 downto 16));
-          when "0110" =>
-            color_matrix.CrRFactor <= signed(ZPUBusIn.mem_write(15 downto  0));
-            color_matrix.CrGFactor <= signed(ZPUBusIn.mem_write(31 downto 16));
-
-          when "0111" =>
-            reblanker_settings.HSyncStart <= to_integer(unsigned(ZPUBusIn.mem_write(15 downto 0)));
-            reblanker_settings.HSyncEnd   <= to_integer(unsigned(ZPUBusIn.mem_write(31 downto 16)));
-
-          when "1000" =>
-            reblanker_settings.HActiveStart <= to_integer(unsigned(ZPUBusIn.mem_write(15 downto 0)));
-            reblanker_settings.HActiveEnd   <= to_integer(unsigned(ZPUBusIn.mem_write(31 downto 16)));
-
-          when "1001" =>
-            reblanker_settings.VSyncStart <= to_integer(unsigned(ZPUBusIn.mem_write(19 downto 0)));
-
-          when "1010" =>
-            reblanker_settings.VSyncEnd   <= to_integer(unsigned(ZPUBusIn.mem_write(19 downto 0)));
-
-          when "1011" =>
-            reblanker_settings.VActiveStart <= to_integer(unsigned(ZPUBusIn.mem_write(9 downto 0)));
-
-          when "1100" =>
-            reblanker_settings.VActiveLines <= to_integer(unsigned(ZPUBusIn.mem_write(9 downto 0)));
+        case ZPUBusIn.mem_addr(6 downto 2) is
+          when "00000" => vid_settings   <= ZPUBusIn.mem_write(19 downto 0);
+          when "00001" => osd_bgsettings <= ZPUBusIn.mem_write(24 downto 0);
+          when "00010" => volume_setting <= ZPUBusIn.mem_write( 7 downto 0);
+
+          when "00011" =>
+            shadow_matrix.YBias     <= signed(ZPUBusIn.mem_write( 9 downto  0));
+            shadow_matrix.YRFactor  <= signed(ZPUBusIn.mem_write(31 downto 16));
+          when "00100" =>
+            shadow_matrix.YGFactor  <= signed(ZPUBusIn.mem_write(15 downto  0));
+            shadow_matrix.YBFactor  <= signed(ZPUBusIn.mem_write(31 downto 16));
+          when "00101" =>
+            shadow_matrix.CbGFactor <= signed(ZPUBusIn.mem_write(15 downto  0));
+            shadow_matrix.CbBFactor <= signed(ZPUBusIn.mem_write(31 downto 16));
+          when "00110" =>
+            shadow_matrix.CrRFactor <= signed(ZPUBusIn.mem_write(15 downto  0));
+            shadow_matrix.CrGFactor <= signed(ZPUBusIn.mem_write(31 downto 16));
+
+          when "00111" =>
+            shadow_reblanker.HSyncStart <= to_integer(unsigned(ZPUBusIn.mem_write(15 downto 0)));
+            shadow_reblanker.HSyncEnd   <= to_integer(unsigned(ZPUBusIn.mem_write(31 downto 16)));
+
+          when "01000" =>
+            shadow_reblanker.HActiveStart <= to_integer(unsigned(ZPUBusIn.mem_write(15 downto 0)));
+            shadow_reblanker.HActiveEnd   <= to_integer(unsigned(ZPUBusIn.mem_write(31 downto 16)));
+
+          when "01001" =>
+            shadow_reblanker.VSyncStart <= to_integer(unsigned(ZPUBusIn.mem_write(20 downto 0)));
+
+          when "01010" =>
+            shadow_reblanker.VSyncEnd   <= to_integer(unsigned(ZPUBusIn.mem_write(20 downto 0)));
+
+          when "01011" =>
+            shadow_reblanker.VActiveStart <= to_integer(unsigned(ZPUBusIn.mem_write(10 downto 0)));
+
+          when "01100" =>
+            shadow_reblanker.VActiveLines <= to_integer(unsigned(ZPUBusIn.mem_write(10 downto 0)));
 
           -- Note: There must be at least one unused register that is written
           -- to for clearing the IRQ flag!
-          when "1101" => null;
+          when "01101" => null;
+
+          when "01110" => infoframe_set <= ZPUBusIn.mem_write(2 downto 0);
+
+          when "01111" => commit_pending <= true;
+
+          when "10000" => crop_486 <= (ZPUBusIn.mem_write(0) = '1');
 
           when others => null;
         end case;
       end if;
 
+      -- reset mode change interrupt flag when the mode register is read
+      if ZSelect = '1' and ZPUBusIn.mem_readEnable = '1' and
+         ZPUBusIn.mem_addr(6 downto 2) = "01010" then
+        ModeIRQ <= '0';
+      end if;
+
+      ---- classify video modes one cycle after the measurements were updated
+      if classify_now then
+        classify_now <= false;
+
+        if VMeasure.HTotal > 870 or VMeasure.HTotal < 800 or
+           pixel_counter > 720 or VMeasure.VTotal > max_vtotal or
+           line_counter > 576 then
+          new_mode_in  := VIDMODE_NONSTANDARD;
+          new_mode_out := VIDMODE_NONSTANDARD;
+        else
+          new_mode_in  := classify_mode(stored_flags_in(2 downto 0), line_counter,
+                                        crop_486, vid_settings(4) = '1');
+          new_mode_out := classify_mode(stored_flags_ld, line_counter,
+                                        crop_486, false);
+        end if;
+
+        if new_mode_in /= mode_in or new_mode_out /= mode_out then
+          ModeIRQ <= '1';
+        end if;
+
+        mode_in  <= new_mode_in;
+        mode_out <= new_mode_out;
+      end if;
+
       ---- update signal measurements
       -- (note: this measures the raw input signal, the BlankingRegen measures
       --        the result of the linedoubler)
@@ -241,6 +376,15 @@ begin
           -- start of VSync, copy remaining measurements
           IRQ <= '1';
 
+          classify_now <= true;
+
+          -- activate shadowed settings
+          if commit_pending then
+            color_matrix       <= shadow_matrix;
+            reblanker_settings <= shadow_reblanker;
+            commit_pending     <= false;
+          end if;
+
           line_counter      <= current_linecount;
           current_linecount <= 0;
           active_line_count <= 0;
@@ -26,6 +26,18 @@
 --
 -- ZPU_SPI.vhd: SPI and ICAP interface for ZPU
 --
+-- The SPI part also contains a small DMA engine that moves up to 256
+-- bytes between its own buffer RAM and the flash chip: It selects the
+-- flash, sends a command byte and a 24 bit address and then streams the
+-- data without stalling the CPU. The buffer has a separate select and
+-- only supports word accesses, its bytes are stored big-endian. While
+-- the engine is running, the other SPI registers must not be written
+-- and the DMAActive output holds off the flash cache.
+--
+-- Software sets the flash busy flag while an erase or program operation
+-- may be running, the FlashBusy output tells the flash cache to wait for
+-- its completion before reading.
+--
 ----------------------------------------------------------------------------------
 
 library IEEE;
@@ -45,8 +57,12 @@ entity ZPU_SPI is
   port (
     Clock    : in  std_logic;
     ZSelect  : in  std_logic; -- ZPU peripheral select
+    BufSelect: in  std_logic; -- DMA buffer select
     ZPUBusIn : in  ZPUDeviceIn;
     ZPUBusOut: out ZPUDeviceOut;
+    IRQ      : out std_logic; -- DMA transfer finished
+    DMAActive: out std_logic; -- DMA engine owns the SPI bus
+    FlashBusy: out std_logic; -- flash may be erasing or programming
     SCOPI    : out std_logic; -- SPI controller out, peripheral in
     SCIPO    : in  std_logic; -- SPI controller in, peripheral out
     SClock   : out std_logic; -- SPI clock
@@ -55,12 +71,16 @@ entity ZPU_SPI is
 end ZPU_SPI;
 
 architecture Behavioral of ZPU_SPI is
+  type dma_state_t  is (DMA_IDLE, DMA_HEADER, DMA_DATA, DMA_STORE);
+  type dma_buffer_t is array(0 to 63) of std_logic_vector(31 downto 0);
+
   signal spi_clockcounter: natural range 0 to SPIClockDiv-1 := 0;
   signal spi_clock       : std_logic                        := '1';
   signal spi_sel         : std_logic                        := '1';
   signal spi_data        : std_logic_vector(31 downto 0)    := (others => '0');
   signal spi_state       : natural range 0 to 32+1          := 0;
   signal spi_active      : boolean                          := false;
+  signal flash_busy      : std_logic                        := '0';
 
   signal crc_datain      : std_logic;
   signal crc_dataenable  : boolean := false;
@@ -74,11 +94,39 @@ architecture Behavioral of ZPU_SPI is
   signal icap_write: std_logic := '0';
   signal icap_busy : std_logic;
 
+  signal reg_q     : std_logic_vector(31 downto 0) := (others => '0');
+  signal read_buf  : boolean := false;
+
+  -- DMA buffer, port A is shared between CPU and DMA writes
+  signal dma_buffer: dma_buffer_t;
+  signal cpu_buf   : boolean;
+  signal buf_addr  : unsigned(5 downto 0);
+  signal buf_we    : std_logic;
+  signal buf_din   : std_logic_vector(31 downto 0);
+  signal buf_q     : std_logic_vector(31 downto 0);
+  signal buf_q_dma : std_logic_vector(31 downto 0);
+
+  -- DMA engine
+  signal dma_state  : dma_state_t := DMA_IDLE;
+  signal dma_command: std_logic_vector(31 downto 0) := (others => '0');
+  signal dma_write  : boolean := false;
+  signal dma_remain : unsigned(8 downto 0) := (others => '0');
+  signal dma_bytes  : natural range 1 to 4 := 4;
+  signal dma_word   : unsigned(5 downto 0) := (others => '0');
+  signal dma_rxword : std_logic_vector(31 downto 0);
+  signal dma_done   : std_logic := '0';
+
 begin
   SSelect <= spi_sel;
   SClock  <= spi_clock;
 
-  ZPUBusOut.mem_busy <= '1' when spi_active else '0'; -- hold CPU while busy
+  -- hold CPU while a byte/word it started is being sent
+  ZPUBusOut.mem_busy <= '1' when spi_active and dma_state = DMA_IDLE else '0';
+  ZPUBusOut.mem_read <= buf_q when read_buf else reg_q;
+
+  IRQ       <= dma_done;
+  DMAActive <= '0' when dma_state = DMA_IDLE else '1';
+  FlashBusy <= flash_busy;
 
   crc32_inst: crc32
     port map (
@@ -99,7 +147,71 @@ begin
       WRITE => not icap_write -- active-low input
     );
 
+  -- DMA buffer, CPU accesses always win over the DMA engine
+  cpu_buf <= BufSelect = '1' and
+             (ZPUBusIn.mem_readEnable = '1' or ZPUBusIn.mem_writeEnable = '1');
+
+  buf_addr <= unsigned(ZPUBusIn.mem_addr(7 downto 2)) when cpu_buf else dma_word;
+  buf_din  <= ZPUBusIn.mem_write when cpu_buf else dma_rxword;
+  buf_we   <= '1' when cpu_buf and ZPUBusIn.mem_writeEnable = '1' and
+                       ZPUBusIn.mem_bEnable = '0' and ZPUBusIn.mem_hEnable = '0' else
+              '1' when not cpu_buf and dma_state = DMA_STORE else
+              '0';
+
+  process(Clock)
+  begin
+    if rising_edge(Clock) then
+      if buf_we = '1' then
+        dma_buffer(to_integer(buf_addr)) <= buf_din;
+      end if;
+
+      if cpu_buf and ZPUBusIn.mem_readEnable = '1' then
+        buf_q <= dma_buffer(to_integer(buf_addr));
+      end if;
+
+      buf_q_dma <= dma_buffer(to_integer(dma_word));
+    end if;
+  end process;
+
   process(Clock)
+    -- start shifting out the top bits of data
+    procedure start_shift(data: std_logic_vector(31 downto 0); bits: natural) is
+    begin
+      spi_data         <= data;
+      spi_state        <= 32 - bits;
+      spi_active       <= true;
+      SCOPI            <= data(31); -- output first bit immediately
+      spi_clockcounter <= SPIClockDiv - 1;
+    end procedure;
+
+    -- transfer the next buffer word or finish the DMA operation
+    procedure dma_next is
+      variable bytes: natural range 1 to 4;
+    begin
+      if dma_remain = 0 then
+        spi_sel   <= '1';
+        dma_done  <= '1';
+        dma_state <= DMA_IDLE;
+      else
+        if dma_remain >= 4 then
+          bytes := 4;
+        else
+          bytes := to_integer(dma_remain(1 downto 0));
+        end if;
+
+        dma_bytes  <= bytes;
+        dma_remain <= dma_remain - bytes;
+        dma_state  <= DMA_DATA;
+
+        if dma_write then
+          start_shift(buf_q_dma, 8 * bytes);
+          dma_word <= dma_word + 1;
+        else
+          start_shift(x"ffffffff", 8 * bytes);
+        end if;
+      end if;
+    end procedure;
+
   begin
     if rising_edge(Clock) then
       if ZPUBusIn.Reset = '1' then
@@ -110,38 +222,62 @@ begin
         spi_clock        <= '1';
         spi_clockcounter <= 0;
         spi_data         <= (others => '0');
+        flash_busy       <= '0';
         crc_reset        <= true;
         crc_dataenable   <= false;
+        dma_state        <= DMA_IDLE;
+        dma_done         <= '0';
       else
         crc_reset      <= false;
         crc_dataenable <= false;
 
+        if cpu_buf then
+          read_buf <= true;
+        end if;
+
         -- ZPU interface
         if ZSelect = '1' then
+          read_buf <= false;
+
           if ZPUBusIn.mem_writeEnable = '1' then
             -- write access
             case ZPUBusIn.mem_addr(4 downto 2) is
               -- SPI
               when "000" =>
-                spi_data(31 downto 24) <= ZPUBusIn.mem_write(7 downto 0);
-                spi_state              <= 24;
-                spi_active             <= true;
-                SCOPI                  <= ZPUBusIn.mem_write(7); -- output first bit immediately
-                spi_clockcounter       <= SPIClockDiv - 1;
+                if dma_state = DMA_IDLE then
+                  start_shift(ZPUBusIn.mem_write(7 downto 0) & x"000000", 8);
+                end if;
 
               when "011" =>
-                spi_data         <= ZPUBusIn.mem_write;
-                spi_state        <= 0;
-                spi_active       <= true;
-                SCOPI            <= ZPUBusIn.mem_write(31); -- output first bit immediately
-                spi_clockcounter <= SPIClockDiv - 1;
+                if dma_state = DMA_IDLE then
+                  start_shift(ZPUBusIn.mem_write, 32);
+                end if;
 
               when "001" =>
-                spi_sel <= ZPUBusIn.mem_write(0);
+                if dma_state = DMA_IDLE then
+                  spi_sel <= ZPUBusIn.mem_write(0);
+                end if;
+                flash_busy <= ZPUBusIn.mem_write(2);
 
               when "010" =>
                 crc_reset <= true;
 
+              -- DMA
+              when "110" =>
+                dma_command <= ZPUBusIn.mem_write;
+
+              when "111" =>
+                if dma_state = DMA_IDLE and
+                   unsigned(ZPUBusIn.mem_write(8 downto 0)) /= 0 then
+                  dma_remain <= unsigned(ZPUBusIn.mem_write(8 downto 0));
+                  dma_write  <= ZPUBusIn.mem_write(31) = '1';
+                  dma_word   <= (others => '0');
+                  dma_done   <= '0';
+                  dma_state  <= DMA_HEADER;
+                  spi_sel    <= '0';
+                  start_shift(dma_command, 32);
+                end if;
+
               -- ICAP
               when "100" =>
                 for i in 0 to 7 loop
@@ -158,33 +294,46 @@ begin
 
           else
             -- read access
-            ZPUBusOut.mem_read <= (others => '0');
+            reg_q <= (others => '0');
 
             case ZPUBusIn.mem_addr(4 downto 2) is
               -- SPI
               when "000" =>
-                ZPUBusOut.mem_read(7 downto 0) <= spi_data(7 downto 0);
+                reg_q(7 downto 0) <= spi_data(7 downto 0);
 
               when "011" =>
-                ZPUBusOut.mem_read <= spi_data;
+                reg_q <= spi_data;
 
               when "001" =>
-                ZPUBusOut.mem_read(0) <= spi_sel;
+                reg_q(0) <= spi_sel;
                 if spi_active then
-                  ZPUBusOut.mem_read(1) <= '1';
+                  reg_q(1) <= '1';
                 end if;
+                reg_q(2) <= flash_busy;
 
               when "010" =>
-                ZPUBusOut.mem_read <= crc_value;
+                reg_q <= crc_value;
+
+              -- DMA
+              when "110" =>
+                reg_q <= dma_command;
+
+              when "111" =>
+                -- reading clears the completion flag
+                if dma_state /= DMA_IDLE then
+                  reg_q(0) <= '1';
+                end if;
+                reg_q(1) <= dma_done;
+                dma_done <= '0';
 
               -- ICAP
               when "100" =>
                 for i in 0 to 7 loop
-                  ZPUBusOut.mem_read(i) <= icap_out(7 - i);
+                  reg_q(i) <= icap_out(7 - i);
                 end loop;
 
               when "101" =>
-                ZPUBusOut.mem_read(0) <= icap_busy;
+                reg_q(0) <= icap_busy;
 
               when others => null;
 
@@ -192,6 +341,41 @@ begin
           end if;
         end if;
 
+        -- DMA engine
+        case dma_state is
+          when DMA_IDLE =>
+            null;
+
+          when DMA_HEADER =>
+            -- command and address sent
+            if not spi_active then
+              dma_next;
+            end if;
+
+          when DMA_DATA =>
+            if not spi_active then
+              if dma_write then
+                dma_next;
+              else
+                -- left-align the received bytes
+                case dma_bytes is
+                  when 1      => dma_rxword <= spi_data( 7 downto 0) & x"000000";
+                  when 2      => dma_rxword <= spi_data(15 downto 0) & x"0000";
+                  when 3      => dma_rxword <= spi_data(23 downto 0) & x"00";
+                  when others => dma_rxword <= spi_data;
+                end case;
+                dma_state <= DMA_STORE;
+              end if;
+            end if;
+
+          when DMA_STORE =>
+            -- word is written unless the CPU uses the buffer in this cycle
+            if not cpu_buf then
+              dma_word <= dma_word + 1;
+              dma_next;
+            end if;
+        end case;
+
         -- SPI state machine
         if spi_active = true then
           if spi_clockcounter /= 0 then
@@ -58,6 +58,7 @@ entity audio_spdif is
     Volume     : in  unsigned(7 downto 0);
 
     Audio      : out AudioData;
+    AudioRaw   : out AudioData; -- before volume scaling
 
     SPDIF_Out  : out std_logic
   );
@@ -122,6 +123,11 @@ begin
   Audio.LeftEnable  <= enable_l_dly;
   Audio.RightEnable <= enable_r_dly;
 
+  AudioRaw.Left        <= audio_left_unscaled;
+  AudioRaw.Right       <= audio_right_unscaled;
+  AudioRaw.LeftEnable  <= enable_l;
+  AudioRaw.RightEnable <= enable_r;
+
   -- deglitch I2S signals
   Deglitch_BClock: Deglitcher GENERIC MAP (
     SyncBits    => 3,
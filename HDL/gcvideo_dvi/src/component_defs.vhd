@@ -133,13 +133,15 @@ package component_defs is
 
     -- input video
     Enable            : in  boolean;
+    Factor            : in  natural range 2 to 4;
     VideoIn           : in  VideoY422;
     PixelClockEnable  : in  boolean;
     PixelClockEnable2x: in  boolean;
 
     -- output video
     VideoOut          : out VideoY422;
-    PixelOutEnable    : out boolean
+    PixelOutEnable    : out boolean;
+    FullRate          : out boolean
   );
   end component;
 
@@ -202,14 +204,16 @@ package component_defs is
       clk_n            : in  std_logic;
       clk_pixel        : in  std_logic;
       clk_pixel_en     : in  boolean;
+      FullRate         : in  boolean;
       ConsoleMode      : in  console_mode_t;
       Video            : in  VideoRGB;
       EnhancedMode     : in  boolean;
       Widescreen       : in  boolean;
       ColorMode        : in  std_logic_vector(1 downto 0);
+      InfoFrameSet     : in  unsigned(2 downto 0);
       SampleRateHack   : in  boolean;
       Audio            : in  AudioData;
-      InfoFrameRAM_Addr: out std_logic_vector(8 downto 0);
+      InfoFrameRAM_Addr: out std_logic_vector(10 downto 0);
       InfoFrameRAM_Data: in  std_logic_vector(8 downto 0);
       TMDSWord_Red     : out std_logic_vector(9 downto 0);
       TMDSWord_Green   : out std_logic_vector(9 downto 0);
@@ -227,11 +231,13 @@ package component_defs is
 
   component ClockGen is
     generic (
-      TargetConsole: string  -- "GC" or "WII"
+      TargetConsole: string; -- "GC" or "WII"
+      FullRateModes: boolean
     );
     port (
       ClockIn   : in  std_logic;
       BClock    : in  std_logic;
+      FullRate  : in  boolean;
       Clock54M  : out std_logic;
       ClockAudio: out std_logic;
       DVIClockP : out std_logic;
@@ -283,6 +289,7 @@ package component_defs is
       Volume     : in  unsigned(7 downto 0);
 
       Audio      : out AudioData;
+      AudioRaw   : out AudioData;
 
       SPDIF_Out  : out std_logic
     );
@@ -333,13 +340,14 @@ package component_defs is
       I2S_BClock      : in  std_logic;
       I2S_LRClock     : in  std_logic;
       I2S_Data        : in  std_logic;
+      AudioRaw        : in  AudioData;
       SPI_COPI        : out std_logic;
       SPI_CIPO        : in  std_logic;
       SPI_SCK         : out std_logic;
       SPI_SEL         : out std_logic;
       ScanlineRamAddr : in  std_logic_vector(7 downto 0);
       ScanlineRamData : out std_logic_vector(8 downto 0);
-      InfoFrameRAMAddr: in  std_logic_vector(8 downto 0);
+      InfoFrameRAMAddr: in  std_logic_vector(10 downto 0);
       InfoFrameRAMData: out std_logic_vector(8 downto 0);
       OSDRamAddr      : in  std_logic_vector(10 downto 0);
       OSDRamData      : out std_logic_vector(8 downto 0);
@@ -398,7 +406,8 @@ package component_defs is
     generic (
       TargetConsole: string; -- "GC" or "WII"
       Firmware     : string;
-      Module       : string
+      Module       : string;
+      FullRateModes: boolean
     );
     port (
       -- clocks
@@ -42,7 +42,8 @@ entity Datapipe is
   generic (
     TargetConsole: string; -- "GC" or "WII"
     Firmware     : string;
-    Module       : string  -- "main" or "flasher"
+    Module       : string; -- "main" or "flasher"
+    FullRateModes: boolean -- enables 3x/4x line multiplication
   );
   port (
     -- clocks
@@ -130,6 +131,9 @@ architecture Behavioral of Datapipe is
   signal pixel_clk_en          : boolean; -- base pixel clock from GCDV decoder
   signal pixel_clk_en_2x       : boolean; -- double base pixel clock from GCDV decoder
   signal pixel_clk_en_27       : boolean; -- fixed 27MHz for DVI output, results in pixel-doubling for 15k modes
+  signal pixel_clk_en_dvi      : boolean; -- 27MHz or full 54MHz for 3x/4x line multiplied modes
+  signal dvi_full_rate         : boolean;
+  signal line_multiplier       : natural range 2 to 4;
 
   signal pixel_clk_en_ld_out   : boolean;
   signal pixel_clk_en_422conv  : boolean := false;
@@ -159,6 +163,7 @@ architecture Behavioral of Datapipe is
 
   -- audio
   signal audio          : AudioData;
+  signal audio_raw      : AudioData;
 
   -- console mode detection
   signal console_mode   : console_mode_t := MODE_GC;
@@ -174,6 +179,7 @@ architecture Behavioral of Datapipe is
   signal vs_enhanced_mode : boolean;
   signal vs_widescreen    : boolean;
   signal vs_colormode     : std_logic_vector(1 downto 0);
+  signal vs_infoframeset  : unsigned(2 downto 0);
   signal vs_sampleratehack: boolean;
   signal vs_analogrgbout  : boolean;
   signal vs_rebuildcsync  : boolean;
@@ -185,7 +191,7 @@ architecture Behavioral of Datapipe is
   signal output_422        : boolean;
   signal video_measurements: VideoMeasurements_t;
   signal infoframeram_data : std_logic_vector(8 downto 0);
-  signal infoframeram_addr : std_logic_vector(8 downto 0);
+  signal infoframeram_addr : std_logic_vector(10 downto 0);
 
 begin
 
@@ -241,6 +247,7 @@ begin
     I2S_BClock       => I2S_BClock,
     I2S_LRClock      => I2S_LRClock,
     I2S_Data         => I2S_Data,
+    AudioRaw         => audio_raw,
     SPI_COPI         => Flash_COPI,
     SPI_CIPO         => Flash_CIPO,
     SPI_SCK          => Flash_SCK,
@@ -261,12 +268,14 @@ begin
     clk               => DVIClockP,
     clk_n             => DVIClockN,
     clk_pixel         => Clock54M,
-    clk_pixel_en      => pixel_clk_en_27,
+    clk_pixel_en      => pixel_clk_en_dvi,
+    FullRate          => dvi_full_rate,
     ConsoleMode       => console_mode,
     Video             => video_dvienc_in,
     EnhancedMode      => vs_enhanced_mode,
     Widescreen        => vs_widescreen,
     ColorMode         => vs_colormode,
+    InfoFrameSet      => vs_infoframeset,
     SampleRateHack    => vs_sampleratehack,
     InfoFrameRAM_Addr => infoframeram_addr,
     InfoFrameRAM_Data => infoframeram_data,
@@ -287,11 +296,15 @@ begin
   OBUFDS_blue  : OBUFTDS port map ( O => DVI_Blue(0),  OB => DVI_Blue(1),  I => blue_enc,  T => obuf_oe);
   OBUFDS_clock : OBUFTDS port map ( O => DVI_Clock(0), OB => DVI_Clock(1), I => clock_enc, T => obuf_oe);
 
+  -- 3x/4x need the full rate serializer clock
+  line_multiplier <= video_settings.LineMultiplier when FullRateModes else 2;
+
   vs_main: if Module = "main" generate
     vs_enhanced_mode  <= video_settings.EnhancedMode;
     vs_widescreen     <= video_settings.Widescreen;
     vs_sampleratehack <= video_settings.SampleRateHack;
     vs_colormode      <= video_settings.ColorMode;
+    vs_infoframeset   <= video_settings.InfoFrameSet;
     vs_analogrgbout   <= video_settings.AnalogRGBOutput;
     vs_rebuildcsync   <= video_settings.RebuildCSync;
   end generate;
@@ -301,6 +314,7 @@ begin
     vs_widescreen     <= false;
     vs_sampleratehack <= false;
     vs_colormode      <= "01"; -- RGB limited range
+    vs_infoframeset   <= (others => '0');
     vs_analogrgbout   <= false;
     vs_rebuildcsync   <= false;
   end generate;
@@ -308,10 +322,12 @@ begin
   -- main clock generator
   Inst_ClockGen: ClockGen
     generic map (
-      TargetConsole => TargetConsole
+      TargetConsole => TargetConsole,
+      FullRateModes => FullRateModes
     ) port map (
       ClockIn    => VClockN,
       BClock     => I2S_BClock,
+      FullRate   => dvi_full_rate,
       Clock54M   => Clock54M,
       ClockAudio => ClockAudio,
       DVIClockP  => DVIClockP,
@@ -331,6 +347,7 @@ begin
         I2S_Data    => I2S_Data,
         Volume      => video_settings.Volume,
         Audio       => audio,
+        AudioRaw    => audio_raw,
         SPDIF_Out   => SPDIF_Out
       );
   end generate;
@@ -342,6 +359,7 @@ begin
     audio.Right       <= (others => '0');
     audio.LeftEnable  <= false;
     audio.RightEnable <= false;
+    audio_raw         <= audio;
   end generate;
 
   -- read gamecube video data
@@ -355,16 +373,18 @@ begin
       Video              => video_gcdv_out
     );
 
-  -- linedouble 15kHz modes to 30kHz
+  -- line multiply 15kHz modes to 30kHz or more
   Inst_Linedoubler: Linedoubler
     PORT MAP (
       PixelClock         => Clock54M,
       PixelClockEnable   => pixel_clk_en,
       PixelClockEnable2x => pixel_clk_en_2x,
       Enable             => video_settings.LinedoublerEnabled,
+      Factor             => line_multiplier,
       VideoIn            => video_ld_in,
       VideoOut           => video_ld_out,
-      PixelOutEnable     => pixel_clk_en_ld_out
+      PixelOutEnable     => pixel_clk_en_ld_out,
+      FullRate           => dvi_full_rate
     );
 
   -- interpolate 4:2:2 to 4:4:4
@@ -486,6 +506,9 @@ begin
     end if;
   end process;
 
+  -- 3x/4x modes send every 54MHz cycle, 3x repeats every third pixel
+  pixel_clk_en_dvi <= true when dvi_full_rate else pixel_clk_en_27;
+
   -- generate signals for analog output: DAC Clock
   process(Clock54M)
   begin
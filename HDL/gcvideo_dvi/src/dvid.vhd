@@ -2,7 +2,8 @@
 -- Engineer:      Mike Field <hamster@snap.net.nz>
 -- Description:   Converts VGA signals into DVID bitstreams.
 --
---                'clk' and 'clk_n' should be 5x clk_pixel.
+--                'clk' and 'clk_n' should be 5x the rate of clk_pixel_en,
+--                so their frequency is doubled in full rate mode.
 --
 --                'blank' should be asserted during the non-display
 --                portions of the frame
@@ -11,6 +12,7 @@
 -- - added a pixel clock enable signal
 -- - added optional inversion for all three channels to allow swapped diff pairs
 -- - added enhanced mode with audio and infoframe support
+-- - added a full rate mode for 3x/4x line multiplied video
 -- Original source from http://hamsterworks.co.nz/mediawiki/index.php/Dvid_test
 -------------------------------------------------------------------------------
 library IEEE;
@@ -27,16 +29,18 @@ entity dvid is
            clk_n            : in  STD_LOGIC;
            clk_pixel        : in  STD_LOGIC;
            clk_pixel_en     : in  boolean;
+           FullRate         : in  boolean;
            ConsoleMode      : in  console_mode_t;
            Video            : in  VideoRGB;
 
            EnhancedMode     : in  boolean;
            Widescreen       : in  boolean;
            ColorMode        : in  std_logic_vector(1 downto 0);
+           InfoFrameSet     : in  unsigned(2 downto 0);
            SampleRateHack   : in  boolean;
            Audio            : in  AudioData;
 
-           InfoFrameRAM_Addr: out std_logic_vector(8 downto 0);
+           InfoFrameRAM_Addr: out std_logic_vector(10 downto 0);
            InfoFrameRAM_Data: in  std_logic_vector(8 downto 0);
 
            -- test signals for simulation
@@ -88,6 +92,7 @@ architecture Behavioral of dvid is
 
   signal out_red, out_green, out_blue, out_clock: std_logic_vector(1 downto 0);
   signal shift_clock: std_logic_vector(9 downto 0) := "0000011111";
+  signal acr_rate   : std_logic;
 
   -- input delays
   constant delay_clocks: natural := 11; -- 10 pixels to generate the video preamble plus one bonus for delays
@@ -109,9 +114,9 @@ architecture Behavioral of dvid is
   signal blank_d: std_logic;
 
   -- infoframe ROM signals
-  signal ifr_fulladdr  : unsigned(8 downto 0);
+  signal ifr_fulladdr  : unsigned(10 downto 0);
   signal ifr_addr      : unsigned(4 downto 0) := (others => '0'); -- address counter
-  signal ifr_select    : unsigned(3 downto 0) := (others => '0'); -- group selection
+  signal ifr_select    : unsigned(5 downto 0) := (others => '0'); -- group selection
   signal ifr_send_acr  : boolean := false;
   signal wii_acr       : std_logic := '0';
 
@@ -211,8 +216,10 @@ begin
     end if;
   end process;
 
-  wii_acr <= '1' when ConsoleMode = MODE_WII or SampleRateHack else '0';
-  ifr_fulladdr <= "0" & wii_acr & "00" & ifr_addr when ifr_send_acr
+  -- CTS values for the doubled TMDS clock are in the otherwise empty slot 3
+  wii_acr  <= '1' when ConsoleMode = MODE_WII or SampleRateHack else '0';
+  acr_rate <= '1' when FullRate else '0';
+  ifr_fulladdr <= "000" & wii_acr & acr_rate & acr_rate & ifr_addr when ifr_send_acr
                    else ifr_select & ifr_addr;
 
   -- TMDS
@@ -515,7 +522,7 @@ begin
               ifr_send_acr <= false;
 
             elsif per_frame_packets /= 0 then
-              ifr_select <= "00" & per_frame_packets;
+              ifr_select <= "0000" & per_frame_packets;
             end if;
 
             -- clear audio data
@@ -544,7 +551,8 @@ begin
         per_frame_packets <= to_unsigned(3, 2);
 
         -- choose the packet sequence to send for the current video mode
-        ifr_select <= "10" & unsigned(ColorMode);
+        -- (the set selects a precomputed group of AVI infoframes)
+        ifr_select <= InfoFrameSet & "0" & unsigned(ColorMode);
         if Widescreen then
           ifr_select(2) <= '1';
         end if;
@@ -44,6 +44,7 @@ entity toplevel_gcdual is
     SwapRed      : string := "NO";
     SwapGreen    : string := "NO";
     SwapBlue     : string := "NO";
+    FullRateModes: string := "NO";
     Firmware     : string;
     Module       : string
   );
@@ -125,7 +126,8 @@ begin
   Inst_Datapipe: Datapipe generic map (
     TargetConsole => TargetConsole,
     Firmware      => Firmware,
-    Module        => Module
+    Module        => Module,
+    FullRateModes => FullRateModes = "YES"
   ) port map (
     VClockN     => VClockN,
     VData       => VData,
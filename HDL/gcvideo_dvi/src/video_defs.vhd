@@ -115,9 +115,10 @@ package video_defs is
     CrGFactor: signed(15 downto 0);
   end record;
 
+  -- vertical ranges cover a 4x line multiplied 576i/288p field
   subtype HorizontalPixels is natural range 0 to 880;
-  subtype VerticalPixels is natural range 0 to 880*650;
-  subtype VerticalLines is natural range 0 to 625;
+  subtype VerticalPixels is natural range 0 to 880*1300;
+  subtype VerticalLines is natural range 0 to 1300;
 
   type ReblankerSettings_t is record
     HSyncStart  : HorizontalPixels;
@@ -135,6 +136,7 @@ package video_defs is
     ScanlinesAlternate: boolean;
     ScanlinesEven     : boolean;
     LinedoublerEnabled: boolean;
+    LineMultiplier    : natural range 2 to 4;
     DisableOutput     : boolean;
     CableDetect       : boolean;
     EnhancedMode      : boolean;
@@ -148,6 +150,7 @@ package video_defs is
     SampleRateHack    : boolean;
     InterpolateChroma : boolean;
     ColorMode         : std_logic_vector(1 downto 0);
+    InfoFrameSet      : unsigned(2 downto 0);
     Matrix            : ColorMatrix_t;
     RBSettings        : ReblankerSettings_t;
   end record;
@@ -57,10 +57,12 @@ use work.zpupkg.all;
 entity zpu_core_flex is
   generic (
 	IMPL_MULTIPLY : boolean; -- Self explanatory
+	IMPL_DIVIDE : boolean; -- Include div and mod (multi-cycle)
 	IMPL_COMPARISON_SUB : boolean; -- Include sub and (U)lessthan(orequal)
 	IMPL_EQBRANCH : boolean; -- Include eqbranch and neqbranch
 	IMPL_STOREBH : boolean; -- Include halfword and byte writes
 	IMPL_LOADBH : boolean; -- Include halfword and byte reads
+	IMPL_BRAM_BH : boolean; -- Include halfword and byte reads/writes to BRAM (read-modify-write)
 	IMPL_CALL : boolean; -- Include call
 	IMPL_SHIFT : boolean; -- Include lshiftright, ashiftright and ashiftleft
 	IMPL_XOR : boolean; -- include xor instruction
@@ -156,6 +158,10 @@ architecture behave of zpu_core_flex is
     State_AddSP,
     State_AddSP2,
     State_ReadIODone,
+    State_LoadBRAMBH,
+    State_LoadBRAMBH2,
+    State_StoreBRAMBH,
+    State_StoreBRAMBH2,
     State_Decode,
     State_Resync,
     State_Interrupt,
@@ -164,7 +170,8 @@ architecture behave of zpu_core_flex is
 	 State_EqNeq,
 	 State_Sub,
 	 State_IncSP,
-	 State_Shift
+	 State_Shift,
+	 State_Div
     );
 
   type DecodedOpcodeType is (
@@ -196,7 +203,8 @@ architecture behave of zpu_core_flex is
 	 Decoded_EqNeq,
 	 Decoded_EqBranch,
 	 Decoded_Call,
-	 Decoded_Shift
+	 Decoded_Shift,
+	 Decoded_Div
     );
 
 
@@ -240,6 +248,16 @@ architecture behave of zpu_core_flex is
 
   signal add_low : unsigned(17 downto 0);
 
+  signal bh_offset : unsigned(1 downto 0);  -- byte offset of a BRAM byte/halfword access
+  signal bh_value  : unsigned(15 downto 0); -- data for a BRAM byte/halfword store
+
+  signal div_count   : unsigned(5 downto 0);
+  signal div_quot    : unsigned(31 downto 0); -- shifts in quotient bits while dividend is shifted out
+  signal div_rem     : unsigned(31 downto 0);
+  signal div_divisor : unsigned(31 downto 0);
+  signal div_negquot : std_logic;
+  signal div_negrem  : std_logic;
+
 
   function selectconstant(cond : boolean;
 		int1 : integer;
@@ -286,7 +304,13 @@ begin
   tOpcode_sel <= to_integer(pc(minAddrBit-1 downto 0));
 
 	CodeFromRAM: if EXECUTE_RAM=true generate
-		inrom <='1' when pc(stackBit)='1' else '0';
+		CodeRemapped: if REMAP_STACK=true generate
+			inrom <='1' when pc(stackBit)='1' else '0';
+		end generate;
+		CodeNotRemapped: if REMAP_STACK=false generate
+			-- everything above the BRAM is fetched over the memory bus
+			inrom <='1' when pc(pcmaxbit downto maxAddrBitBRAM+1)=0 else '0';
+		end generate;
 		programword <= memBRead_stdlogic when inrom='1' else mem_read;
 	end generate;
 	CodeFromRAM2: if EXECUTE_RAM=false generate
@@ -333,6 +357,12 @@ begin
       if IMPL_XOR=true and tOpcode(5 downto 0) = OpCode_Xor then
         sampledDecodedOpcode <= Decoded_Xor;
       end if;
+      if IMPL_DIVIDE=true then
+        if tOpcode(5 downto 0) = OpCode_Div
+          or tOpcode(5 downto 0) = OpCode_Mod then
+          sampledDecodedOpcode <= Decoded_Div;
+        end if;
+      end if;
       if IMPL_COMPARISON_SUB=true then
         if tOpcode(5 downto 0) = OpCode_Eq
           or tOpcode(5 downto 0) = OpCode_Neq then
@@ -353,7 +383,7 @@ begin
           sampledDecodedOpcode <= Decoded_EqBranch;
         end if;
       end if;
-      if IMPL_STOREBH=true then
+      if IMPL_STOREBH=true or IMPL_BRAM_BH=true then
         if tOpcode(5 downto 0) = OpCode_StoreB
           or tOpcode(5 downto 0) = OpCode_StoreH then
           sampledDecodedOpcode <= Decoded_StoreBH;
@@ -361,7 +391,7 @@ begin
       end if;
       -- LOADB and LOADH don't do any bitshifting based on address- it's the supporting
       -- SOC's responsibility to make sure the result is in the low order bits.
-      if IMPL_LOADBH=true then
+      if IMPL_LOADBH=true or IMPL_BRAM_BH=true then
         if tOpcode(5 downto 0) = OpCode_LoadB
           or tOpcode(5 downto 0) = OpCode_LoadH then
   --			if tOpcode(5 downto 0) = OpCode_LoadH then -- Disable LoadB for now, since it doesn't yet work.
@@ -667,7 +697,14 @@ begin
              end if;
 
 				 when Decoded_LoadBH =>
-					if REMAP_STACK=true and memARead(stackbit-1)='0' and memARead(stackBit) = '1' then
+					if IMPL_BRAM_BH=true and REMAP_STACK=false and
+						memARead(MaxAddrBit downto maxAddrBitBRAM+1)=to_unsigned(0,MaxAddrBit-maxAddrBitBRAM) then
+						-- Access is bound for stack RAM, read the full word and extract the relevant part
+						memAAddr(AddrBitBRAM_range) <= memARead(AddrBitBRAM_range);
+						bh_offset <= memARead(1 downto 0);
+						state     <= State_LoadBRAMBH;
+					elsif (REMAP_STACK=true and memARead(stackbit-1)='0' and memARead(stackBit) = '1') or
+						IMPL_LOADBH=false then
 					-- We don't try and cope with half or byte reads from Stack RAM so fall back to emulation...
 						sp                             <= sp - 1;
 						memAWriteEnable                <= '1';
@@ -716,7 +753,16 @@ begin
               end if;
 
 				when Decoded_StoreBH =>
-					if REMAP_STACK=true and memARead(stackbit-1)='0' and memARead(stackBit) = '1' then
+					if IMPL_BRAM_BH=true and REMAP_STACK=false and
+						memARead(MaxAddrBit downto maxAddrBitBRAM+1)=to_unsigned(0,MaxAddrBit-maxAddrBitBRAM) then
+						-- Access is bound for stack RAM, read the full word and merge the new data into it
+						memAAddr(AddrBitBRAM_range) <= memARead(AddrBitBRAM_range);
+						bh_offset <= memARead(1 downto 0);
+						bh_value  <= memBRead(15 downto 0);
+						sp        <= sp + 1;
+						state     <= State_StoreBRAMBH;
+					elsif (REMAP_STACK=true and memARead(stackbit-1)='0' and memARead(stackBit) = '1') or
+						IMPL_STOREBH=false then
 						-- We don't try and cope with half or byte reads from Stack RAM so fall back to emulation...
 						sp                             <= sp - 1;
 						memAWriteEnable                <= '1';
@@ -760,6 +806,27 @@ begin
 						state <= State_Shift;
 					end if;
 
+				when Decoded_Div =>
+					if IMPL_DIVIDE=true then
+						-- TOS / NOS, unsigned division of the absolute values
+						sp    <= sp + 1;
+						if memARead(31)='1' then
+							div_quot <= 0 - memARead;
+						else
+							div_quot <= memARead;
+						end if;
+						if memBRead(31)='1' then
+							div_divisor <= 0 - memBRead;
+						else
+							div_divisor <= memBRead;
+						end if;
+						div_rem     <= (others => '0');
+						div_count   <= to_unsigned(32, 6);
+						div_negquot <= memARead(31) xor memBRead(31);
+						div_negrem  <= memARead(31);
+						state <= State_Div;
+					end if;
+
 				when Decoded_Nop =>
               memAAddr(AddrBitBRAM_range) <= sp;
 
@@ -878,6 +945,60 @@ begin
           memBAddr(AddrBitBRAM_range) <= sp + 1;
           state    <= State_Execute;
 
+        when State_LoadBRAMBH =>
+          -- wait for the BRAM read
+          state <= State_LoadBRAMBH2;
+
+        when State_LoadBRAMBH2 =>
+          if IMPL_BRAM_BH=true then
+            -- big endian: offset 0 is the most significant byte
+            memAAddr(AddrBitBRAM_range) <= sp;
+            memAWriteEnable <= '1';
+            memAWrite       <= (others => '0');
+            if opcode_saved(0)='1' then -- loadb is opcode 51
+              case bh_offset is
+                when "00"   => memAWrite(7 downto 0) <= memARead(31 downto 24);
+                when "01"   => memAWrite(7 downto 0) <= memARead(23 downto 16);
+                when "10"   => memAWrite(7 downto 0) <= memARead(15 downto  8);
+                when others => memAWrite(7 downto 0) <= memARead( 7 downto  0);
+              end case;
+            else                        -- loadh is opcode 34
+              if bh_offset(1)='0' then
+                memAWrite(15 downto 0) <= memARead(31 downto 16);
+              else
+                memAWrite(15 downto 0) <= memARead(15 downto  0);
+              end if;
+            end if;
+          end if;
+          state <= State_Fetch;
+
+        when State_StoreBRAMBH =>
+          -- wait for the BRAM read, drop the data word from the stack
+          sp    <= sp + 1;
+          state <= State_StoreBRAMBH2;
+
+        when State_StoreBRAMBH2 =>
+          if IMPL_BRAM_BH=true then
+            -- memAAddr still points to the target word
+            memAWriteEnable <= '1';
+            memAWrite       <= memARead;
+            if opcode_saved(0)='0' then -- storeb is opcode 52
+              case bh_offset is
+                when "00"   => memAWrite(31 downto 24) <= bh_value(7 downto 0);
+                when "01"   => memAWrite(23 downto 16) <= bh_value(7 downto 0);
+                when "10"   => memAWrite(15 downto  8) <= bh_value(7 downto 0);
+                when others => memAWrite( 7 downto  0) <= bh_value(7 downto 0);
+              end case;
+            else                        -- storeh is opcode 35
+              if bh_offset(1)='0' then
+                memAWrite(31 downto 16) <= bh_value;
+              else
+                memAWrite(15 downto  0) <= bh_value;
+              end if;
+            end if;
+          end if;
+          state <= State_Resync;
+
         when State_Store =>
           sp              <= sp + 1;
           memAWriteEnable <= '1';
@@ -965,6 +1086,38 @@ begin
 					state           <= State_Fetch;
 				end if;
 
+			when State_Div =>
+				if IMPL_DIVIDE=true then
+					if div_count /= 0 then
+						-- one bit of restoring division per cycle
+						if (div_rem(30 downto 0) & div_quot(31)) >= div_divisor then
+							div_rem  <= (div_rem(30 downto 0) & div_quot(31)) - div_divisor;
+							div_quot <= div_quot(30 downto 0) & '1';
+						else
+							div_rem  <= div_rem(30 downto 0) & div_quot(31);
+							div_quot <= div_quot(30 downto 0) & '0';
+						end if;
+						div_count <= div_count - 1;
+					else
+						memAAddr(AddrBitBRAM_range) <= sp;
+						memAWriteEnable <= '1';
+						if opcode_saved(0)='1' then -- div is opcode 53
+							if div_negquot='1' then
+								memAWrite <= 0 - div_quot;
+							else
+								memAWrite <= div_quot;
+							end if;
+						else                        -- mod is opcode 54
+							if div_negrem='1' then
+								memAWrite <= 0 - div_rem;
+							else
+								memAWrite <= div_rem;
+							end if;
+						end if;
+						state <= State_Fetch;
+					end if;
+				end if;
+
         when others =>
           null;
 
@@ -105,10 +105,12 @@ package zpupkg is
   component zpu_core_flex is
   generic (
     IMPL_MULTIPLY : boolean := true; -- Self explanatory
+	 IMPL_DIVIDE : boolean := false; -- Include div and mod (multi-cycle)
 	 IMPL_COMPARISON_SUB : boolean := true; -- Include sub and (U)lessthan(orequal)
 	 IMPL_EQBRANCH : boolean := true; -- Include eqbranch and neqbranch
 	 IMPL_STOREBH : boolean := true; -- Include halfword and byte writes
 	 IMPL_LOADBH : boolean := true; -- Include halfword and byte reads
+	 IMPL_BRAM_BH : boolean := false; -- Include halfword and byte reads/writes to BRAM (read-modify-write)
 	 IMPL_CALL : boolean := true; -- Include call
 	 IMPL_SHIFT : boolean := true; -- Include lshiftright, ashiftright and ashiftleft
 	 IMPL_XOR : boolean := true; -- include xor instruction
@@ -196,6 +198,8 @@ package zpupkg is
   --
   constant OpCode_Loadb            : std_logic_vector(5 downto 0) := std_logic_vector(to_unsigned(51, 6));
   constant OpCode_Storeb           : std_logic_vector(5 downto 0) := std_logic_vector(to_unsigned(52, 6));
+  constant OpCode_Div              : std_logic_vector(5 downto 0) := std_logic_vector(to_unsigned(53, 6));
+  constant OpCode_Mod              : std_logic_vector(5 downto 0) := std_logic_vector(to_unsigned(54, 6));
   --
   constant OpCode_Eqbranch         : std_logic_vector(5 downto 0) := std_logic_vector(to_unsigned(55, 6));
   constant OpCode_Neqbranch        : std_logic_vector(5 downto 0) := std_logic_vector(to_unsigned(56, 6));